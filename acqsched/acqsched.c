@@ -0,0 +1,289 @@
+
+/* ===== INCLUDES =========================================================== */
+
+#include "acqsched.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/* ===== DEFINITIONS ======================================================== */
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static void _release(acqsched_task_t* task, uint64_t now);
+static acqsched_task_t* _pick(acqsched_t* sched, uint64_t now);
+static int64_t _action_deadline(const acqsched_task_t* task);
+static void _run(acqsched_t* sched, acqsched_task_t* task);
+static void _collected(acqsched_task_t* task, uint64_t end);
+static void _asleep(acqsched_task_t* task, uint64_t end);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+void acqsched_init(acqsched_t* sched, acqsched_get_us_t get_us)
+{
+    memset(sched, 0, sizeof(*sched));
+
+    sched->get_us     = get_us;
+    sched->started_us = get_us();
+}
+
+int acqsched_add(acqsched_t* sched, acqsched_task_t* task)
+{
+    if ((task->collect == NULL) || (task->period_us == 0))
+    {
+        return 1;
+    }
+
+    task->state      = ACQSCHED_TASK_IDLE;
+    task->release_us = sched->get_us();
+    task->collect_us = 0;
+    memset(&task->stats, 0, sizeof(task->stats));
+
+    task->next   = sched->tasks;
+    sched->tasks = task;
+
+    return 0;
+}
+
+uint32_t acqsched_poll(acqsched_t* sched)
+{
+    uint64_t now = sched->get_us();
+    uint64_t wake;
+    uint32_t budget = 0;
+    acqsched_task_t* task;
+
+    for (task = sched->tasks; task != NULL; task = task->next)
+    {
+        budget += 2;
+    }
+
+    // bounded so an overloaded bus still returns to the caller
+    while ((budget-- != 0) && ((task = _pick(sched, now)) != NULL))
+    {
+        _run(sched, task);
+        now = sched->get_us();
+    }
+
+    wake = UINT64_MAX;
+    for (task = sched->tasks; task != NULL; task = task->next)
+    {
+        uint64_t at = task->ready_us;
+
+        if (task->state == ACQSCHED_TASK_IDLE)
+        {
+            at = task->release_us;
+        }
+
+        if (at < wake)
+        {
+            wake = at;
+        }
+    }
+
+    if (wake <= now)
+    {
+        return 0;
+    }
+
+    return ((wake - now) > UINT32_MAX) ? UINT32_MAX : (uint32_t)(wake - now);
+}
+
+void acqsched_get_stats(const acqsched_t* sched, acqsched_stats_t* stats)
+{
+    stats->elapsed_us = sched->get_us() - sched->started_us;
+    stats->busy_us    = sched->busy_us;
+    stats->actions    = sched->actions;
+}
+
+float acqsched_task_rate_hz(const acqsched_t* sched, const acqsched_task_t* task)
+{
+    uint64_t elapsed = sched->get_us() - sched->started_us;
+
+    return (elapsed == 0) ? 0.0f : (float)task->stats.samples * 1e6f / (float)elapsed;
+}
+
+float acqsched_task_duty(const acqsched_t* sched, const acqsched_task_t* task)
+{
+    uint64_t elapsed = sched->get_us() - sched->started_us;
+
+    return (elapsed == 0) ? 0.0f : (float)task->stats.awake_us / (float)elapsed;
+}
+
+float acqsched_bus_utilisation(const acqsched_t* sched)
+{
+    uint64_t elapsed = sched->get_us() - sched->started_us;
+
+    return (elapsed == 0) ? 0.0f : (float)sched->busy_us / (float)elapsed;
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static void _release(acqsched_task_t* task, uint64_t now)
+{
+    uint64_t skipped = (now - task->release_us) / task->period_us;
+
+    if (task->state != ACQSCHED_TASK_IDLE)
+    {
+        // previous sample still pending, this release is an overrun
+        task->stats.misses += skipped + 1;
+        task->release_us += (skipped + 1) * task->period_us;
+        return;
+    }
+
+    task->stats.misses += skipped;
+    task->release_us += skipped * task->period_us;
+
+    task->deadline_us = task->release_us + task->period_us;
+    task->release_us  = task->deadline_us;
+    task->ready_us    = now;
+    task->state       = (task->start != NULL) ? ACQSCHED_TASK_START : ACQSCHED_TASK_COLLECT;
+}
+
+static acqsched_task_t* _pick(acqsched_t* sched, uint64_t now)
+{
+    acqsched_task_t* best = NULL;
+    int64_t best_deadline = INT64_MAX;
+
+    for (acqsched_task_t* task = sched->tasks; task != NULL; task = task->next)
+    {
+        if (now >= task->release_us)
+        {
+            _release(task, now);
+        }
+
+        if ((task->state == ACQSCHED_TASK_IDLE) || (now < task->ready_us))
+        {
+            continue;
+        }
+
+        int64_t deadline = _action_deadline(task);
+        if (deadline < best_deadline)
+        {
+            best          = task;
+            best_deadline = deadline;
+        }
+    }
+
+    return best;
+}
+
+static int64_t _action_deadline(const acqsched_task_t* task)
+{
+    int64_t deadline = (int64_t)task->deadline_us;
+
+    switch (task->state)
+    {
+        case ACQSCHED_TASK_START:
+            return deadline - task->conv_us - task->collect_us;
+        default:
+            return deadline;
+    }
+}
+
+static void _run(acqsched_t* sched, acqsched_task_t* task)
+{
+    uint64_t begin  = sched->get_us();
+    bool cycle_done = false;
+    uint64_t end;
+    int res;
+
+    // the first phase of a cycle wakes the device
+    if ((task->state == ACQSCHED_TASK_START) || ((task->state == ACQSCHED_TASK_COLLECT) && (task->start == NULL)))
+    {
+        task->awake_since_us = begin;
+    }
+
+    switch (task->state)
+    {
+        case ACQSCHED_TASK_START:
+            res = task->start(task->ctx);
+            end = sched->get_us();
+
+            task->state    = ACQSCHED_TASK_COLLECT;
+            task->ready_us = end + task->conv_us;
+            cycle_done     = (res != 0);
+            break;
+
+        case ACQSCHED_TASK_COLLECT:
+            res = task->collect(task->ctx);
+            end = sched->get_us();
+
+            if ((end - begin) > task->collect_us)
+            {
+                task->collect_us = (uint32_t)(end - begin);
+            }
+
+            // conv_us is nominal, a result that is not ready yet is polled again while the deadline allows it
+            if ((res > 0) && (end + ACQSCHED_REPOLL_US + task->collect_us <= task->deadline_us))
+            {
+                task->ready_us = end + ACQSCHED_REPOLL_US;
+                res            = 0;
+                break;
+            }
+
+            if (res == 0)
+            {
+                _collected(task, end);
+            }
+            else if (res > 0)
+            {
+                task->stats.misses++;
+                res = 0;
+            }
+            cycle_done = true;
+            break;
+
+        default:
+            res = task->sleep(task->ctx);
+            end = sched->get_us();
+
+            _asleep(task, end);
+            break;
+    }
+
+    if (res != 0)
+    {
+        task->stats.errors++;
+    }
+
+    // a failed start ends the cycle as well, the device goes back to sleep either way
+    if (cycle_done)
+    {
+        if (task->sleep != NULL)
+        {
+            task->state    = ACQSCHED_TASK_SLEEP;
+            task->ready_us = end;
+        }
+        else
+        {
+            _asleep(task, end);
+        }
+    }
+
+    sched->busy_us += end - begin;
+    sched->actions++;
+}
+
+static void _collected(acqsched_task_t* task, uint64_t end)
+{
+    task->stats.samples++;
+
+    if (end > task->deadline_us)
+    {
+        uint64_t lateness = end - task->deadline_us;
+
+        task->stats.misses++;
+        if (lateness > task->stats.lateness_max_us)
+        {
+            task->stats.lateness_max_us = (lateness > UINT32_MAX) ? UINT32_MAX : (uint32_t)lateness;
+        }
+    }
+}
+
+static void _asleep(acqsched_task_t* task, uint64_t end)
+{
+    task->stats.awake_us += end - task->awake_since_us;
+    task->state = ACQSCHED_TASK_IDLE;
+}
@@ -0,0 +1,116 @@
+#ifndef __ACQSCHED_H__
+#define __ACQSCHED_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define ACQSCHED_REPOLL_US (500) //! collect retry step while the result is not ready
+
+/* ===== TYPES ============================================================== */
+
+/*
+ * Returns 0 on success, a failed phase drops the current sample. A collect phase
+ * returns a positive value while the result is not ready yet and is retried every
+ * ACQSCHED_REPOLL_US up to the sample deadline; only negative (bus) results count
+ * as errors there.
+ */
+typedef int (*acqsched_phase_t)(void* ctx);
+
+typedef uint64_t (*acqsched_get_us_t)(void);
+
+typedef enum
+{
+    ACQSCHED_TASK_IDLE,  //! waiting for the next release
+    ACQSCHED_TASK_START, //! phase that runs next, once ready_us is reached
+    ACQSCHED_TASK_COLLECT,
+    ACQSCHED_TASK_SLEEP,
+} acqsched_task_state_t;
+
+typedef struct
+{
+    uint64_t samples;
+    uint64_t misses; //! samples collected after or not ready by their deadline, releases dropped by an overrun
+    uint64_t errors;
+    uint64_t awake_us; //! from the start (or collect) phase to the sleep (or collect) phase
+    uint32_t lateness_max_us;
+} acqsched_task_stats_t;
+
+/*
+ * Periodic acquisition of one device. A sample is released every period_us and
+ * has to be collected before the next release. The conversion time comes from
+ * the driver, e.g. si7006_get_conversion_time_ms(), ds18b20_get_conversion_time_ms(),
+ * ina226_calc_conversion_time_us() or tsl2591_calc_integr_time_ms(). Devices
+ * converting on their own (continuous modes) have no start phase.
+ *
+ * Devices kept in a low-power state between samples get a sleep phase right
+ * after the collection. Their start phase wakes them and triggers the conversion
+ * in one write, so conv_us includes the power-up time. See power.h for the
+ * drivers.
+ */
+typedef struct acqsched_task acqsched_task_t;
+
+struct acqsched_task
+{
+    acqsched_phase_t start; //! optional, e.g. si7006_nohold_start() or ds18b20_start_convertion()
+    acqsched_phase_t collect;
+    acqsched_phase_t sleep; //! optional, also runs when start or collect failed
+    void* ctx;
+    uint32_t period_us;
+    uint32_t conv_us;
+
+    acqsched_task_t* next;
+    uint8_t state; //! \ref acqsched_task_state_t
+    uint64_t release_us;
+    uint64_t deadline_us;
+    uint64_t ready_us;
+    uint64_t awake_since_us;
+    uint32_t collect_us; //! longest collect phase seen, reserved when starting
+    acqsched_task_stats_t stats;
+};
+
+typedef struct
+{
+    uint64_t elapsed_us;
+    uint64_t busy_us; //! time spent inside the phases
+    uint64_t actions;
+} acqsched_stats_t;
+
+/*
+ * Earliest-deadline-first scheduler for the devices of one bus. The deadline of a
+ * start is the latest moment that still leaves the conversion and the collection
+ * before the sample deadline, so conversions are started as early as needed and
+ * other devices are served while they run. Buses served by separate threads get
+ * one scheduler each.
+ */
+typedef struct
+{
+    acqsched_task_t* tasks;
+    acqsched_get_us_t get_us;
+    uint64_t started_us;
+    uint64_t busy_us;
+    uint64_t actions;
+} acqsched_t;
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+void acqsched_init(acqsched_t* sched, acqsched_get_us_t get_us);
+//! The first sample is released immediately, the task must not move while added
+int acqsched_add(acqsched_t* sched, acqsched_task_t* task);
+
+//! Runs the due phases, returns the time in microseconds until the next one, 0 when more are due
+uint32_t acqsched_poll(acqsched_t* sched);
+
+void acqsched_get_stats(const acqsched_t* sched, acqsched_stats_t* stats);
+//! Collected samples per second since acqsched_init()
+float acqsched_task_rate_hz(const acqsched_t* sched, const acqsched_task_t* task);
+//! Share of the elapsed time the device was awake, see acqsched_task_stats_t
+float acqsched_task_duty(const acqsched_t* sched, const acqsched_task_t* task);
+//! Share of the elapsed time the bus was driven by the phases
+float acqsched_bus_utilisation(const acqsched_t* sched);
+
+#endif /* __ACQSCHED_H__ */
@@ -0,0 +1,292 @@
+
+/* ===== INCLUDES =========================================================== */
+
+#include "async.h"
+
+#include <string.h>
+
+/* ===== DEFINITIONS ======================================================== */
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static async_op_t* _next_op(async_bus_t* bus);
+static bool _park(async_bus_t* bus, async_op_t* op);
+static bool _has_parked(async_bus_t* bus);
+static void _finish(async_bus_t* bus, async_op_t* op, int res);
+static void _complete(void* arg, int res);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+int async_bus_init(async_bus_t* bus, async_op_t** queue, uint16_t capacity, async_get_ms_t get_ms)
+{
+    if ((capacity == 0) || (capacity > 32768) || ((capacity & (capacity - 1)) != 0))
+    {
+        return 1;
+    }
+
+    memset(bus, 0, sizeof(*bus));
+
+    bus->queue  = queue;
+    bus->mask   = capacity - 1;
+    bus->get_ms = get_ms;
+    atomic_init(&bus->head, 0);
+    atomic_init(&bus->tail, 0);
+    atomic_init(&bus->completed, false);
+
+    return 0;
+}
+
+int async_submit(async_bus_t* bus, async_op_t* op)
+{
+    uint16_t head = atomic_load_explicit(&bus->head, memory_order_relaxed);
+    uint16_t tail = atomic_load_explicit(&bus->tail, memory_order_acquire);
+
+    if ((uint16_t)(head - tail) > bus->mask)
+    {
+        return 1;
+    }
+
+    op->step = 0;
+
+    bus->queue[head & bus->mask] = op;
+    atomic_store_explicit(&bus->head, (uint16_t)(head + 1), memory_order_release);
+
+    return 0;
+}
+
+bool async_poll(async_bus_t* bus)
+{
+    for (;;)
+    {
+        async_op_t* op = bus->inflight;
+
+        if (op != NULL)
+        {
+            if (!atomic_load_explicit(&bus->completed, memory_order_acquire))
+            {
+                return true;
+            }
+
+            bus->inflight = NULL;
+
+            if (bus->inflight_res != 0)
+            {
+                _finish(bus, op, bus->inflight_res);
+                continue;
+            }
+        }
+        else
+        {
+            op = _next_op(bus);
+            if (op == NULL)
+            {
+                return _has_parked(bus) || (bus->waiting != NULL);
+            }
+        }
+
+        if ((op->step < op->count) && (op->steps[op->step].type == ASYNC_STEP_WAIT))
+        {
+            op->wake_ms = bus->get_ms() + op->steps[op->step].size;
+            op->step++;
+
+            // Without a free slot the queue is held back until the op resumes, see _next_op()
+            if (!_park(bus, op))
+            {
+                bus->waiting = op;
+            }
+            continue;
+        }
+
+        if (op->step == op->count)
+        {
+            _finish(bus, op, 0);
+            continue;
+        }
+
+        // Everything up to the end of the transaction goes out as one transfer
+        size_t count = 0;
+        while (op->step < op->count)
+        {
+            async_step_t* step = &op->steps[op->step];
+
+            if (step->type == ASYNC_STEP_WAIT)
+            {
+                break;
+            }
+
+            bus->segs[count++] = (transport_seg_t){
+                .data  = step->data,
+                .size  = step->size,
+                .flags = step->flags | ((step->type == ASYNC_STEP_READ) ? TRANSPORT_FLAG_READ : 0),
+            };
+            op->step++;
+
+            if (step->flags & TRANSPORT_FLAG_LAST)
+            {
+                break;
+            }
+        }
+
+        bus->inflight = op;
+        bus->transactions++;
+        atomic_store_explicit(&bus->completed, false, memory_order_relaxed);
+
+        int res = transport_submit(op->transport, bus->segs, count, _complete, bus);
+        if (res != 0)
+        {
+            bus->inflight = NULL;
+            _finish(bus, op, res);
+        }
+    }
+}
+
+void async_op_init(async_op_t* op, const transport_t* transport, async_done_t done, void* arg)
+{
+    memset(op, 0, sizeof(*op));
+
+    op->transport = transport;
+    op->done      = done;
+    op->arg       = arg;
+}
+
+int async_op_add(async_op_t* op, async_step_type_t type, void* data, uint16_t size, uint8_t flags)
+{
+    if (op->count == ASYNC_MAX_STEPS)
+    {
+        return 1;
+    }
+
+    op->steps[op->count++] = (async_step_t){
+        .type  = type,
+        .flags = flags,
+        .size  = size,
+        .data  = data,
+    };
+
+    return 0;
+}
+
+int async_op_reg_read(async_op_t* op, uint8_t reg, void* data, uint16_t size)
+{
+    op->buf[0] = reg;
+
+    if (async_op_add(op, ASYNC_STEP_WRITE, &op->buf[0], 1, 0) != 0)
+    {
+        return 1;
+    }
+
+    return async_op_add(op, ASYNC_STEP_READ, data, size, TRANSPORT_FLAG_LAST);
+}
+
+int async_op_reg_write(async_op_t* op, uint8_t reg, const void* data, uint16_t size)
+{
+    op->buf[0] = reg;
+
+    if (async_op_add(op, ASYNC_STEP_WRITE, &op->buf[0], 1, 0) != 0)
+    {
+        return 1;
+    }
+
+    return async_op_add(op, ASYNC_STEP_WRITE, (void*)data, size, TRANSPORT_FLAG_LAST);
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static async_op_t* _next_op(async_bus_t* bus)
+{
+    uint32_t now = bus->get_ms();
+
+    // Operations coming back from a wait go first to keep their latency bounded
+    for (uint8_t i = 0; i < ASYNC_MAX_PARKED; i++)
+    {
+        async_op_t* op = bus->parked[i];
+
+        if ((op != NULL) && ((int32_t)(now - op->wake_ms) >= 0))
+        {
+            bus->parked[i] = NULL;
+            return op;
+        }
+    }
+
+    if (bus->waiting != NULL)
+    {
+        async_op_t* op = bus->waiting;
+
+        if ((int32_t)(now - op->wake_ms) < 0)
+        {
+            return NULL;
+        }
+
+        bus->waiting = NULL;
+        return op;
+    }
+
+    uint16_t tail = atomic_load_explicit(&bus->tail, memory_order_relaxed);
+    uint16_t head = atomic_load_explicit(&bus->head, memory_order_acquire);
+
+    if (head == tail)
+    {
+        return NULL;
+    }
+
+    async_op_t* op = bus->queue[tail & bus->mask];
+    atomic_store_explicit(&bus->tail, (uint16_t)(tail + 1), memory_order_release);
+
+    return op;
+}
+
+static bool _park(async_bus_t* bus, async_op_t* op)
+{
+    for (uint8_t i = 0; i < ASYNC_MAX_PARKED; i++)
+    {
+        if (bus->parked[i] == NULL)
+        {
+            bus->parked[i] = op;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool _has_parked(async_bus_t* bus)
+{
+    for (uint8_t i = 0; i < ASYNC_MAX_PARKED; i++)
+    {
+        if (bus->parked[i] != NULL)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void _finish(async_bus_t* bus, async_op_t* op, int res)
+{
+    bus->ops++;
+
+    if (res != 0)
+    {
+        bus->errors++;
+    }
+    else if (op->decode != NULL)
+    {
+        res = op->decode(op);
+    }
+
+    if (op->done != NULL)
+    {
+        op->done(op, res);
+    }
+}
+
+static void _complete(void* arg, int res)
+{
+    async_bus_t* bus = arg;
+
+    bus->inflight_res = res;
+    atomic_store_explicit(&bus->completed, true, memory_order_release);
+}
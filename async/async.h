@@ -0,0 +1,105 @@
+#ifndef __ASYNC_H__
+#define __ASYNC_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "transport.h"
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define ASYNC_MAX_STEPS  (6)
+#define ASYNC_BUF_SIZE   (8)
+#define ASYNC_MAX_PARKED (8)
+
+/* ===== TYPES ============================================================== */
+
+typedef enum
+{
+    ASYNC_STEP_WRITE,
+    ASYNC_STEP_READ,
+    ASYNC_STEP_WAIT, //! size is the delay in milliseconds, the bus serves other operations meanwhile
+} async_step_type_t;
+
+typedef struct
+{
+    uint8_t type;  //! \ref async_step_type_t
+    uint8_t flags; //! TRANSPORT_FLAG_LAST ends a transaction
+    uint16_t size;
+    void* data;
+} async_step_t;
+
+typedef struct async_op async_op_t;
+
+typedef int (*async_decode_t)(async_op_t* op);
+typedef void (*async_done_t)(async_op_t* op, int res);
+
+/*
+ * Driver operation encoded as a list of steps. Operations are owned by the caller
+ * and must neither move nor be reused until their completion callback has run.
+ */
+struct async_op
+{
+    const transport_t* transport;
+    async_step_t steps[ASYNC_MAX_STEPS];
+    uint8_t count;
+    uint8_t step;
+    uint8_t buf[ASYNC_BUF_SIZE]; //! inline storage for command bytes and raw results
+    uint32_t wake_ms;
+
+    async_decode_t decode; //! turns the raw data into the result, runs before done, non-zero is passed on to it
+    async_done_t done;
+    void* driver;
+    void* result;
+    void* arg;
+};
+
+typedef uint32_t (*async_get_ms_t)(void);
+
+/*
+ * Per-bus executor. async_submit() and async_poll() may run in different threads
+ * (one each), transactions are started from async_poll() only. With a transport
+ * that implements submit, completions may arrive from interrupt context.
+ */
+typedef struct
+{
+    async_op_t** queue;
+    uint16_t mask;
+    atomic_uint_least16_t head;
+    atomic_uint_least16_t tail;
+
+    async_op_t* parked[ASYNC_MAX_PARKED];
+    async_op_t* waiting; //! in a wait without a parked slot, no new op starts until it resumes
+    async_op_t* inflight;
+    atomic_bool completed;
+    int inflight_res;
+    transport_seg_t segs[ASYNC_MAX_STEPS];
+
+    async_get_ms_t get_ms;
+
+    uint32_t ops;
+    uint32_t transactions;
+    uint32_t errors;
+} async_bus_t;
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+//! Capacity must be a power of two not greater than 32768
+int async_bus_init(async_bus_t* bus, async_op_t** queue, uint16_t capacity, async_get_ms_t get_ms);
+//! Returns 1 when the queue is full
+int async_submit(async_bus_t* bus, async_op_t* op);
+//! Runs as much as possible without blocking, returns true while work is pending
+bool async_poll(async_bus_t* bus);
+
+void async_op_init(async_op_t* op, const transport_t* transport, async_done_t done, void* arg);
+//! Appends a step, returns 1 when the descriptor is full
+int async_op_add(async_op_t* op, async_step_type_t type, void* data, uint16_t size, uint8_t flags);
+
+int async_op_reg_read(async_op_t* op, uint8_t reg, void* data, uint16_t size);
+int async_op_reg_write(async_op_t* op, uint8_t reg, const void* data, uint16_t size);
+
+#endif /* __ASYNC_H__ */
@@ -0,0 +1,183 @@
+
+/* ===== INCLUDES =========================================================== */
+
+#include "async_ops.h"
+
+/* ===== DEFINITIONS ======================================================== */
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static int _si7006_measure(async_op_t* op, si7006_driver_t* self, uint16_t* result, uint8_t cmd, bool is_rh);
+static int _decode_ina226_power(async_op_t* op);
+static int _decode_be16(async_op_t* op);
+static int _decode_tsl2591_sample(async_op_t* op);
+static int _decode_vcnl4000_values(async_op_t* op);
+static int _decode_vcnl4010_values(async_op_t* op);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+int async_op_ina226_get_power(async_op_t* op, ina226_handle_t* handle, async_ina226_power_t* result)
+{
+    int res;
+
+    op->transport = handle->transport;
+    op->driver    = handle;
+    op->result    = result;
+    op->decode    = _decode_ina226_power;
+
+    op->buf[0] = INA226_REG_SHUNT_VOLTAGE;
+    op->buf[3] = INA226_REG_BUS_VOLTAGE;
+
+    res = async_op_add(op, ASYNC_STEP_WRITE, &op->buf[0], 1, 0);
+    res |= async_op_add(op, ASYNC_STEP_READ, &op->buf[1], 2, TRANSPORT_FLAG_LAST);
+    res |= async_op_add(op, ASYNC_STEP_WRITE, &op->buf[3], 1, 0);
+    res |= async_op_add(op, ASYNC_STEP_READ, &op->buf[4], 2, TRANSPORT_FLAG_LAST);
+
+    return res;
+}
+
+int async_op_si7006_measure_rh(async_op_t* op, si7006_driver_t* self, uint16_t* result)
+{
+    return _si7006_measure(op, self, result, SI7006_CMD_NOHOLD_MEASURE_RH, true);
+}
+
+int async_op_si7006_measure_temp(async_op_t* op, si7006_driver_t* self, uint16_t* result)
+{
+    return _si7006_measure(op, self, result, SI7006_CMD_NOHOLD_MEASURE_TEMP, false);
+}
+
+int async_op_tsl2591_read_sample(async_op_t* op, tsl2591_driver_t* self, tsl2591_sample_t* result)
+{
+    op->transport = self->transport;
+    op->driver    = self;
+    op->result    = result;
+    op->decode    = _decode_tsl2591_sample;
+
+    return async_op_reg_read(op, TSL2591_CMD_NORMAL | TSL2591_REG_STATUS, &op->buf[1], 5);
+}
+
+int async_op_vcnl4000_read_values(async_op_t* op, vcnl4000_driver_t* self, vcnl4000_values_t* result)
+{
+    op->transport = self->transport;
+    op->driver    = self;
+    op->result    = result;
+    op->decode    = _decode_vcnl4000_values;
+
+    return async_op_reg_read(op, VCNL4000_REG_ALIGHT_RESULT_H, &op->buf[1], 4);
+}
+
+int async_op_vcnl4010_read_values(async_op_t* op, vcnl4010_driver_t* self, vcnl4010_values_t* result)
+{
+    op->transport = self->transport;
+    op->driver    = self;
+    op->result    = result;
+    op->decode    = _decode_vcnl4010_values;
+
+    return async_op_reg_read(op, VCNL4010_REG_ALIGHT_RESULT_H, &op->buf[1], 4);
+}
+
+int async_op_mc24xx_read_data(async_op_t* op, mc24xx_driver_t* self, uint16_t address, void* data, uint16_t size)
+{
+    int res;
+
+    op->transport = self->transport;
+    op->driver    = self;
+    op->buf[0]    = (uint8_t)(address >> 8);
+    op->buf[1]    = (uint8_t)address;
+
+    res = async_op_add(op, ASYNC_STEP_WRITE, &op->buf[0], 2, 0);
+    res |= async_op_add(op, ASYNC_STEP_READ, data, size, TRANSPORT_FLAG_LAST);
+
+    return res;
+}
+
+int async_op_mc24xx_write_data(async_op_t* op,
+                               mc24xx_driver_t* self,
+                               uint16_t address,
+                               const void* data,
+                               uint16_t size)
+{
+    int res;
+
+    op->transport = self->transport;
+    op->driver    = self;
+    op->buf[0]    = (uint8_t)(address >> 8);
+    op->buf[1]    = (uint8_t)address;
+
+    res = async_op_add(op, ASYNC_STEP_WRITE, &op->buf[0], 2, 0);
+    res |= async_op_add(op, ASYNC_STEP_WRITE, (void*)data, size, TRANSPORT_FLAG_LAST);
+    res |= async_op_add(op, ASYNC_STEP_WAIT, NULL, MC24XX_WRITE_CYCLE_MS, 0);
+
+    return res;
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static int _si7006_measure(async_op_t* op, si7006_driver_t* self, uint16_t* result, uint8_t cmd, bool is_rh)
+{
+    int res;
+
+    op->transport = self->transport;
+    op->driver    = self;
+    op->result    = result;
+    op->decode    = _decode_be16;
+    op->buf[0]    = cmd;
+
+    // No hold master mode, the bus is released during the conversion
+    res = async_op_add(op, ASYNC_STEP_WRITE, &op->buf[0], 1, TRANSPORT_FLAG_LAST);
+    res |= async_op_add(op, ASYNC_STEP_WAIT, NULL, si7006_get_conversion_time_ms(self, is_rh), 0);
+    res |= async_op_add(op, ASYNC_STEP_READ, &op->buf[1], 2, TRANSPORT_FLAG_LAST);
+
+    return res;
+}
+
+static int _decode_ina226_power(async_op_t* op)
+{
+    async_ina226_power_t* result = op->result;
+    int16_t raw_shunt            = (int16_t)(((uint16_t)op->buf[1] << 8) | op->buf[2]);
+    uint16_t raw_vbus            = ((uint16_t)op->buf[4] << 8) | op->buf[5];
+
+    ina226_calc_power(op->driver, raw_shunt, raw_vbus, &result->power, &result->voltage, &result->current);
+
+    return 0;
+}
+
+static int _decode_be16(async_op_t* op)
+{
+    *(uint16_t*)op->result = ((uint16_t)op->buf[1] << 8) | op->buf[2];
+
+    return 0;
+}
+
+static int _decode_tsl2591_sample(async_op_t* op)
+{
+    tsl2591_sample_t* result = op->result;
+
+    result->status = tsl2591_status_from_raw(op->buf[1]);
+    result->ch0 = (uint16_t)op->buf[2] | ((uint16_t)op->buf[3] << 8);
+    result->ch1 = (uint16_t)op->buf[4] | ((uint16_t)op->buf[5] << 8);
+
+    return result->status.valid ? 0 : 1;
+}
+
+static int _decode_vcnl4000_values(async_op_t* op)
+{
+    vcnl4000_values_t* result = op->result;
+
+    result->alight = ((uint16_t)op->buf[1] << 8) | op->buf[2];
+    result->prox   = ((uint16_t)op->buf[3] << 8) | op->buf[4];
+
+    return 0;
+}
+
+static int _decode_vcnl4010_values(async_op_t* op)
+{
+    vcnl4010_values_t* result = op->result;
+
+    result->alight = ((uint16_t)op->buf[1] << 8) | op->buf[2];
+    result->prox   = ((uint16_t)op->buf[3] << 8) | op->buf[4];
+
+    return 0;
+}
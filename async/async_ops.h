@@ -0,0 +1,48 @@
+#ifndef __ASYNC_OPS_H__
+#define __ASYNC_OPS_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include "async.h"
+#include "ina226.h"
+#include "mc24xx.h"
+#include "si7006.h"
+#include "tsl2591.h"
+#include "vcnl4000.h"
+#include "vcnl4010.h"
+
+/* ===== DEFINITIONS ======================================================== */
+/* ===== TYPES ============================================================== */
+
+typedef struct
+{
+    float power;
+    float voltage;
+    float current;
+} async_ina226_power_t;
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+/*
+ * Builders encoding driver operations as async descriptors. The driver has to be
+ * bound to a transport, the op must be initialised with async_op_init() and the
+ * result is valid once the completion callback reports success.
+ */
+
+int async_op_ina226_get_power(async_op_t* op, ina226_handle_t* handle, async_ina226_power_t* result);
+int async_op_si7006_measure_rh(async_op_t* op, si7006_driver_t* self, uint16_t* result);
+int async_op_si7006_measure_temp(async_op_t* op, si7006_driver_t* self, uint16_t* result);
+//! Completes with 1 like tsl2591_read_sample() when the sample is not valid, the result is decoded anyway
+int async_op_tsl2591_read_sample(async_op_t* op, tsl2591_driver_t* self, tsl2591_sample_t* result);
+int async_op_vcnl4000_read_values(async_op_t* op, vcnl4000_driver_t* self, vcnl4000_values_t* result);
+int async_op_vcnl4010_read_values(async_op_t* op, vcnl4010_driver_t* self, vcnl4010_values_t* result);
+int async_op_mc24xx_read_data(async_op_t* op, mc24xx_driver_t* self, uint16_t address, void* data, uint16_t size);
+//! Includes the write cycle time, further operations on the EEPROM follow after it
+int async_op_mc24xx_write_data(async_op_t* op,
+                               mc24xx_driver_t* self,
+                               uint16_t address,
+                               const void* data,
+                               uint16_t size);
+
+#endif /* __ASYNC_OPS_H__ */
@@ -0,0 +1,221 @@
+
+/* ===== INCLUDES =========================================================== */
+
+// PTHREAD_MUTEX_RECURSIVE and clock_gettime() under -std=c11
+#define _POSIX_C_SOURCE 200809L
+#define _XOPEN_SOURCE   700
+
+#include "busmgr.h"
+
+#include <string.h>
+#include <time.h>
+
+/* ===== DEFINITIONS ======================================================== */
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static uint64_t _now_ns(void);
+static void _begin(busmgr_device_t* dev);
+static void _end(busmgr_device_t* dev, uint8_t flags, int res);
+static int _read(const transport_t* self, void* data, size_t size, uint8_t flags);
+static int _write(const transport_t* self, const void* data, size_t size, uint8_t flags);
+static int _reset(const transport_t* self);
+static int _transfer(const transport_t* self, const transport_seg_t* segs, size_t count);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+int busmgr_bus_init(busmgr_bus_t* bus)
+{
+    pthread_mutexattr_t attr;
+    int res;
+
+    memset(bus, 0, sizeof(*bus));
+
+    res = pthread_mutexattr_init(&attr);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    res = pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    if (res == 0)
+    {
+        res = pthread_mutex_init(&bus->lock, &attr);
+    }
+
+    pthread_mutexattr_destroy(&attr);
+
+    return res;
+}
+
+int busmgr_bus_destroy(busmgr_bus_t* bus)
+{
+    return pthread_mutex_destroy(&bus->lock);
+}
+
+void busmgr_lock(busmgr_bus_t* bus)
+{
+    uint64_t wait_ns = 0;
+
+    if (pthread_mutex_trylock(&bus->lock) != 0)
+    {
+        uint64_t start = _now_ns();
+
+        pthread_mutex_lock(&bus->lock);
+
+        wait_ns = _now_ns() - start;
+        bus->stats.contended++;
+        bus->stats.wait_ns_total += wait_ns;
+        if (wait_ns > bus->stats.wait_ns_max)
+        {
+            bus->stats.wait_ns_max = wait_ns;
+        }
+    }
+
+    if (bus->depth++ == 0)
+    {
+        bus->stats.acquisitions++;
+        bus->acquired_ns = _now_ns();
+    }
+}
+
+void busmgr_unlock(busmgr_bus_t* bus)
+{
+    if (--bus->depth == 0)
+    {
+        uint64_t hold_ns = _now_ns() - bus->acquired_ns;
+
+        bus->stats.hold_ns_total += hold_ns;
+        if (hold_ns > bus->stats.hold_ns_max)
+        {
+            bus->stats.hold_ns_max = hold_ns;
+        }
+    }
+
+    pthread_mutex_unlock(&bus->lock);
+}
+
+void busmgr_get_stats(busmgr_bus_t* bus, busmgr_stats_t* stats)
+{
+    pthread_mutex_lock(&bus->lock);
+    *stats = bus->stats;
+    pthread_mutex_unlock(&bus->lock);
+}
+
+void busmgr_reset_stats(busmgr_bus_t* bus)
+{
+    pthread_mutex_lock(&bus->lock);
+    memset(&bus->stats, 0, sizeof(bus->stats));
+    pthread_mutex_unlock(&bus->lock);
+}
+
+const transport_t* busmgr_device_init(busmgr_device_t* dev, busmgr_bus_t* bus, const transport_t* inner, bool is_onewire)
+{
+    dev->inner      = inner;
+    dev->bus        = bus;
+    dev->is_onewire = is_onewire;
+    dev->transport  = (transport_t){
+        .ctx      = dev,
+        .bus      = inner->bus,
+        .address  = inner->address,
+        .read     = _read,
+        .write    = _write,
+        .reset    = (inner->reset != NULL) ? _reset : NULL,
+        .transfer = _transfer,
+    };
+
+    return &dev->transport;
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static uint64_t _now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void _begin(busmgr_device_t* dev)
+{
+    busmgr_lock(dev->bus);
+
+    // Already owned by this thread through the open transaction, keep a single level
+    if (dev->bus->tx_open)
+    {
+        busmgr_unlock(dev->bus);
+    }
+}
+
+static void _end(busmgr_device_t* dev, uint8_t flags, int res)
+{
+    if ((flags & TRANSPORT_FLAG_LAST) || (res != 0))
+    {
+        dev->bus->tx_open = false;
+        busmgr_unlock(dev->bus);
+    }
+    else
+    {
+        dev->bus->tx_open = true;
+    }
+}
+
+static int _read(const transport_t* self, void* data, size_t size, uint8_t flags)
+{
+    busmgr_device_t* dev = self->ctx;
+    int res;
+
+    _begin(dev);
+    res = transport_read(dev->inner, data, size, flags);
+    _end(dev, flags, res);
+
+    return res;
+}
+
+static int _write(const transport_t* self, const void* data, size_t size, uint8_t flags)
+{
+    busmgr_device_t* dev = self->ctx;
+    int res;
+
+    _begin(dev);
+    res = transport_write(dev->inner, data, size, flags);
+    _end(dev, flags, res);
+
+    return res;
+}
+
+static int _reset(const transport_t* self)
+{
+    busmgr_device_t* dev = self->ctx;
+    int res;
+
+    _begin(dev);
+
+    // A reset starts the next 1-Wire transaction, the bus is handed over in between
+    if (dev->bus->tx_open)
+    {
+        dev->bus->tx_open = false;
+        busmgr_unlock(dev->bus);
+        busmgr_lock(dev->bus);
+    }
+
+    res = transport_reset(dev->inner);
+    _end(dev, dev->is_onewire ? 0 : TRANSPORT_FLAG_LAST, res);
+
+    return res;
+}
+
+static int _transfer(const transport_t* self, const transport_seg_t* segs, size_t count)
+{
+    busmgr_device_t* dev = self->ctx;
+    int res;
+
+    _begin(dev);
+    res = transport_transfer(dev->inner, segs, count);
+    _end(dev, TRANSPORT_FLAG_LAST, res);
+
+    return res;
+}
@@ -0,0 +1,71 @@
+#ifndef __BUSMGR_H__
+#define __BUSMGR_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "transport.h"
+
+/* ===== DEFINITIONS ======================================================== */
+/* ===== TYPES ============================================================== */
+
+typedef struct
+{
+    uint64_t acquisitions;
+    uint64_t contended;
+    uint64_t wait_ns_total;
+    uint64_t wait_ns_max;
+    uint64_t hold_ns_total;
+    uint64_t hold_ns_max;
+} busmgr_stats_t;
+
+/*
+ * One lock per physical bus. The lock is recursive, so an application can hold
+ * it around a sequence of driver calls while the device transports still lock
+ * every transaction on their own.
+ */
+typedef struct
+{
+    pthread_mutex_t lock;
+    uint32_t depth;
+    bool tx_open;
+    uint64_t acquired_ns;
+    busmgr_stats_t stats;
+} busmgr_bus_t;
+
+/*
+ * Transport wrapper holding the bus lock for a whole I2C transaction, from its
+ * first transfer up to the one flagged TRANSPORT_FLAG_LAST (or a failed one), so
+ * e.g. the address write and data read of mc24xx_read_data() are never split.
+ * A transfer() is a whole transaction and always ends it.
+ * A 1-Wire transaction starts with a reset and keeps the lock through the ROM
+ * selection and function command up to the read, write or transfer that ends it
+ * (flagged TRANSPORT_FLAG_LAST), a failed call or the next reset.
+ */
+typedef struct
+{
+    transport_t transport;
+    const transport_t* inner;
+    busmgr_bus_t* bus;
+    bool is_onewire;
+} busmgr_device_t;
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+int busmgr_bus_init(busmgr_bus_t* bus);
+int busmgr_bus_destroy(busmgr_bus_t* bus);
+
+void busmgr_lock(busmgr_bus_t* bus);
+void busmgr_unlock(busmgr_bus_t* bus);
+
+void busmgr_get_stats(busmgr_bus_t* bus, busmgr_stats_t* stats);
+void busmgr_reset_stats(busmgr_bus_t* bus);
+
+//! Returns the transport to hand to the driver
+const transport_t* busmgr_device_init(busmgr_device_t* dev, busmgr_bus_t* bus, const transport_t* inner, bool is_onewire);
+
+#endif /* __BUSMGR_H__ */
@@ -0,0 +1,235 @@
+
+/* ===== INCLUDES =========================================================== */
+
+#include "discover.h"
+
+#include <string.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+// MC24XX_I2C_ADDRESS_x carry the chip select bits A2..A0, the bus address is 1010xxx
+#define MC24XX_BUS_ADDRESS(addr) (0x50 | ((addr)&0x07))
+
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static void* _thread(void* arg);
+static void _identify(discover_dev_t* dev);
+static bool _is_si7006(discover_dev_t* dev);
+static bool _is_ina226(discover_dev_t* dev);
+static bool _is_tsl2591(discover_dev_t* dev);
+static bool _is_vcnl40x0(discover_dev_t* dev);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+
+static const uint16_t _addresses[DISCOVER_MAX_DEVS] = {
+    VCNL4010_I2C_ADDRESS,
+    TSL2591_I2C_ADDRESS,
+    INA226_ADDRESS1, // SI7006_I2C_ADDRESS
+    INA226_ADDRESS2,
+    INA226_ADDRESS3,
+    INA226_ADDRESS4,
+    MC24XX_BUS_ADDRESS(MC24XX_I2C_ADDRESS_0),
+    MC24XX_BUS_ADDRESS(MC24XX_I2C_ADDRESS_1),
+    MC24XX_BUS_ADDRESS(MC24XX_I2C_ADDRESS_2),
+    MC24XX_BUS_ADDRESS(MC24XX_I2C_ADDRESS_3),
+    MC24XX_BUS_ADDRESS(MC24XX_I2C_ADDRESS_4),
+    MC24XX_BUS_ADDRESS(MC24XX_I2C_ADDRESS_5),
+    MC24XX_BUS_ADDRESS(MC24XX_I2C_ADDRESS_6),
+    MC24XX_BUS_ADDRESS(MC24XX_I2C_ADDRESS_7),
+};
+
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+void discover_bus_init(discover_bus_t* bus, const transport_t* proto)
+{
+    memset(bus, 0, sizeof(*bus));
+
+    bus->proto = *proto;
+}
+
+void discover_scan(discover_bus_t* bus)
+{
+    bus->count  = 0;
+    bus->probes = 0;
+
+    for (uint8_t i = 0; i < DISCOVER_MAX_DEVS; i++)
+    {
+        discover_dev_t* dev = &bus->devs[bus->count];
+
+        memset(dev, 0, sizeof(*dev));
+        dev->transport         = bus->proto;
+        dev->transport.address = _addresses[i];
+
+        bus->probes++;
+        if (transport_write(&dev->transport, NULL, 0, TRANSPORT_FLAG_LAST) != 0)
+        {
+            continue;
+        }
+
+        _identify(dev);
+        bus->count++;
+    }
+}
+
+void discover_run(discover_bus_t* buses, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        buses[i].threaded = (i + 1 < count) && (pthread_create(&buses[i].thread, NULL, _thread, &buses[i]) == 0);
+
+        // the last bus, or one without a thread, is discovered in line
+        if (!buses[i].threaded)
+        {
+            discover_scan(&buses[i]);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (buses[i].threaded)
+        {
+            pthread_join(buses[i].thread, NULL);
+        }
+    }
+}
+
+discover_dev_t* discover_find(discover_bus_t* bus, discover_part_t part, uint8_t nth)
+{
+    for (uint8_t i = 0; i < bus->count; i++)
+    {
+        if ((bus->devs[i].part == part) && (nth-- == 0))
+        {
+            return &bus->devs[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static void* _thread(void* arg)
+{
+    discover_scan(arg);
+
+    return NULL;
+}
+
+static void _identify(discover_dev_t* dev)
+{
+    bool found;
+
+    switch (dev->transport.address)
+    {
+        case VCNL4010_I2C_ADDRESS:
+            found = _is_vcnl40x0(dev);
+            break;
+        case TSL2591_I2C_ADDRESS:
+            found = _is_tsl2591(dev);
+            break;
+        case INA226_ADDRESS1:
+            found = _is_si7006(dev) || _is_ina226(dev);
+            break;
+        case INA226_ADDRESS2:
+        case INA226_ADDRESS3:
+        case INA226_ADDRESS4:
+            found = _is_ina226(dev);
+            break;
+        default:
+            dev->part   = DISCOVER_PART_MC24XX;
+            dev->mc24xx = (mc24xx_driver_t){.transport = &dev->transport};
+            found       = true;
+            break;
+    }
+
+    if (!found)
+    {
+        dev->part = DISCOVER_PART_UNKNOWN;
+    }
+}
+
+static bool _is_si7006(discover_dev_t* dev)
+{
+    si7006_reg_eid_t eid;
+
+    dev->si7006 = (si7006_driver_t){.transport = &dev->transport};
+    if (si7006_read_eid(&dev->si7006, &eid) != 0)
+    {
+        return false;
+    }
+
+    // the engineering sample IDs 0x00 and 0xFF are what other parts read back as well
+    switch (eid.device_id)
+    {
+        case SI7006_DEVICE_ID_SI7006:
+        case SI7006_DEVICE_ID_SI7013:
+        case SI7006_DEVICE_ID_SI7020:
+        case SI7006_DEVICE_ID_SI7021:
+            dev->part = DISCOVER_PART_SI7006;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool _is_ina226(discover_dev_t* dev)
+{
+    ina226_chip_info_t info;
+
+    // read-only identification first, the init resets the part
+    dev->ina226 = (ina226_handle_t){.transport = &dev->transport};
+    if ((ina226_get_chip_info(&dev->ina226, &info) != 0) || (info.manufacturer != INA226_MANUFACTURER) ||
+        (info.chip_id != INA226_CHIP_IDENTIFIER))
+    {
+        return false;
+    }
+
+    if (ina226_init_transport(&dev->ina226, &dev->transport) != 0)
+    {
+        return false;
+    }
+
+    dev->part = DISCOVER_PART_INA226;
+    return true;
+}
+
+static bool _is_tsl2591(discover_dev_t* dev)
+{
+    uint8_t id;
+
+    dev->tsl2591 = (tsl2591_driver_t){.transport = &dev->transport};
+    if ((tsl2591_read_device_id(&dev->tsl2591, &id) != 0) || (id != TSL2591_DEVICE_ID))
+    {
+        return false;
+    }
+
+    dev->part = DISCOVER_PART_TSL2591;
+    return true;
+}
+
+static bool _is_vcnl40x0(discover_dev_t* dev)
+{
+    vcnl4010_reg_version_t version;
+
+    // the version register is at the same place on both parts
+    dev->vcnl4010 = (vcnl4010_driver_t){.transport = &dev->transport};
+    if (vcnl4010_read_version(&dev->vcnl4010, &version) != 0)
+    {
+        return false;
+    }
+
+    switch (version.product_id)
+    {
+        case VCNL4000_PRODUCT_ID:
+            dev->part     = DISCOVER_PART_VCNL4000;
+            dev->vcnl4000 = (vcnl4000_driver_t){.transport = &dev->transport};
+            return true;
+        case VCNL4010_PRODUCT_ID:
+            dev->part = DISCOVER_PART_VCNL4010;
+            return true;
+        default:
+            return false;
+    }
+}
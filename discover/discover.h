@@ -0,0 +1,88 @@
+#ifndef __DISCOVER_H__
+#define __DISCOVER_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ina226.h"
+#include "mc24xx.h"
+#include "si7006.h"
+#include "transport.h"
+#include "tsl2591.h"
+#include "vcnl4000.h"
+#include "vcnl4010.h"
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define DISCOVER_MAX_DEVS (14) //! every address probed
+
+/* ===== TYPES ============================================================== */
+
+typedef enum
+{
+    DISCOVER_PART_UNKNOWN, //! acknowledged, but no ID matched
+    DISCOVER_PART_INA226,
+    DISCOVER_PART_SI7006,  //! also Si7013/Si7020/Si7021, see si7006_read_eid()
+    DISCOVER_PART_TSL2591,
+    DISCOVER_PART_VCNL4000,
+    DISCOVER_PART_VCNL4010,
+    DISCOVER_PART_MC24XX,  //! no ID register, identified by its address only
+} discover_part_t;
+
+typedef struct
+{
+    discover_part_t part;
+    transport_t transport;
+    union
+    {
+        ina226_handle_t ina226; //! initialised and reset by ina226_init_transport()
+        si7006_driver_t si7006; //! wait has to be set before a hold mode measurement
+        tsl2591_driver_t tsl2591;
+        vcnl4000_driver_t vcnl4000;
+        vcnl4010_driver_t vcnl4010;
+        mc24xx_driver_t mc24xx;
+    };
+} discover_dev_t;
+
+/*
+ * Startup discovery of one bus. The addresses of the supported parts are swept
+ * with zero-length writes, which only cost the address phase, then each
+ * acknowledged address is identified through the ID registers: the VCNL40x0
+ * version, the TSL2591 device ID, the Si7006 electronic ID and the INA226
+ * manufacturer and chip ID. 0x40 is shared by the Si7006 and INA226, the Si7006
+ * is tried first as the INA226 ID pointer 0xFE is the Si7006 reset command.
+ *
+ * proto is a transport of the bus, copied with the address replaced for every
+ * device. The drivers refer to the transport inside their discover_dev_t, so
+ * the bus structure must stay in place while they are in use.
+ */
+typedef struct
+{
+    transport_t proto;
+    discover_dev_t devs[DISCOVER_MAX_DEVS];
+    uint8_t count;
+    uint8_t probes;
+
+    pthread_t thread;
+    bool threaded;
+} discover_bus_t;
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+void discover_bus_init(discover_bus_t* bus, const transport_t* proto);
+
+//! Discovers a single bus in the calling thread
+void discover_scan(discover_bus_t* bus);
+
+//! Discovers the buses concurrently, one thread each, and returns once all of them are done
+void discover_run(discover_bus_t* buses, size_t count);
+
+//! Returns the nth device of part, NULL when there are fewer
+discover_dev_t* discover_find(discover_bus_t* bus, discover_part_t part, uint8_t nth);
+
+#endif /* __DISCOVER_H__ */
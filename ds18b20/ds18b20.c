@@ -2,6 +2,8 @@
 
 #include <string.h>
 
+#include "instr.h"
+
 #define CMD_READ_ROM   (0x33)
 #define CMD_MATCH_ROM  (0x55)
 #define CMD_SKIP_ROM   (0xCC)
@@ -14,16 +16,24 @@
 #define CONF2RESOLUTION(reg) (((reg) >> 5) & 3)
 #define RESOLUTION2CONF(res) (((res)&3) << 5)
 
+// bus calls are accounted to the calling public function when built with DRIVERS_INSTR, the helpers run in its
+// INSTR_SCOPE; a reset opens a transaction, a read or write flagged last or a transfer (always whole) closes it
+#define _read_data(handle, data, size, is_last) \
+    INSTR_IO(_io_read_data(handle, data, size, is_last), size, 0, is_last)
+#define _write_data(handle, data, size, is_strong, is_last) \
+    INSTR_IO(_io_write_data(handle, data, size, is_strong, is_last), 0, size, is_last)
+#define _reset(handle) INSTR_IO(_io_reset(handle), 0, 0, false)
+#define _transfer(handle, segs, count, size_in, size_out) \
+    INSTR_IO(_io_transfer(handle, segs, count), size_in, size_out, true)
+
 static int _preambule(ds18b20_handle_t* handle);
 static int _read_scratchpad(ds18b20_handle_t* handle);
 static int _write_scratchpad(ds18b20_handle_t* handle);
-
-static const float _sens_list[4] = {
-    [DS18B20_RESOLUTION_9BIT] = 0.5,
-    [DS18B20_RESOLUTION_10BIT] = 0.25,
-    [DS18B20_RESOLUTION_11BIT] = 0.125,
-    [DS18B20_RESOLUTION_12BIT] = 0.0625,
-};
+static int _io_read_data(ds18b20_handle_t* handle, void* data, uint32_t size, bool is_last);
+static int _io_write_data(ds18b20_handle_t* handle, void* data, uint32_t size, bool is_strong, bool is_last);
+static int _io_reset(ds18b20_handle_t* handle);
+static int _io_transfer(ds18b20_handle_t* handle, const transport_seg_t* segs, size_t count);
+static uint8_t _crc8(const uint8_t* data, size_t size);
 
 static const uint16_t _conv_time_list[4] = {
     [DS18B20_RESOLUTION_9BIT] = 94,
@@ -39,18 +49,81 @@ int ds18b20_init(ds18b20_handle_t* handle, uint64_t device_id)
 
     int res;
 
-    res = _preambule(handle);
+    res = INSTR_SCOPE(_preambule(handle));
+    if (res != 0)
+    {
+        return res;
+    }
+
+    res = INSTR_SCOPE(_read_scratchpad(handle));
+    if (res != 0)
+    {
+        return res;
+    }
+
+    handle->inited = true;
+    handle->convertion_period = _conv_time_list[CONF2RESOLUTION(handle->scratchpad[SCR_CONF])];
+    return res;
+}
+
+int ds18b20_resume(ds18b20_handle_t* handle, uint64_t device_id, const uint8_t scratchpad[3])
+{
+    handle->inited = false;
+    handle->dev_id = device_id;
+
+    uint8_t rom[8];
+    uint8_t d[9];
+    int res;
+
+    // a replaced probe answers the reset as well, without Match ROM its ROM code is read back
+    if (!handle->use_id)
+    {
+        transport_seg_t segs[] = {
+            {.data = (uint8_t[1]){CMD_READ_ROM}, .size = 1},
+            {.data = rom, .size = sizeof(rom), .flags = TRANSPORT_FLAG_READ | TRANSPORT_FLAG_LAST},
+        };
+
+        res = _reset(handle);
+        if (res == 0)
+        {
+            res = _transfer(handle, segs, 2, sizeof(rom), 1);
+        }
+        if (res != 0)
+        {
+            return res;
+        }
+
+        if ((_crc8(rom, 7) != rom[7]) || (memcmp(rom, &handle->dev_id, sizeof(rom)) != 0))
+        {
+            return 1;
+        }
+    }
+
+    res = INSTR_SCOPE(_preambule(handle));
     if (res != 0)
     {
         return res;
     }
 
-    res = _read_scratchpad(handle);
+    transport_seg_t segs[] = {
+        {.data = (uint8_t[1]){DS18B20_CMD_READ_SCRATCHPAD}, .size = 1},
+        {.data = d, .size = sizeof(d), .flags = TRANSPORT_FLAG_READ | TRANSPORT_FLAG_LAST},
+    };
+
+    res = _transfer(handle, segs, 2, sizeof(d), 1);
     if (res != 0)
     {
         return res;
     }
 
+    // nobody answering Match ROM reads all ones; a lost configuration needs ds18b20_init()
+    if ((_crc8(d, 8) != d[8]) || (memcmp(&d[2], scratchpad, sizeof(handle->scratchpad)) != 0))
+    {
+        return 1;
+    }
+
+    memcpy(handle->scratchpad, scratchpad, sizeof(handle->scratchpad));
+
     handle->inited = true;
     handle->convertion_period = _conv_time_list[CONF2RESOLUTION(handle->scratchpad[SCR_CONF])];
     return res;
@@ -74,8 +147,8 @@ int ds18b20_start_convertion(ds18b20_handle_t* handle)
         return 1;
     }
 
-    _preambule(handle);
-    return handle->write_data((uint8_t[1]){DS18B20_CMD_CONVERT}, 1, true);
+    INSTR_SCOPE(_preambule(handle));
+    return _write_data(handle, (uint8_t[1]){DS18B20_CMD_CONVERT}, 1, true, true);
 }
 
 int ds18b20_start_convertion_all(ds18b20_handle_t* handle)
@@ -85,29 +158,71 @@ int ds18b20_start_convertion_all(ds18b20_handle_t* handle)
         return 1;
     }
 
-    handle->reset();
+    _reset(handle);
     uint8_t d[2] = {CMD_SKIP_ROM, DS18B20_CMD_CONVERT};
-    return handle->write_data(d, 2, true);
+    return _write_data(handle, d, 2, true, true);
 }
 
-int ds18b20_get_temperature(ds18b20_handle_t* handle, float* value)
+uint16_t ds18b20_get_conversion_time_ms(ds18b20_handle_t* handle)
+{
+    return handle->convertion_period;
+}
+
+int ds18b20_get_temperature_raw(ds18b20_handle_t* handle, int16_t* value)
 {
     if (!handle->inited)
     {
         return 1;
     }
 
-    _preambule(handle);
-    handle->write_data((uint8_t[1]){DS18B20_CMD_READ_SCRATCHPAD}, 1, false);
+    INSTR_SCOPE(_preambule(handle));
+    _write_data(handle, (uint8_t[1]){DS18B20_CMD_READ_SCRATCHPAD}, 1, false, false);
+
+    uint8_t raw[2];
+    int res = _read_data(handle, raw, 2, true);
+
+    *value = ds18b20_normalize_raw((int16_t)(raw[0] | (raw[1] << 8)),
+                                   (ds18b20_resolution_t)CONF2RESOLUTION(handle->scratchpad[SCR_CONF]));
+
+    return res;
+}
+
+int ds18b20_get_temperature_mc(ds18b20_handle_t* handle, int32_t* value)
+{
+    int16_t raw;
+    int res = ds18b20_get_temperature_raw(handle, &raw);
+
+    *value = DS18B20_RAW2MC(raw);
+
+    return res;
+}
 
+int ds18b20_get_temperature(ds18b20_handle_t* handle, float* value)
+{
     int16_t raw;
-    int res = handle->read_data(&raw, 2);
+    int res = ds18b20_get_temperature_raw(handle, &raw);
 
-    *value = (float)raw * _sens_list[CONF2RESOLUTION(handle->scratchpad[SCR_CONF])];
+    *value = (float)raw * (1.0f / 16.0f);
 
     return res;
 }
 
+int16_t ds18b20_normalize_raw(int16_t raw, ds18b20_resolution_t resolution)
+{
+    // undefined bits: 3 at 9 bit down to none at 12 bit
+    return (int16_t)(raw & ~((1 << (DS18B20_RESOLUTION_12BIT - resolution)) - 1));
+}
+
+void ds18b20_raw_to_mc_batch(const int16_t* raw, int32_t* value, size_t count, ds18b20_resolution_t resolution)
+{
+    int16_t mask = (int16_t)~((1 << (DS18B20_RESOLUTION_12BIT - resolution)) - 1);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        value[i] = DS18B20_RAW2MC(raw[i] & mask);
+    }
+}
+
 int ds18b20_set_resolution(ds18b20_handle_t* handle, ds18b20_resolution_t value)
 {
     if (!handle->inited)
@@ -118,8 +233,8 @@ int ds18b20_set_resolution(ds18b20_handle_t* handle, ds18b20_resolution_t value)
     handle->scratchpad[SCR_CONF] = RESOLUTION2CONF(value);
     handle->convertion_period = _conv_time_list[CONF2RESOLUTION(handle->scratchpad[SCR_CONF])];
 
-    _preambule(handle);
-    return _write_scratchpad(handle);
+    INSTR_SCOPE(_preambule(handle));
+    return INSTR_SCOPE(_write_scratchpad(handle));
 }
 
 int ds18b20_get_resolution(ds18b20_handle_t* handle, ds18b20_resolution_t* value)
@@ -143,8 +258,8 @@ int ds18b20_set_alarm_range(ds18b20_handle_t* handle, float min, float max)
     handle->scratchpad[SCR_TL] = (int8_t)min;
     handle->scratchpad[SCR_TH] = (int8_t)max;
 
-    _preambule(handle);
-    return _write_scratchpad(handle);
+    INSTR_SCOPE(_preambule(handle));
+    return INSTR_SCOPE(_write_scratchpad(handle));
 }
 
 int ds18b20_get_alarm_range(ds18b20_handle_t* handle, float* min, float* max)
@@ -166,8 +281,8 @@ int ds18b20_save_configs(ds18b20_handle_t* handle)
         return 1;
     }
 
-    _preambule(handle);
-    return handle->write_data((uint8_t[1]){DS18B20_CMD_COPY_SCRATCHPAD}, 1, true);
+    INSTR_SCOPE(_preambule(handle));
+    return _write_data(handle, (uint8_t[1]){DS18B20_CMD_COPY_SCRATCHPAD}, 1, true, true);
 }
 
 int ds18b20_restore_configs(ds18b20_handle_t* handle)
@@ -177,16 +292,16 @@ int ds18b20_restore_configs(ds18b20_handle_t* handle)
         return 1;
     }
 
-    _preambule(handle);
-    handle->write_data((uint8_t[1]){DS18B20_CMD_RECALL}, 1, false);
-    return _read_scratchpad(handle);
+    INSTR_SCOPE(_preambule(handle));
+    _write_data(handle, (uint8_t[1]){DS18B20_CMD_RECALL}, 1, false, false);
+    return INSTR_SCOPE(_read_scratchpad(handle));
 }
 
 static int _preambule(ds18b20_handle_t* handle)
 {
     int res;
 
-    res = handle->reset();
+    res = _reset(handle);
 
     if (res != 0)
     {
@@ -195,12 +310,15 @@ static int _preambule(ds18b20_handle_t* handle)
 
     if (handle->use_id)
     {
-        handle->write_data((uint8_t[1]){CMD_MATCH_ROM}, 1, false);
-        res = handle->write_data(&handle->dev_id, 8, false);
+        uint8_t d[9] = {CMD_MATCH_ROM};
+
+        // the function command follows in a later call, so this is a plain write like Skip ROM
+        memcpy(&d[1], &handle->dev_id, 8);
+        res = _write_data(handle, d, sizeof(d), false, false);
     }
     else
     {
-        res = handle->write_data((uint8_t[1]){CMD_SKIP_ROM}, 1, false);
+        res = _write_data(handle, (uint8_t[1]){CMD_SKIP_ROM}, 1, false, false);
     }
 
     return res;
@@ -210,8 +328,12 @@ static int _read_scratchpad(ds18b20_handle_t* handle)
 {
     uint8_t d[5];
 
-    handle->write_data((uint8_t[1]){DS18B20_CMD_READ_SCRATCHPAD}, 1, false);
-    int res = handle->read_data(d, 5);
+    transport_seg_t segs[] = {
+        {.data = (uint8_t[1]){DS18B20_CMD_READ_SCRATCHPAD}, .size = 1},
+        {.data = d, .size = 5, .flags = TRANSPORT_FLAG_READ | TRANSPORT_FLAG_LAST},
+    };
+
+    int res = _transfer(handle, segs, 2, 5, 1);
 
     memcpy(handle->scratchpad, &d[2], 3);
 
@@ -220,10 +342,86 @@ static int _read_scratchpad(ds18b20_handle_t* handle)
 
 static int _write_scratchpad(ds18b20_handle_t* handle)
 {
-    uint8_t d[4];
+    // TL, TH and the configuration go out from the handle, they follow the command on the bus
+    transport_seg_t segs[] = {
+        {.data = (uint8_t[1]){DS18B20_CMD_WRITE_SCRATCHPAD}, .size = 1},
+        {.data = handle->scratchpad, .size = 3, .flags = TRANSPORT_FLAG_LAST},
+    };
+
+    return _transfer(handle, segs, 2, 0, 4);
+}
+
+static int _io_read_data(ds18b20_handle_t* handle, void* data, uint32_t size, bool is_last)
+{
+    if (handle->transport != NULL)
+    {
+        return transport_read(handle->transport, data, size, is_last ? TRANSPORT_FLAG_LAST : 0);
+    }
+
+    return handle->read_data(data, size);
+}
+
+static int _io_write_data(ds18b20_handle_t* handle, void* data, uint32_t size, bool is_strong, bool is_last)
+{
+    if (handle->transport != NULL)
+    {
+        return transport_write(handle->transport,
+                               data,
+                               size,
+                               (is_strong ? TRANSPORT_FLAG_STRONG : 0) | (is_last ? TRANSPORT_FLAG_LAST : 0));
+    }
+
+    return handle->write_data(data, size, is_strong);
+}
+
+static int _io_reset(ds18b20_handle_t* handle)
+{
+    if (handle->transport != NULL)
+    {
+        return transport_reset(handle->transport);
+    }
 
-    d[0] = DS18B20_CMD_WRITE_SCRATCHPAD;
-    memcpy(&d[1], handle->scratchpad, 3);
+    return handle->reset();
+}
 
-    return handle->write_data(d, 4, false);
-}
\ No newline at end of file
+static int _io_transfer(ds18b20_handle_t* handle, const transport_seg_t* segs, size_t count)
+{
+    int res = 0;
+
+    if (handle->transport != NULL)
+    {
+        return transport_transfer(handle->transport, segs, count);
+    }
+
+    for (size_t i = 0; (res == 0) && (i < count); i++)
+    {
+        if (segs[i].flags & TRANSPORT_FLAG_READ)
+        {
+            res = handle->read_data(segs[i].data, segs[i].size);
+        }
+        else
+        {
+            res = handle->write_data(segs[i].data, segs[i].size, segs[i].flags & TRANSPORT_FLAG_STRONG);
+        }
+    }
+
+    return res;
+}
+
+static uint8_t _crc8(const uint8_t* data, size_t size)
+{
+    uint8_t crc = 0;
+
+    // Dallas/Maxim CRC-8, x^8 + x^5 + x^4 + 1 shifted out LSB first
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? (uint8_t)((crc >> 1) ^ 0x8C) : (uint8_t)(crc >> 1);
+        }
+    }
+
+    return crc;
+}
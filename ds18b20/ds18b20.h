@@ -1,8 +1,11 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "transport.h"
+
 #define DS18B20_FAMILY 0x28
 
 #define DS18B20_CMD_CONVERT          0x44
@@ -11,10 +14,15 @@
 #define DS18B20_CMD_RECALL           0xB8
 #define DS18B20_CMD_READ_SCRATCHPAD  0xBE
 
-#define DS18B20_RAW2PHYS_12BIT(val) (float)(val) * (1.0 / (float)(1UL << 4))
-#define DS18B20_RAW2PHYS_11BIT(val) (float)(val) * (1.0 / (float)(1UL << 3))
-#define DS18B20_RAW2PHYS_10BIT(val) (float)(val) * (1.0 / (float)(1UL << 2))
-#define DS18B20_RAW2PHYS_9BIT(val)  (float)(val) * (1.0 / (float)(1UL << 1))
+// temperature register to degC, the scale is 1/16 degC at every resolution (lower resolutions leave the
+// low bits undefined, see ds18b20_normalize_raw()), DS18B20_RAW2MC() is the integer variant
+#define DS18B20_RAW2PHYS_12BIT(val) ((float)(val) * (1.0f / 16.0f))
+#define DS18B20_RAW2PHYS_11BIT(val) DS18B20_RAW2PHYS_12BIT(val)
+#define DS18B20_RAW2PHYS_10BIT(val) DS18B20_RAW2PHYS_12BIT(val)
+#define DS18B20_RAW2PHYS_9BIT(val)  DS18B20_RAW2PHYS_12BIT(val)
+
+// temperature register (1/16 degC at every resolution) to milli-degC, truncated towards zero
+#define DS18B20_RAW2MC(val) ((int32_t)(val)*125 / 2)
 
 #define DS18B20_MAX_CONV_TIME_MS (750)
 
@@ -23,6 +31,7 @@ typedef struct
     int (*read_data)(void* data, uint32_t size);
     int (*write_data)(void* data, uint32_t size, bool is_strong);
     int (*reset)(void);
+    const transport_t* transport; // used instead of the callbacks above when set
     uint64_t dev_id;
     uint16_t convertion_period;
     uint8_t scratchpad[3];
@@ -31,12 +40,20 @@ typedef struct
 } ds18b20_handle_t;
 
 int ds18b20_init(ds18b20_handle_t* handle, uint64_t device_id);
+// warm start from a saved TL, TH and configuration: checks the ROM code (Match ROM with use_id,
+// Read ROM otherwise) and that the scratchpad still holds the saved configuration
+int ds18b20_resume(ds18b20_handle_t* handle, uint64_t device_id, const uint8_t scratchpad[3]);
 
 int ds18b20_set_id_usable(ds18b20_handle_t* handle, bool is_use);
 
 int ds18b20_start_convertion(ds18b20_handle_t* handle);
 int ds18b20_start_convertion_all(ds18b20_handle_t* handle);
+// conversion time of the current resolution, valid after ds18b20_init()
+uint16_t ds18b20_get_conversion_time_ms(ds18b20_handle_t* handle);
 
+// 1/16 degC with the bits undefined at the configured resolution cleared
+int ds18b20_get_temperature_raw(ds18b20_handle_t* handle, int16_t* value);
+int ds18b20_get_temperature_mc(ds18b20_handle_t* handle, int32_t* value);
 int ds18b20_get_temperature(ds18b20_handle_t* handle, float* value);
 
 typedef enum
@@ -47,6 +64,10 @@ typedef enum
     DS18B20_RESOLUTION_12BIT,
 } ds18b20_resolution_t;
 
+// normalisation and conversion of temperatures read elsewhere, e.g. from a batch of scratchpads
+int16_t ds18b20_normalize_raw(int16_t raw, ds18b20_resolution_t resolution);
+void ds18b20_raw_to_mc_batch(const int16_t* raw, int32_t* value, size_t count, ds18b20_resolution_t resolution);
+
 int ds18b20_set_resolution(ds18b20_handle_t* handle, ds18b20_resolution_t value);
 int ds18b20_get_resolution(ds18b20_handle_t* handle, ds18b20_resolution_t* value);
 
@@ -0,0 +1,237 @@
+
+/* ===== INCLUDES =========================================================== */
+
+#include "i2cdev.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+/* ===== DEFINITIONS ======================================================== */
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static int _ioctl(int fd, unsigned long request, void* arg);
+static int _queue(i2cdev_bus_t* bus, uint16_t address, void* data, size_t size, uint8_t flags);
+static int _append(i2cdev_bus_t* bus, uint16_t address, void* data, size_t size, uint8_t flags);
+static int _execute(i2cdev_bus_t* bus);
+static int _read(const transport_t* self, void* data, size_t size, uint8_t flags);
+static int _write(const transport_t* self, const void* data, size_t size, uint8_t flags);
+static int _transfer(const transport_t* self, const transport_seg_t* segs, size_t count);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+int i2cdev_open(i2cdev_bus_t* bus, int adapter)
+{
+    char path[32];
+
+    memset(bus, 0, sizeof(*bus));
+    bus->ioctl = _ioctl;
+
+    snprintf(path, sizeof(path), "/dev/i2c-%d", adapter);
+
+    bus->fd = open(path, O_RDWR);
+    if (bus->fd < 0)
+    {
+        return -errno;
+    }
+
+    return 0;
+}
+
+int i2cdev_close(i2cdev_bus_t* bus)
+{
+    if (close(bus->fd) != 0)
+    {
+        return -errno;
+    }
+
+    bus->fd = -1;
+    return 0;
+}
+
+void i2cdev_transport_init(transport_t* transport, i2cdev_bus_t* bus, uint16_t address)
+{
+    *transport = (transport_t){
+        .ctx      = bus,
+        .bus      = bus,
+        .address  = address,
+        .read     = _read,
+        .write    = _write,
+        .transfer = _transfer,
+    };
+}
+
+void i2cdev_batch_begin(i2cdev_bus_t* bus)
+{
+    bus->batch = true;
+}
+
+int i2cdev_flush(i2cdev_bus_t* bus)
+{
+    bus->batch = false;
+    return _execute(bus);
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static int _ioctl(int fd, unsigned long request, void* arg)
+{
+    return ioctl(fd, request, arg);
+}
+
+static int _queue(i2cdev_bus_t* bus, uint16_t address, void* data, size_t size, uint8_t flags)
+{
+    int res;
+
+    if (!bus->open)
+    {
+        bus->tx_nmsgs    = bus->nmsgs;
+        bus->tx_buf_used = bus->buf_used;
+    }
+
+    res = _append(bus, address, data, size, flags);
+    if (res != 0)
+    {
+        // Only the broken transaction is dropped, earlier ones were already reported queued
+        bus->nmsgs    = bus->tx_nmsgs;
+        bus->buf_used = bus->tx_buf_used;
+        bus->open     = false;
+        return res;
+    }
+
+    if (!bus->open && !bus->batch)
+    {
+        return _execute(bus);
+    }
+
+    return 0;
+}
+
+static int _append(i2cdev_bus_t* bus, uint16_t address, void* data, size_t size, uint8_t flags)
+{
+    bool is_read         = (flags & TRANSPORT_FLAG_READ) != 0;
+    struct i2c_msg* prev = (bus->nmsgs != 0) ? &bus->msgs[bus->nmsgs - 1] : NULL;
+    bool is_continuation = bus->open && (prev != NULL) && !is_read && !(prev->flags & I2C_M_RD)
+                           && (prev->addr == address);
+
+    if (is_continuation)
+    {
+        // Both parts have to be contiguous, the previous one is moved to the staging buffer
+        if (prev->buf + prev->len != &bus->buf[bus->buf_used])
+        {
+            if (bus->buf_used + prev->len + size > sizeof(bus->buf))
+            {
+                return -ENOMEM;
+            }
+
+            memcpy(&bus->buf[bus->buf_used], prev->buf, prev->len);
+            prev->buf = &bus->buf[bus->buf_used];
+            bus->buf_used += prev->len;
+        }
+        else if (bus->buf_used + size > sizeof(bus->buf))
+        {
+            return -ENOMEM;
+        }
+
+        memcpy(&bus->buf[bus->buf_used], data, size);
+        bus->buf_used += size;
+        prev->len += size;
+    }
+    else
+    {
+        struct i2c_msg* msg;
+
+        if ((bus->nmsgs == I2CDEV_MAX_MSGS) || (size > UINT16_MAX))
+        {
+            return -ENOMEM;
+        }
+
+        msg        = &bus->msgs[bus->nmsgs++];
+        msg->addr  = address;
+        msg->flags = is_read ? I2C_M_RD : 0;
+        msg->len   = (uint16_t)size;
+        msg->buf   = data;
+
+        if (!is_read && bus->batch)
+        {
+            if (bus->buf_used + size > sizeof(bus->buf))
+            {
+                bus->nmsgs--;
+                return -ENOMEM;
+            }
+
+            memcpy(&bus->buf[bus->buf_used], data, size);
+            msg->buf = &bus->buf[bus->buf_used];
+            bus->buf_used += size;
+        }
+    }
+
+    bus->open = (flags & TRANSPORT_FLAG_LAST) == 0;
+
+    return 0;
+}
+
+static int _execute(i2cdev_bus_t* bus)
+{
+    struct i2c_rdwr_ioctl_data rdwr = {
+        .msgs  = bus->msgs,
+        .nmsgs = bus->nmsgs,
+    };
+    int res = 0;
+
+    if (bus->nmsgs != 0)
+    {
+        bus->ioctls++;
+        bus->messages += bus->nmsgs;
+
+        if (bus->ioctl(bus->fd, I2C_RDWR, &rdwr) < 0)
+        {
+            res = -errno;
+        }
+    }
+
+    bus->nmsgs    = 0;
+    bus->buf_used = 0;
+    bus->open     = false;
+
+    return res;
+}
+
+static int _read(const transport_t* self, void* data, size_t size, uint8_t flags)
+{
+    return _queue(self->ctx, self->address, data, size, flags | TRANSPORT_FLAG_READ);
+}
+
+static int _write(const transport_t* self, const void* data, size_t size, uint8_t flags)
+{
+    return _queue(self->ctx, self->address, (void*)data, size, flags & ~TRANSPORT_FLAG_READ);
+}
+
+static int _transfer(const transport_t* self, const transport_seg_t* segs, size_t count)
+{
+    int res = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t flags = segs[i].flags;
+
+        if (i == count - 1)
+        {
+            flags |= TRANSPORT_FLAG_LAST;
+        }
+
+        res = _queue(self->ctx, self->address, segs[i].data, segs[i].size, flags);
+        if (res != 0)
+        {
+            break;
+        }
+    }
+
+    return res;
+}
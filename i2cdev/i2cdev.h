@@ -0,0 +1,67 @@
+#ifndef __I2CDEV_H__
+#define __I2CDEV_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "transport.h"
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define I2CDEV_MAX_MSGS (I2C_RDWR_IOCTL_MAX_MSGS)
+#define I2CDEV_BUF_SIZE (512)
+
+/* ===== TYPES ============================================================== */
+
+typedef int (*i2cdev_ioctl_t)(int fd, unsigned long request, void* arg);
+
+/*
+ * Linux /dev/i2c-N backend. Every transaction, i.e. all transfers up to the one
+ * flagged TRANSPORT_FLAG_LAST, is executed as a single I2C_RDWR ioctl with
+ * repeated STARTs between its messages. Consecutive writes are merged into one
+ * message. Nothing reaches the bus before the LAST transfer, so a caller must not
+ * wait inside an open transaction, e.g. for a conversion started by a command
+ * write: the command has to be flagged LAST and the result read in a new one.
+ *
+ * In batch mode transactions are only queued and executed together by
+ * i2cdev_flush(). Read buffers must stay valid until then, write data is copied.
+ * A batch turns the STOP between transactions into a repeated START, so it must
+ * not contain operations that depend on the STOP, such as 24xx page writes.
+ * A transaction that does not fit the queue fails on its own, the ones queued
+ * before it are kept for i2cdev_flush().
+ */
+typedef struct
+{
+    int fd;
+    i2cdev_ioctl_t ioctl; //! ioctl() by default, may be replaced by an in-process fake
+
+    struct i2c_msg msgs[I2CDEV_MAX_MSGS];
+    uint8_t nmsgs;
+    uint8_t buf[I2CDEV_BUF_SIZE];
+    uint16_t buf_used;
+    bool open;  //! a transaction is in progress
+    bool batch;
+    uint8_t tx_nmsgs;     //! queue state before the current transaction, restored when it fails
+    uint16_t tx_buf_used;
+
+    uint32_t ioctls;
+    uint32_t messages;
+} i2cdev_bus_t;
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+int i2cdev_open(i2cdev_bus_t* bus, int adapter);
+int i2cdev_close(i2cdev_bus_t* bus);
+
+void i2cdev_transport_init(transport_t* transport, i2cdev_bus_t* bus, uint16_t address);
+
+void i2cdev_batch_begin(i2cdev_bus_t* bus);
+//! Executes the queued transactions and leaves batch mode
+int i2cdev_flush(i2cdev_bus_t* bus);
+
+#endif /* __I2CDEV_H__ */
@@ -3,6 +3,8 @@
 #include <stdbool.h>
 #include <stdlib.h>
 
+#include "instr.h"
+
 #define CHECK_RESULT(res) \
     do                    \
     {                     \
@@ -17,32 +19,44 @@
             *(dptr) = val;     \
     } while (0)
 
-#define VBUS_SENSE  (1.25e-3)
-#define SHUNT_SENSE (2.5e-6)
+#define VBUS_SENSE  INA226_VBUS_LSB
+#define SHUNT_SENSE INA226_SHUNT_LSB
 #define VBUS_VMAX   (40.96)
 #define SHUNT_VMAX  (81.92e-3)
 
+static const uint16_t _conv_time_us[8] = {140, 204, 332, 588, 1100, 2116, 4156, 8244};
+static const uint16_t _average_count[8] = {1, 4, 16, 64, 128, 256, 512, 1024};
+
+// register accesses are accounted to the calling function when built with DRIVERS_INSTR
+#define _reg_read(handle, reg, data)  INSTR_IO(_io_reg_read(handle, reg, data), 2, 1, true)
+#define _reg_write(handle, reg, data) INSTR_IO(_io_reg_write(handle, reg, data), 0, 3, true)
+
+static int _probe(ina226_handle_t* handle);
+static int _io_reg_read(ina226_handle_t* handle, uint8_t reg, uint16_t* data);
+static int _io_reg_write(ina226_handle_t* handle, uint8_t reg, uint16_t data);
+static uint16_t _conf_pack(ina226_configuration_t conf);
+static ina226_configuration_t _conf_unpack(uint16_t raw);
+static uint16_t _mask_pack(ina226_mask_t value);
+static ina226_mask_t _mask_unpack(uint16_t raw);
+
 int ina226_init(ina226_handle_t* handle, ina266_reg_read_t read_cb, ina266_reg_write_t write_cb)
 {
     handle->curr_sens = 0.0;
     handle->reg_read = read_cb;
     handle->reg_write = write_cb;
+    handle->transport = NULL;
 
-    int res = 0;
-
-    res = ina226_reset(handle);
-    CHECK_RESULT(res);
-
-    ina226_chip_info_t info;
-    res = ina226_get_chip_info(handle, &info);
-    CHECK_RESULT(res);
+    return _probe(handle);
+}
 
-    if ((info.chip_id != INA226_CHIP_IDENTIFIER) || (info.manufacturer != INA226_MANUFACTURER))
-    {
-        res = 1;
-    }
+int ina226_init_transport(ina226_handle_t* handle, const transport_t* transport)
+{
+    handle->curr_sens = 0.0;
+    handle->reg_read = NULL;
+    handle->reg_write = NULL;
+    handle->transport = transport;
 
-    return res;
+    return _probe(handle);
 }
 
 int ina226_reset(ina226_handle_t* handle)
@@ -52,43 +66,63 @@ int ina226_reset(ina226_handle_t* handle)
 
 int ina226_reg_read(ina226_handle_t* handle, uint8_t reg, uint16_t* data)
 {
-    uint16_t tmp;
-    int res;
-
-    res = handle->reg_read(reg, &tmp);
-    *data = (tmp >> 8) | (tmp << 8);
-    return res;
+    return _reg_read(handle, reg, data);
 }
 
 int ina226_reg_write(ina226_handle_t* handle, uint8_t reg, uint16_t data)
 {
-    data = (data >> 8) | (data << 8);
-    return handle->reg_write(reg, data);
+    return _reg_write(handle, reg, data);
+}
+
+int ina226_reg_update(ina226_handle_t* handle, uint8_t reg, uint16_t mask, uint16_t value)
+{
+    uint16_t raw;
+    int res;
+
+    res = _reg_read(handle, reg, &raw);
+    CHECK_RESULT(res);
+
+    return _reg_write(handle, reg, REGMAP_UPDATE(raw, mask, value));
 }
 
 int ina226_get_configuration(ina226_handle_t* handle, ina226_configuration_t* conf)
 {
-    return ina226_reg_read(handle, INA226_REG_CONFIGURATION, (uint16_t*)conf);
+    uint16_t raw;
+    int res;
+
+    res = _reg_read(handle, INA226_REG_CONFIGURATION, &raw);
+    *conf = _conf_unpack(raw);
+
+    return res;
 }
 
 int ina226_set_configuration(ina226_handle_t* handle, ina226_configuration_t conf)
 {
-    return ina226_reg_write(handle, INA226_REG_CONFIGURATION, *(uint16_t*)&conf);
+    return _reg_write(handle, INA226_REG_CONFIGURATION, _conf_pack(conf));
 }
 
 int ina226_set_mode(ina226_handle_t* handle, ina226_configuration_mode_t mode)
 {
-    int res = 0;
+    return ina226_reg_update(handle,
+                             INA226_REG_CONFIGURATION,
+                             REGMAP_MASK(INA226_CONF_MODE),
+                             REGMAP_VAL(INA226_CONF_MODE, mode));
+}
 
-    ina226_configuration_t conf;
-    res = ina226_get_configuration(handle, &conf);
-    CHECK_RESULT(res);
+uint32_t ina226_calc_conversion_time_us(ina226_configuration_t conf)
+{
+    uint32_t time = 0;
 
-    conf.mode = mode;
-    res = ina226_set_configuration(handle, conf);
-    CHECK_RESULT(res);
+    if (conf.mode & INA226_MODE_SHUNT)
+    {
+        time += _conv_time_us[conf.shunt_conv_time];
+    }
+    if (conf.mode & INA226_MODE_VBUS)
+    {
+        time += _conv_time_us[conf.vbus_conv_time];
+    }
 
-    return res;
+    return time * _average_count[conf.average];
 }
 
 int ina226_set_shunt_resistance(ina226_handle_t* handle, float shunt_resistance)
@@ -116,7 +150,7 @@ int ina226_get_voltage(ina226_handle_t* handle, float* value)
     uint16_t v;
     int res;
 
-    res = ina226_reg_read(handle, INA226_REG_BUS_VOLTAGE, &v);
+    res = _reg_read(handle, INA226_REG_BUS_VOLTAGE, &v);
     CHECK_RESULT(res);
 
     *value = VBUS_SENSE * (float)v;
@@ -129,7 +163,7 @@ int ina226_get_current(ina226_handle_t* handle, float* value)
     int16_t v;
     int res;
 
-    res = ina226_reg_read(handle, INA226_REG_SHUNT_VOLTAGE, (uint16_t*)&v);
+    res = _reg_read(handle, INA226_REG_SHUNT_VOLTAGE, (uint16_t*)&v);
     CHECK_RESULT(res);
 
     *value = handle->curr_sens * (float)v;
@@ -143,38 +177,154 @@ int ina226_get_power(ina226_handle_t* handle, float* power, float* voltage, floa
     int16_t raw_a;
     int res;
 
-    res = ina226_reg_read(handle, INA226_REG_SHUNT_VOLTAGE, (uint16_t*)&raw_a);
+    res = _reg_read(handle, INA226_REG_SHUNT_VOLTAGE, (uint16_t*)&raw_a);
     CHECK_RESULT(res);
-    res = ina226_reg_read(handle, INA226_REG_BUS_VOLTAGE, &raw_v);
+    res = _reg_read(handle, INA226_REG_BUS_VOLTAGE, &raw_v);
     CHECK_RESULT(res);
 
-    float v = VBUS_SENSE * (float)raw_v;
-    float a = handle->curr_sens * (float)raw_a;
+    ina226_calc_power(handle, raw_a, raw_v, power, voltage, current);
+
+    return res;
+}
+
+void ina226_calc_power(ina226_handle_t* handle,
+                       int16_t raw_shunt,
+                       uint16_t raw_vbus,
+                       float* power,
+                       float* voltage,
+                       float* current)
+{
+    float v = VBUS_SENSE * (float)raw_vbus;
+    float a = handle->curr_sens * (float)raw_shunt;
 
     SAFE_ASSIGN(current, a);
     SAFE_ASSIGN(voltage, v);
     SAFE_ASSIGN(power, v * a);
-
-    return res;
 }
 
 int ina226_get_mask(ina226_handle_t* handle, ina226_mask_t* value)
 {
-    return ina226_reg_read(handle, INA226_REG_MASK_ENABLE, (uint16_t*)value);
+    uint16_t raw;
+    int res;
+
+    res = _reg_read(handle, INA226_REG_MASK_ENABLE, &raw);
+    *value = _mask_unpack(raw);
+
+    return res;
 }
 
 int ina226_set_mask(ina226_handle_t* handle, ina226_mask_t value)
 {
-    return ina226_reg_write(handle, INA226_REG_MASK_ENABLE, *(uint16_t*)&value);
+    return _reg_write(handle, INA226_REG_MASK_ENABLE, _mask_pack(value));
 }
 
 int ina226_get_chip_info(ina226_handle_t* handle, ina226_chip_info_t* value)
 {
-    ina226_reg_read(handle, INA226_REG_MANUFACTURER, &value->manufacturer);
-    return ina226_reg_read(handle, INA226_REG_CHIP_ID, &value->chip_id);
+    _reg_read(handle, INA226_REG_MANUFACTURER, &value->manufacturer);
+    return _reg_read(handle, INA226_REG_CHIP_ID, &value->chip_id);
 }
 
 float ina226_calc_optimal_shunt(float current_max)
 {
     return SHUNT_VMAX / current_max;
 }
+
+static int _probe(ina226_handle_t* handle)
+{
+    int res = 0;
+
+    res = ina226_reset(handle);
+    CHECK_RESULT(res);
+
+    ina226_chip_info_t info;
+    res = ina226_get_chip_info(handle, &info);
+    CHECK_RESULT(res);
+
+    if ((info.chip_id != INA226_CHIP_IDENTIFIER) || (info.manufacturer != INA226_MANUFACTURER))
+    {
+        res = 1;
+    }
+
+    return res;
+}
+
+static int _io_reg_read(ina226_handle_t* handle, uint8_t reg, uint16_t* data)
+{
+    uint16_t tmp;
+    int res;
+
+    if (handle->transport != NULL)
+    {
+        uint8_t buf[2];
+
+        res = transport_reg_read(handle->transport, reg, buf, 2);
+        *data = ((uint16_t)buf[0] << 8) | buf[1];
+        return res;
+    }
+
+    res = handle->reg_read(reg, &tmp);
+    *data = (tmp >> 8) | (tmp << 8);
+    return res;
+}
+
+static int _io_reg_write(ina226_handle_t* handle, uint8_t reg, uint16_t data)
+{
+    if (handle->transport != NULL)
+    {
+        uint8_t buf[2] = {data >> 8, data & 0xFF};
+        return transport_reg_write(handle->transport, reg, buf, 2);
+    }
+
+    data = (data >> 8) | (data << 8);
+    return handle->reg_write(reg, data);
+}
+
+static uint16_t _conf_pack(ina226_configuration_t conf)
+{
+    return REGMAP_VAL(INA226_CONF_MODE, conf.mode) | REGMAP_VAL(INA226_CONF_SHUNT_CT, conf.shunt_conv_time) |
+           REGMAP_VAL(INA226_CONF_VBUS_CT, conf.vbus_conv_time) | REGMAP_VAL(INA226_CONF_AVERAGE, conf.average) |
+           REGMAP_VAL(INA226_CONF_RESET, conf.reset);
+}
+
+static ina226_configuration_t _conf_unpack(uint16_t raw)
+{
+    return (ina226_configuration_t){
+        .mode            = REGMAP_GET(raw, INA226_CONF_MODE),
+        .shunt_conv_time = REGMAP_GET(raw, INA226_CONF_SHUNT_CT),
+        .vbus_conv_time  = REGMAP_GET(raw, INA226_CONF_VBUS_CT),
+        .average         = REGMAP_GET(raw, INA226_CONF_AVERAGE),
+        .reset           = REGMAP_GET(raw, INA226_CONF_RESET),
+    };
+}
+
+static uint16_t _mask_pack(ina226_mask_t value)
+{
+    return REGMAP_VAL(INA226_MASK_ALERT_LATCH_EN, value.alert_latch_en) |
+           REGMAP_VAL(INA226_MASK_ALERT_POLARITY, value.alert_polarity) |
+           REGMAP_VAL(INA226_MASK_MATH_OVERFLOW, value.math_overflow_flag) |
+           REGMAP_VAL(INA226_MASK_CONV_READY_FLAG, value.conv_ready_flag) |
+           REGMAP_VAL(INA226_MASK_ALERT_FUNCTION, value.alert_function) |
+           REGMAP_VAL(INA226_MASK_CONV_READY_ALERT, value.conv_ready_alert) |
+           REGMAP_VAL(INA226_MASK_POWER_OVERLIMIT, value.power_overlimit_alert) |
+           REGMAP_VAL(INA226_MASK_VBUS_UNDER_LIMIT, value.vbus_under_limit_alert) |
+           REGMAP_VAL(INA226_MASK_VBUS_OVER_LIMIT, value.vbus_over_limit_alert) |
+           REGMAP_VAL(INA226_MASK_SHUNT_UNDER_LIMIT, value.shunt_under_limit_alert) |
+           REGMAP_VAL(INA226_MASK_SHUNT_OVER_LIMIT, value.shunt_over_limit_alert);
+}
+
+static ina226_mask_t _mask_unpack(uint16_t raw)
+{
+    return (ina226_mask_t){
+        .alert_latch_en          = REGMAP_GET(raw, INA226_MASK_ALERT_LATCH_EN),
+        .alert_polarity          = REGMAP_GET(raw, INA226_MASK_ALERT_POLARITY),
+        .math_overflow_flag      = REGMAP_GET(raw, INA226_MASK_MATH_OVERFLOW),
+        .conv_ready_flag         = REGMAP_GET(raw, INA226_MASK_CONV_READY_FLAG),
+        .alert_function          = REGMAP_GET(raw, INA226_MASK_ALERT_FUNCTION),
+        .conv_ready_alert        = REGMAP_GET(raw, INA226_MASK_CONV_READY_ALERT),
+        .power_overlimit_alert   = REGMAP_GET(raw, INA226_MASK_POWER_OVERLIMIT),
+        .vbus_under_limit_alert  = REGMAP_GET(raw, INA226_MASK_VBUS_UNDER_LIMIT),
+        .vbus_over_limit_alert   = REGMAP_GET(raw, INA226_MASK_VBUS_OVER_LIMIT),
+        .shunt_under_limit_alert = REGMAP_GET(raw, INA226_MASK_SHUNT_UNDER_LIMIT),
+        .shunt_over_limit_alert  = REGMAP_GET(raw, INA226_MASK_SHUNT_OVER_LIMIT),
+    };
+}
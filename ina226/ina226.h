@@ -2,6 +2,9 @@
 
 #include <stdint.h>
 
+#include "regmap.h"
+#include "transport.h"
+
 #define INA226_REG_CONFIGURATION 0x00
 #define INA226_REG_SHUNT_VOLTAGE 0x01
 #define INA226_REG_BUS_VOLTAGE   0x02
@@ -16,11 +19,33 @@
 #define INA226_MANUFACTURER    0x5449
 #define INA226_CHIP_IDENTIFIER 0x2260
 
+#define INA226_VBUS_LSB  (1.25e-3) // V
+#define INA226_SHUNT_LSB (2.5e-6)  // V
+
 #define INA226_ADDRESS1 0x40 // (A0+A1=GND)
 #define INA226_ADDRESS2 0x41 // (A0=Vcc, A1=GND)
 #define INA226_ADDRESS3 0x44 // (A0=GND, A1=Vcc)
 #define INA226_ADDRESS4 0x45 // (A0+A1=Vcc)
 
+// register fields as "shift, width", see regmap.h
+#define INA226_CONF_MODE     0, 3
+#define INA226_CONF_SHUNT_CT 3, 3
+#define INA226_CONF_VBUS_CT  6, 3
+#define INA226_CONF_AVERAGE  9, 3
+#define INA226_CONF_RESET    15, 1
+
+#define INA226_MASK_ALERT_LATCH_EN    0, 1
+#define INA226_MASK_ALERT_POLARITY    1, 1
+#define INA226_MASK_MATH_OVERFLOW     2, 1
+#define INA226_MASK_CONV_READY_FLAG   3, 1
+#define INA226_MASK_ALERT_FUNCTION    4, 1
+#define INA226_MASK_CONV_READY_ALERT  10, 1
+#define INA226_MASK_POWER_OVERLIMIT   11, 1
+#define INA226_MASK_VBUS_UNDER_LIMIT  12, 1
+#define INA226_MASK_VBUS_OVER_LIMIT   13, 1
+#define INA226_MASK_SHUNT_UNDER_LIMIT 14, 1
+#define INA226_MASK_SHUNT_OVER_LIMIT  15, 1
+
 typedef int (*ina266_reg_read_t)(uint8_t reg, uint16_t* data);
 typedef int (*ina266_reg_write_t)(uint8_t reg, uint16_t data);
 
@@ -28,14 +53,18 @@ typedef struct
 {
     ina266_reg_read_t reg_read;
     ina266_reg_write_t reg_write;
+    const transport_t* transport; // used instead of reg_read/reg_write when set
     float curr_sens;
 } ina226_handle_t;
 
 int ina226_init(ina226_handle_t* handle, ina266_reg_read_t read_cb, ina266_reg_write_t write_cb);
+int ina226_init_transport(ina226_handle_t* handle, const transport_t* transport);
 int ina226_reset(ina226_handle_t* handle);
 
 int ina226_reg_read(ina226_handle_t* handle, uint8_t reg, uint16_t* data);
 int ina226_reg_write(ina226_handle_t* handle, uint8_t reg, uint16_t data);
+//! Writes the bits selected by mask from value with a single read and write, e.g. several REGMAP_VAL() fields
+int ina226_reg_update(ina226_handle_t* handle, uint8_t reg, uint16_t mask, uint16_t value);
 
 typedef enum
 {
@@ -72,6 +101,7 @@ typedef enum
     INA226_AVERAGE_1024,
 } ina226_configuration_average_t;
 
+// decoded register, the wire layout is given by the INA226_CONF_* fields
 typedef struct
 {
     uint16_t mode : 3;
@@ -85,6 +115,8 @@ typedef struct
 int ina226_get_configuration(ina226_handle_t* handle, ina226_configuration_t* conf);
 int ina226_set_configuration(ina226_handle_t* handle, ina226_configuration_t conf);
 int ina226_set_mode(ina226_handle_t* handle, ina226_configuration_mode_t mode);
+//! Time from a triggered conversion (or the previous continuous one) to a fresh result, averaging included
+uint32_t ina226_calc_conversion_time_us(ina226_configuration_t conf);
 
 int ina226_set_shunt_resistance(ina226_handle_t* handle, float shunt_resistance);
 
@@ -97,7 +129,14 @@ int ina226_get_limitations(ina226_handle_t* handle,
 int ina226_get_voltage(ina226_handle_t* handle, float* value);
 int ina226_get_current(ina226_handle_t* handle, float* value);
 int ina226_get_power(ina226_handle_t* handle, float* power, float* voltage, float* current);
-
+void ina226_calc_power(ina226_handle_t* handle,
+                       int16_t raw_shunt,
+                       uint16_t raw_vbus,
+                       float* power,
+                       float* voltage,
+                       float* current);
+
+// decoded register, the wire layout is given by the INA226_MASK_* fields
 typedef struct
 {
     uint16_t alert_latch_en : 1;
@@ -0,0 +1,407 @@
+
+/* ===== INCLUDES =========================================================== */
+
+// clock_gettime() under -std=c11
+#define _POSIX_C_SOURCE 200809L
+
+#include "instr.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define RECORD_SIZE (24)
+
+/* ===== TYPES ============================================================== */
+
+typedef struct
+{
+    atomic_uintptr_t name;
+    atomic_uint_fast64_t calls;
+    atomic_uint_fast64_t transactions;
+    atomic_uint_fast64_t errors;
+    atomic_uint_fast64_t bytes_in;
+    atomic_uint_fast64_t bytes_out;
+    atomic_uint_fast64_t total_ns;
+    atomic_uint_fast64_t max_ns;
+    atomic_uint_least32_t hist[INSTR_HIST_BUCKETS];
+} instr_op_t;
+
+typedef struct
+{
+    instr_record_t records[INSTR_RING_SIZE];
+    atomic_uint_least16_t head;
+    atomic_uint_least16_t tail;
+} instr_ring_t;
+
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static uint64_t _clock_monotonic(void);
+static instr_op_t* _op_get(const char* name, uint16_t* id);
+static instr_ring_t* _ring_get(void);
+static uint8_t _bucket(uint64_t latency_ns);
+static void _max(atomic_uint_fast64_t* max, uint64_t value);
+static uint8_t* _put(uint8_t* out, uint64_t value, uint8_t size);
+static int _file_write(void* arg, const void* data, size_t size);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+
+static instr_clock_t _clock = _clock_monotonic;
+
+static instr_op_t _ops[INSTR_MAX_OPS];
+static atomic_uint_least16_t _order[INSTR_MAX_OPS]; // slot + 1 in publication order, 0 while unset
+static atomic_uint _op_count;
+
+static instr_ring_t _rings[INSTR_MAX_THREADS];
+static atomic_uint _ring_count;
+static atomic_uint_fast64_t _dropped;
+
+static _Thread_local instr_ring_t* _ring;
+static _Thread_local bool _ring_claimed;
+static _Thread_local uint64_t _start_ns;
+static _Thread_local const char* _scope;
+static _Thread_local uint32_t _scope_depth;
+
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+void instr_set_clock(instr_clock_t clock)
+{
+    _clock = (clock != NULL) ? clock : _clock_monotonic;
+}
+
+void instr_begin(void)
+{
+    _start_ns = _clock();
+}
+
+int instr_end(const char* op, int res, size_t bytes_in, size_t bytes_out, bool is_last)
+{
+    uint64_t latency   = _clock() - _start_ns;
+    instr_ring_t* ring = _ring_get();
+    uint16_t id        = 0;
+    instr_op_t* stats  = _op_get((_scope != NULL) ? _scope : op, &id);
+    uint16_t head;
+    uint16_t tail;
+
+    if (stats != NULL)
+    {
+        atomic_fetch_add_explicit(&stats->calls, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&stats->transactions, is_last ? 1 : 0, memory_order_relaxed);
+        atomic_fetch_add_explicit(&stats->errors, (res != 0) ? 1 : 0, memory_order_relaxed);
+        atomic_fetch_add_explicit(&stats->bytes_in, bytes_in, memory_order_relaxed);
+        atomic_fetch_add_explicit(&stats->bytes_out, bytes_out, memory_order_relaxed);
+        atomic_fetch_add_explicit(&stats->total_ns, latency, memory_order_relaxed);
+        atomic_fetch_add_explicit(&stats->hist[_bucket(latency)], 1, memory_order_relaxed);
+        _max(&stats->max_ns, latency);
+    }
+
+    if ((ring == NULL) || (stats == NULL))
+    {
+        atomic_fetch_add_explicit(&_dropped, 1, memory_order_relaxed);
+        return res;
+    }
+
+    head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if ((uint16_t)(head - tail) >= INSTR_RING_SIZE)
+    {
+        atomic_fetch_add_explicit(&_dropped, 1, memory_order_relaxed);
+        return res;
+    }
+
+    ring->records[head & (INSTR_RING_SIZE - 1)] = (instr_record_t){
+        .start_ns   = _start_ns,
+        .latency_ns = (latency > UINT32_MAX) ? UINT32_MAX : (uint32_t)latency,
+        .op         = id,
+        .bytes_in   = (bytes_in > UINT16_MAX) ? UINT16_MAX : (uint16_t)bytes_in,
+        .bytes_out  = (bytes_out > UINT16_MAX) ? UINT16_MAX : (uint16_t)bytes_out,
+        .error      = (res < INT16_MIN) ? INT16_MIN : (res > INT16_MAX) ? INT16_MAX : (int16_t)res,
+        .flags      = is_last ? INSTR_FLAG_LAST : 0,
+    };
+
+    atomic_store_explicit(&ring->head, (uint16_t)(head + 1), memory_order_release);
+
+    return res;
+}
+
+void instr_scope_enter(const char* op)
+{
+    if (_scope_depth++ == 0)
+    {
+        _scope = op;
+    }
+}
+
+int instr_scope_leave(int res)
+{
+    if (--_scope_depth == 0)
+    {
+        _scope = NULL;
+    }
+
+    return res;
+}
+
+size_t instr_op_count(void)
+{
+    return atomic_load_explicit(&_op_count, memory_order_acquire);
+}
+
+int instr_get_stats(size_t index, instr_stats_t* stats)
+{
+    uint16_t slot;
+    instr_op_t* op;
+
+    if (index >= INSTR_MAX_OPS)
+    {
+        return 1;
+    }
+
+    slot = atomic_load_explicit(&_order[index], memory_order_acquire);
+    if (slot == 0)
+    {
+        return 1;
+    }
+
+    op = &_ops[slot - 1];
+
+    stats->name         = (const char*)atomic_load_explicit(&op->name, memory_order_acquire);
+    stats->calls        = atomic_load_explicit(&op->calls, memory_order_relaxed);
+    stats->transactions = atomic_load_explicit(&op->transactions, memory_order_relaxed);
+    stats->errors       = atomic_load_explicit(&op->errors, memory_order_relaxed);
+    stats->bytes_in     = atomic_load_explicit(&op->bytes_in, memory_order_relaxed);
+    stats->bytes_out    = atomic_load_explicit(&op->bytes_out, memory_order_relaxed);
+    stats->total_ns     = atomic_load_explicit(&op->total_ns, memory_order_relaxed);
+    stats->max_ns       = atomic_load_explicit(&op->max_ns, memory_order_relaxed);
+
+    for (uint8_t i = 0; i < INSTR_HIST_BUCKETS; i++)
+    {
+        stats->hist[i] = atomic_load_explicit(&op->hist[i], memory_order_relaxed);
+    }
+
+    return 0;
+}
+
+void instr_reset_stats(void)
+{
+    for (size_t i = 0; i < INSTR_MAX_OPS; i++)
+    {
+        instr_op_t* op = &_ops[i];
+
+        atomic_store_explicit(&op->calls, 0, memory_order_relaxed);
+        atomic_store_explicit(&op->transactions, 0, memory_order_relaxed);
+        atomic_store_explicit(&op->errors, 0, memory_order_relaxed);
+        atomic_store_explicit(&op->bytes_in, 0, memory_order_relaxed);
+        atomic_store_explicit(&op->bytes_out, 0, memory_order_relaxed);
+        atomic_store_explicit(&op->total_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&op->max_ns, 0, memory_order_relaxed);
+
+        for (uint8_t b = 0; b < INSTR_HIST_BUCKETS; b++)
+        {
+            atomic_store_explicit(&op->hist[b], 0, memory_order_relaxed);
+        }
+    }
+
+    atomic_store_explicit(&_dropped, 0, memory_order_relaxed);
+}
+
+uint64_t instr_dropped(void)
+{
+    return atomic_load_explicit(&_dropped, memory_order_relaxed);
+}
+
+int instr_dump(instr_write_t write, void* arg)
+{
+    uint8_t buf[RECORD_SIZE];
+    uint8_t* out;
+    size_t ops         = instr_op_count();
+    unsigned int rings = atomic_load_explicit(&_ring_count, memory_order_acquire);
+    int res;
+
+    out = _put(buf, INSTR_TRACE_MAGIC, 4);
+    out = _put(out, INSTR_TRACE_VERSION, 2);
+    out = _put(out, ops, 2);
+
+    res = write(arg, buf, (size_t)(out - buf));
+    if (res != 0)
+    {
+        return res;
+    }
+
+    for (size_t i = 0; i < ops; i++)
+    {
+        uint16_t slot = atomic_load_explicit(&_order[i], memory_order_acquire);
+        const char* name;
+        size_t len;
+
+        if (slot == 0)
+        {
+            continue;
+        }
+
+        name = (const char*)atomic_load_explicit(&_ops[slot - 1].name, memory_order_acquire);
+        len  = strlen(name);
+        len  = (len > UINT8_MAX) ? UINT8_MAX : len;
+
+        out = _put(buf, slot - 1, 2);
+        out = _put(out, len, 1);
+
+        res = write(arg, buf, (size_t)(out - buf));
+        res |= write(arg, name, len);
+        if (res != 0)
+        {
+            return res;
+        }
+    }
+
+    rings = (rings > INSTR_MAX_THREADS) ? INSTR_MAX_THREADS : rings;
+
+    for (unsigned int t = 0; t < rings; t++)
+    {
+        instr_ring_t* ring = &_rings[t];
+        uint16_t tail      = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint16_t head      = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+        for (; tail != head; tail++)
+        {
+            const instr_record_t* rec = &ring->records[tail & (INSTR_RING_SIZE - 1)];
+
+            out = _put(buf, rec->start_ns, 8);
+            out = _put(out, rec->latency_ns, 4);
+            out = _put(out, rec->op, 2);
+            out = _put(out, rec->bytes_in, 2);
+            out = _put(out, rec->bytes_out, 2);
+            out = _put(out, (uint16_t)rec->error, 2);
+            out = _put(out, t, 1);
+            out = _put(out, rec->flags, 1);
+
+            res = write(arg, buf, RECORD_SIZE);
+            if (res != 0)
+            {
+                atomic_store_explicit(&ring->tail, tail, memory_order_release);
+                return res;
+            }
+        }
+
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+
+    return 0;
+}
+
+int instr_dump_file(const char* path)
+{
+    FILE* file = fopen(path, "wb");
+    int res;
+
+    if (file == NULL)
+    {
+        return 1;
+    }
+
+    res = instr_dump(_file_write, file);
+    res |= (fclose(file) != 0);
+
+    return res;
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static uint64_t _clock_monotonic(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static instr_op_t* _op_get(const char* name, uint16_t* id)
+{
+    uintptr_t key = (uintptr_t)name;
+    size_t slot   = (size_t)((key >> 3) ^ (key >> 11)) & (INSTR_MAX_OPS - 1);
+
+    // op names are string literals, so the pointer is the key
+    for (size_t probe = 0; probe < INSTR_MAX_OPS; probe++, slot = (slot + 1) & (INSTR_MAX_OPS - 1))
+    {
+        uintptr_t current = atomic_load_explicit(&_ops[slot].name, memory_order_acquire);
+
+        if (current == 0)
+        {
+            if (atomic_compare_exchange_strong_explicit(&_ops[slot].name,
+                                                        &current,
+                                                        key,
+                                                        memory_order_acq_rel,
+                                                        memory_order_acquire))
+            {
+                unsigned int index = atomic_fetch_add_explicit(&_op_count, 1, memory_order_acq_rel);
+
+                atomic_store_explicit(&_order[index], (uint16_t)(slot + 1), memory_order_release);
+                current = key;
+            }
+        }
+
+        if (current == key)
+        {
+            *id = (uint16_t)slot;
+            return &_ops[slot];
+        }
+    }
+
+    return NULL;
+}
+
+static instr_ring_t* _ring_get(void)
+{
+    if (!_ring_claimed)
+    {
+        unsigned int index = atomic_fetch_add_explicit(&_ring_count, 1, memory_order_acq_rel);
+
+        _ring_claimed = true;
+        _ring         = (index < INSTR_MAX_THREADS) ? &_rings[index] : NULL;
+    }
+
+    return _ring;
+}
+
+static uint8_t _bucket(uint64_t latency_ns)
+{
+    uint8_t bucket = 0;
+
+    while ((latency_ns >>= 1) != 0)
+    {
+        bucket++;
+    }
+
+    return (bucket < INSTR_HIST_BUCKETS) ? bucket : INSTR_HIST_BUCKETS - 1;
+}
+
+static void _max(atomic_uint_fast64_t* max, uint64_t value)
+{
+    uint_fast64_t current = atomic_load_explicit(max, memory_order_relaxed);
+
+    while ((value > current) &&
+           !atomic_compare_exchange_weak_explicit(max, &current, value, memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+}
+
+static uint8_t* _put(uint8_t* out, uint64_t value, uint8_t size)
+{
+    for (uint8_t i = 0; i < size; i++)
+    {
+        *out++ = (uint8_t)(value >> (8 * i));
+    }
+
+    return out;
+}
+
+static int _file_write(void* arg, const void* data, size_t size)
+{
+    return (fwrite(data, 1, size, arg) == size) ? 0 : 1;
+}
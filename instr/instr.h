@@ -0,0 +1,114 @@
+#ifndef __INSTR_H__
+#define __INSTR_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+#ifndef INSTR_MAX_OPS
+#define INSTR_MAX_OPS (128) // power of two
+#endif
+
+/*
+ * A thread claims a ring with its first record and keeps it after it exits, so
+ * at most INSTR_MAX_THREADS threads are traced over the life of the process.
+ * Later threads still update the op statistics, their records count as dropped.
+ */
+#ifndef INSTR_MAX_THREADS
+#define INSTR_MAX_THREADS (16)
+#endif
+
+#ifndef INSTR_RING_SIZE
+#define INSTR_RING_SIZE (256) // power of two
+#endif
+
+#define INSTR_HIST_BUCKETS (32)
+
+#define INSTR_FLAG_LAST (1 << 0) //! the call completed a bus transaction
+
+#define INSTR_TRACE_MAGIC   (0x52544E49) // "INTR"
+#define INSTR_TRACE_VERSION (1)
+
+/*
+ * Wraps a driver transport call. The op is named after the enclosing function, so
+ * a driver routes its transport helpers through it and every public function is
+ * accounted on its own. Without DRIVERS_INSTR the call is left untouched.
+ *
+ * INSTR_SCOPE() wraps the call a public function makes to a static helper doing
+ * bus I/O, e.g. a ROM selection or an interrupt rearm, so the helper's transfers
+ * are charged to the public function instead of the helper. The outermost scope
+ * of a thread names the op.
+ */
+#ifdef DRIVERS_INSTR
+#define INSTR_IO(call, bytes_in, bytes_out, is_last) \
+    (instr_begin(), instr_end(__func__, (call), (bytes_in), (bytes_out), (is_last)))
+#define INSTR_SCOPE(call) (instr_scope_enter(__func__), instr_scope_leave(call))
+#else
+#define INSTR_IO(call, bytes_in, bytes_out, is_last) (call)
+#define INSTR_SCOPE(call)                            (call)
+#endif
+
+/* ===== TYPES ============================================================== */
+
+typedef uint64_t (*instr_clock_t)(void);
+typedef int (*instr_write_t)(void* arg, const void* data, size_t size);
+
+typedef struct
+{
+    const char* name;
+    uint64_t calls;
+    uint64_t transactions;
+    uint64_t errors;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint32_t hist[INSTR_HIST_BUCKETS]; //! bucket i counts latencies in [2^i, 2^(i+1)) ns, 0 ns lands in bucket 0
+} instr_stats_t;
+
+/*
+ * Binary trace layout, all fields little-endian:
+ *   header   u32 magic, u16 version, u16 op count
+ *   op       u16 id, u8 name length, name (no terminator)
+ *   record   u64 start_ns, u32 latency_ns, u16 op, u16 bytes_in, u16 bytes_out,
+ *            i16 error, u8 thread, u8 flags (repeated up to the end of the trace)
+ */
+typedef struct
+{
+    uint64_t start_ns;
+    uint32_t latency_ns;
+    uint16_t op;
+    uint16_t bytes_in;
+    uint16_t bytes_out;
+    int16_t error;
+    uint8_t flags;
+} instr_record_t;
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+//! Replaces the default CLOCK_MONOTONIC time source
+void instr_set_clock(instr_clock_t clock);
+
+void instr_begin(void);
+int instr_end(const char* op, int res, size_t bytes_in, size_t bytes_out, bool is_last);
+
+void instr_scope_enter(const char* op);
+int instr_scope_leave(int res);
+
+size_t instr_op_count(void);
+int instr_get_stats(size_t index, instr_stats_t* stats);
+void instr_reset_stats(void);
+
+//! Records lost because a thread ring was full or no ring was left
+uint64_t instr_dropped(void);
+
+//! Drains the rings of all threads into a binary trace, each thread ring has a single reader
+int instr_dump(instr_write_t write, void* arg);
+int instr_dump_file(const char* path);
+
+#endif /* __INSTR_H__ */
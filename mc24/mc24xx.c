@@ -3,8 +3,16 @@
 
 #include "mc24xx.h"
 
+#include "instr.h"
+
 /* ===== DEFINITIONS ======================================================== */
 
+// transport calls are accounted to the calling function when built with DRIVERS_INSTR
+#define _read(self, data, size, is_last)  INSTR_IO(_io_read(self, data, size, is_last), size, 0, is_last)
+#define _write(self, data, size, is_last) INSTR_IO(_io_write(self, data, size, is_last), 0, size, is_last)
+#define _transfer(self, segs, count, size_in, size_out) \
+    INSTR_IO(_io_transfer(self, segs, count), size_in, size_out, true)
+
 #define IS_BIG_ENDIAN   \
     (!(union {          \
           uint16_t u16; \
@@ -24,39 +32,103 @@
 
 /* ===== TYPES ============================================================== */
 /* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static int _io_read(mc24xx_driver_t* self, void* data, size_t size, bool is_last);
+static int _io_write(mc24xx_driver_t* self, const void* data, size_t size, bool is_last);
+static int _io_transfer(mc24xx_driver_t* self, const transport_seg_t* segs, size_t count);
 /* ===== GLOBALS AND EXTERNS ================================================ */
 /* ===== LOCAL VARIABLES ==================================================== */
 /* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
 
 int mc24xx_read_data(mc24xx_driver_t* self, uint16_t address, void* data, uint16_t size)
 {
-    int res;
-
     address = THIS_IS_BE16(address);
 
-    self->write(&address, sizeof(address), false);
-    res = self->read(data, size, true);
+    // random read: the address write and the data read around a repeated START
+    transport_seg_t segs[] = {
+        {.data = &address, .size = sizeof(address), .flags = 0},
+        {.data = data, .size = size, .flags = TRANSPORT_FLAG_READ | TRANSPORT_FLAG_LAST},
+    };
 
-    return res;
+    return _transfer(self, segs, 2, size, sizeof(address));
 }
 
 int mc24xx_read_data_seq(mc24xx_driver_t* self, void* data, uint16_t size)
 {
     int res;
-    res = self->read(data, size, true);
+    res = _read(self, data, size, true);
     return res;
 }
 
 int mc24xx_write_data(mc24xx_driver_t* self, uint16_t address, const void* data, uint16_t size)
 {
-    int res;
-
     address = THIS_IS_BE16(address);
 
-    self->write(&address, sizeof(address), false);
-    res = self->write(data, size, true);
+    // the data continues the message of the address, straight from the caller's buffer
+    transport_seg_t segs[] = {
+        {.data = &address, .size = sizeof(address), .flags = 0},
+        {.data = (void*)data, .size = size, .flags = TRANSPORT_FLAG_LAST},
+    };
+
+    return _transfer(self, segs, 2, 0, sizeof(address) + size);
+}
+
+int mc24xx_poll_ready(mc24xx_driver_t* self, uint16_t max_polls)
+{
+    int res = 1;
+
+    for (uint16_t i = 0; (res != 0) && (i < max_polls); i++)
+    {
+        res = _write(self, NULL, 0, true);
+    }
 
     return res;
 }
 
 /* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static int _io_read(mc24xx_driver_t* self, void* data, size_t size, bool is_last)
+{
+    if (self->transport != NULL)
+    {
+        return transport_read(self->transport, data, size, is_last ? TRANSPORT_FLAG_LAST : 0);
+    }
+
+    return self->read(data, size, is_last);
+}
+
+static int _io_write(mc24xx_driver_t* self, const void* data, size_t size, bool is_last)
+{
+    if (self->transport != NULL)
+    {
+        return transport_write(self->transport, data, size, is_last ? TRANSPORT_FLAG_LAST : 0);
+    }
+
+    return self->write(data, size, is_last);
+}
+
+static int _io_transfer(mc24xx_driver_t* self, const transport_seg_t* segs, size_t count)
+{
+    int res = 0;
+
+    if (self->transport != NULL)
+    {
+        return transport_transfer(self->transport, segs, count);
+    }
+
+    for (size_t i = 0; (res == 0) && (i < count); i++)
+    {
+        bool is_last = (segs[i].flags & TRANSPORT_FLAG_LAST) != 0;
+
+        if (segs[i].flags & TRANSPORT_FLAG_READ)
+        {
+            res = self->read(segs[i].data, segs[i].size, is_last);
+        }
+        else
+        {
+            res = self->write(segs[i].data, segs[i].size, is_last);
+        }
+    }
+
+    return res;
+}
@@ -3,8 +3,12 @@
 
 /* ===== INCLUDES =========================================================== */
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "transport.h"
+
 /* ===== DEFINITIONS ======================================================== */
 
 #define MC24XX_I2C_ADDRESS_0 0xA0
@@ -18,6 +22,8 @@
 
 #define MC24XX_PAGE_SIZE 128
 
+#define MC24XX_WRITE_CYCLE_MS 5
+
 /* ===== TYPES ============================================================== */
 
 typedef int (*mc24xx_read_t)(void* data, size_t size, bool is_last);
@@ -27,6 +33,8 @@ typedef struct
 {
     mc24xx_read_t read;
     mc24xx_write_t write;
+
+    const transport_t* transport; //! used instead of read/write when set
 } mc24xx_driver_t;
 
 /* ===== GLOBALS AND EXTERNS ================================================ */
@@ -35,5 +43,7 @@ typedef struct
 int mc24xx_read_data(mc24xx_driver_t* self, uint16_t address, void* data, uint16_t size);
 int mc24xx_read_data_seq(mc24xx_driver_t* self, void* data, uint16_t size);
 int mc24xx_write_data(mc24xx_driver_t* self, uint16_t address, const void* data, uint16_t size);
+//! Acknowledge polling: returns 0 once the write cycle is over, the device NACKs its address until then
+int mc24xx_poll_ready(mc24xx_driver_t* self, uint16_t max_polls);
 
 #endif /* __MC24XX_H__ */
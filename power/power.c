@@ -0,0 +1,257 @@
+
+/* ===== INCLUDES =========================================================== */
+
+#include "power.h"
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define INA226_RECOVERY_US (40) // from shutdown
+
+#define SEC2US(sec) ((uint32_t)((sec)*1e6f + 0.5f))
+
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static int _ina226_start(void* ctx);
+static int _ina226_collect(void* ctx);
+static int _ina226_sleep(void* ctx);
+static int _tsl2591_start(void* ctx);
+static int _tsl2591_collect(void* ctx);
+static int _tsl2591_sleep(void* ctx);
+static int _vcnl4000_start(void* ctx);
+static int _vcnl4000_collect(void* ctx);
+static int _vcnl4010_start(void* ctx);
+static int _vcnl4010_collect(void* ctx);
+static int _si7006_start(void* ctx);
+static int _si7006_collect(void* ctx);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+int power_ina226_init(power_ina226_t* dev,
+                      acqsched_task_t* task,
+                      ina226_handle_t* handle,
+                      ina226_configuration_t conf,
+                      uint32_t period_us)
+{
+    dev->handle = handle;
+    dev->conf   = conf;
+
+    dev->conf.mode = INA226_MODE_SHUNT_AND_VBUS;
+    *task          = (acqsched_task_t){
+        .start     = _ina226_start,
+        .collect   = _ina226_collect,
+        .sleep     = _ina226_sleep,
+        .ctx       = dev,
+        .period_us = period_us,
+        .conv_us   = ina226_calc_conversion_time_us(dev->conf) + INA226_RECOVERY_US,
+    };
+
+    return _ina226_sleep(dev);
+}
+
+int power_tsl2591_init(power_tsl2591_t* dev,
+                       acqsched_task_t* task,
+                       tsl2591_driver_t* driver,
+                       tsl2591_reg_config_t config,
+                       uint32_t period_us)
+{
+    int res;
+
+    dev->driver = driver;
+    dev->config = config;
+
+    *task = (acqsched_task_t){
+        .start     = _tsl2591_start,
+        .collect   = _tsl2591_collect,
+        .sleep     = _tsl2591_sleep,
+        .ctx       = dev,
+        .period_us = period_us,
+        .conv_us   = tsl2591_calc_integr_time_ms(config) * 1000u,
+    };
+
+    res = tsl2591_write_config(driver, config);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    return _tsl2591_sleep(dev);
+}
+
+int power_vcnl4000_init(power_vcnl4000_t* dev,
+                        acqsched_task_t* task,
+                        vcnl4000_driver_t* driver,
+                        bool prox,
+                        bool alight,
+                        uint32_t period_us)
+{
+    dev->driver  = driver;
+    dev->command = (vcnl4000_reg_command_t){
+        .prox_ondemand   = prox,
+        .alight_ondemand = alight,
+    };
+
+    *task = (acqsched_task_t){
+        .start     = _vcnl4000_start,
+        .collect   = _vcnl4000_collect,
+        .ctx       = dev,
+        .period_us = period_us,
+        .conv_us   = alight ? SEC2US(VCNL4000_ALIGHT_CONVERSION_TIME) : SEC2US(VCNL4000_CONVERSION_TIME),
+    };
+
+    return 0;
+}
+
+int power_vcnl4010_init(power_vcnl4010_t* dev,
+                        acqsched_task_t* task,
+                        vcnl4010_driver_t* driver,
+                        bool prox,
+                        bool alight,
+                        uint32_t period_us)
+{
+    dev->driver  = driver;
+    dev->command = (vcnl4010_reg_command_t){
+        .prox_ondemand   = prox,
+        .alight_ondemand = alight,
+    };
+
+    *task = (acqsched_task_t){
+        .start     = _vcnl4010_start,
+        .collect   = _vcnl4010_collect,
+        .ctx       = dev,
+        .period_us = period_us,
+        .conv_us   = alight ? SEC2US(VCNL4010_ALIGHT_CONVERSION_TIME) : SEC2US(VCNL4010_CONVERSION_TIME),
+    };
+
+    return vcnl4010_write_command(driver, (vcnl4010_reg_command_t){0});
+}
+
+int power_si7006_init(power_si7006_t* dev,
+                      acqsched_task_t* task,
+                      si7006_driver_t* driver,
+                      bool is_rh,
+                      uint32_t period_us)
+{
+    dev->driver = driver;
+    dev->is_rh  = is_rh;
+
+    *task = (acqsched_task_t){
+        .start     = _si7006_start,
+        .collect   = _si7006_collect,
+        .ctx       = dev,
+        .period_us = period_us,
+        .conv_us   = si7006_get_conversion_time_ms(driver, is_rh) * 1000u,
+    };
+
+    return 0;
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static int _ina226_start(void* ctx)
+{
+    power_ina226_t* dev = ctx;
+
+    dev->conf.mode = INA226_MODE_SHUNT_AND_VBUS;
+
+    return ina226_set_configuration(dev->handle, dev->conf);
+}
+
+static int _ina226_collect(void* ctx)
+{
+    power_ina226_t* dev = ctx;
+
+    return ina226_get_power(dev->handle, &dev->power, &dev->voltage, &dev->current);
+}
+
+static int _ina226_sleep(void* ctx)
+{
+    power_ina226_t* dev = ctx;
+
+    dev->conf.mode = INA226_MODE_SHUTDOWN;
+
+    return ina226_set_configuration(dev->handle, dev->conf);
+}
+
+static int _tsl2591_start(void* ctx)
+{
+    power_tsl2591_t* dev = ctx;
+
+    return tsl2591_write_enable(dev->driver, (tsl2591_reg_enable_t){.power_on = 1, .als = 1});
+}
+
+static int _tsl2591_collect(void* ctx)
+{
+    power_tsl2591_t* dev = ctx;
+
+    return tsl2591_read_sample(dev->driver, &dev->sample);
+}
+
+static int _tsl2591_sleep(void* ctx)
+{
+    power_tsl2591_t* dev = ctx;
+
+    return tsl2591_write_enable(dev->driver, (tsl2591_reg_enable_t){0});
+}
+
+static int _vcnl4000_start(void* ctx)
+{
+    power_vcnl4000_t* dev = ctx;
+
+    return vcnl4000_write_command(dev->driver, dev->command);
+}
+
+static int _vcnl4000_collect(void* ctx)
+{
+    power_vcnl4000_t* dev = ctx;
+    int res;
+
+    res = vcnl4000_read_values(dev->driver, &dev->values, true);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    return ((dev->command.prox_ondemand && !dev->values.command.prox_ready) ||
+            (dev->command.alight_ondemand && !dev->values.command.alight_ready));
+}
+
+static int _vcnl4010_start(void* ctx)
+{
+    power_vcnl4010_t* dev = ctx;
+
+    return vcnl4010_write_command(dev->driver, dev->command);
+}
+
+static int _vcnl4010_collect(void* ctx)
+{
+    power_vcnl4010_t* dev = ctx;
+    int res;
+
+    res = vcnl4010_read_values(dev->driver, &dev->values, true);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    return ((dev->command.prox_ondemand && !dev->values.command.prox_ready) ||
+            (dev->command.alight_ondemand && !dev->values.command.alight_ready));
+}
+
+static int _si7006_start(void* ctx)
+{
+    power_si7006_t* dev = ctx;
+
+    return si7006_nohold_start(dev->driver, dev->is_rh);
+}
+
+static int _si7006_collect(void* ctx)
+{
+    power_si7006_t* dev = ctx;
+
+    // the Si7006 NACKs its address until the conversion is done, which is told apart from a bus fault by the
+    // deadline only
+    return (si7006_nohold_collect(dev->driver, &dev->value) != 0) ? 1 : 0;
+}
@@ -0,0 +1,108 @@
+#ifndef __POWER_H__
+#define __POWER_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ina226.h"
+#include "acqsched.h"
+#include "si7006.h"
+#include "tsl2591.h"
+#include "vcnl4000.h"
+#include "vcnl4010.h"
+
+/* ===== DEFINITIONS ======================================================== */
+/* ===== TYPES ============================================================== */
+
+/*
+ * Duty-cycled devices for the scheduler. Each init puts the device into its
+ * low-power state and fills in a task with the phases, latencies and the period,
+ * the task is then handed to acqsched_add(). Register images are cached so every
+ * power transition is a single write without a preceding read. Per cycle:
+ *   INA226   trigger, collect, shutdown       2 writes
+ *   TSL2591  power on with ALS, collect, off  2 writes
+ *   VCNL40x0 on-demand command, collect       1 write, idles on its own
+ *   Si7006   no-hold command, collect         1 command, idles on its own
+ * The power-up time is part of conv_us, e.g. the INA226 recovery from shutdown.
+ * conv_us is the nominal time, a result that is not ready then (TSL2591 sample
+ * not valid, VCNL40x0 ready bit clear, Si7006 NACK) is collected again later.
+ * The awake time per device is reported in acqsched_task_stats_t.
+ */
+
+typedef struct
+{
+    ina226_handle_t* handle;
+    ina226_configuration_t conf; //! mode is replaced by the phases
+    float power;
+    float voltage;
+    float current;
+} power_ina226_t;
+
+typedef struct
+{
+    tsl2591_driver_t* driver;
+    tsl2591_reg_config_t config;
+    tsl2591_sample_t sample;
+} power_tsl2591_t;
+
+typedef struct
+{
+    vcnl4000_driver_t* driver;
+    vcnl4000_reg_command_t command; //! on-demand bits of the measurements taken
+    vcnl4000_values_t values;
+} power_vcnl4000_t;
+
+typedef struct
+{
+    vcnl4010_driver_t* driver;
+    vcnl4010_reg_command_t command; //! on-demand bits of the measurements taken
+    vcnl4010_values_t values;
+} power_vcnl4010_t;
+
+typedef struct
+{
+    si7006_driver_t* driver;
+    bool is_rh;
+    uint16_t value;
+} power_si7006_t;
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+int power_ina226_init(power_ina226_t* dev,
+                      acqsched_task_t* task,
+                      ina226_handle_t* handle,
+                      ina226_configuration_t conf,
+                      uint32_t period_us);
+
+int power_tsl2591_init(power_tsl2591_t* dev,
+                       acqsched_task_t* task,
+                       tsl2591_driver_t* driver,
+                       tsl2591_reg_config_t config,
+                       uint32_t period_us);
+
+int power_vcnl4000_init(power_vcnl4000_t* dev,
+                        acqsched_task_t* task,
+                        vcnl4000_driver_t* driver,
+                        bool prox,
+                        bool alight,
+                        uint32_t period_us);
+
+//! Turns the self-timed measurements off, samples are taken on demand
+int power_vcnl4010_init(power_vcnl4010_t* dev,
+                        acqsched_task_t* task,
+                        vcnl4010_driver_t* driver,
+                        bool prox,
+                        bool alight,
+                        uint32_t period_us);
+
+//! The resolution must have been read or written before, see si7006_get_conversion_time_ms()
+int power_si7006_init(power_si7006_t* dev,
+                      acqsched_task_t* task,
+                      si7006_driver_t* driver,
+                      bool is_rh,
+                      uint32_t period_us);
+
+#endif /* __POWER_H__ */
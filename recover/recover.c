@@ -0,0 +1,242 @@
+
+/* ===== INCLUDES =========================================================== */
+
+#include "recover.h"
+
+/* ===== DEFINITIONS ======================================================== */
+/* ===== TYPES ============================================================== */
+
+typedef enum
+{
+    OP_READ,
+    OP_WRITE,
+    OP_RESET,
+    OP_TRANSFER,
+} op_kind_t;
+
+typedef struct
+{
+    op_kind_t kind;
+    void* data;
+    size_t size;
+    uint8_t flags;
+    const transport_seg_t* segs;
+} op_t;
+
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static int _read(const transport_t* self, void* data, size_t size, uint8_t flags);
+static int _write(const transport_t* self, const void* data, size_t size, uint8_t flags);
+static int _reset(const transport_t* self);
+static int _transfer(const transport_t* self, const transport_seg_t* segs, size_t count);
+static int _execute(recover_device_t* dev, const op_t* op, bool ends_tx, bool can_retry);
+static int _attempt(recover_device_t* dev, const op_t* op);
+static int _retry(recover_device_t* dev, const op_t* op);
+static void _settle(recover_device_t* dev, int res);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+void recover_bus_init(recover_bus_t* bus, recover_get_us_t get_us, recover_delay_t delay, recover_clear_t clear, void* arg)
+{
+    *bus = (recover_bus_t){
+        .get_us = get_us,
+        .delay  = delay,
+        .clear  = clear,
+        .arg    = arg,
+    };
+}
+
+const transport_t* recover_device_init(recover_device_t* dev,
+                                       recover_bus_t* bus,
+                                       const transport_t* inner,
+                                       const recover_policy_t* policy,
+                                       bool is_onewire)
+{
+    *dev = (recover_device_t){
+        .inner      = inner,
+        .bus        = bus,
+        .policy     = *policy,
+        .is_onewire = is_onewire,
+        .state      = RECOVER_CLOSED,
+    };
+
+    dev->transport = (transport_t){
+        .ctx      = dev,
+        .bus      = inner->bus,
+        .address  = inner->address,
+        .read     = _read,
+        .write    = _write,
+        .reset    = (inner->reset != NULL) ? _reset : NULL,
+        .transfer = _transfer,
+    };
+
+    return &dev->transport;
+}
+
+recover_state_t recover_get_state(recover_device_t* dev)
+{
+    if ((dev->state == RECOVER_OPEN) && (dev->bus->get_us() >= dev->reopen_us))
+    {
+        dev->state = RECOVER_HALF_OPEN;
+    }
+
+    return dev->state;
+}
+
+void recover_device_rearm(recover_device_t* dev)
+{
+    dev->state  = RECOVER_CLOSED;
+    dev->failed = 0;
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static int _read(const transport_t* self, void* data, size_t size, uint8_t flags)
+{
+    recover_device_t* dev = self->ctx;
+    op_t op               = {.kind = OP_READ, .data = data, .size = size, .flags = flags};
+
+    return _execute(dev, &op, dev->is_onewire || (flags & TRANSPORT_FLAG_LAST), !dev->is_onewire);
+}
+
+static int _write(const transport_t* self, const void* data, size_t size, uint8_t flags)
+{
+    recover_device_t* dev = self->ctx;
+    op_t op               = {.kind = OP_WRITE, .data = (void*)data, .size = size, .flags = flags};
+
+    return _execute(dev, &op, dev->is_onewire || (flags & TRANSPORT_FLAG_LAST), !dev->is_onewire);
+}
+
+static int _reset(const transport_t* self)
+{
+    recover_device_t* dev = self->ctx;
+    op_t op               = {.kind = OP_RESET};
+
+    return _execute(dev, &op, true, true);
+}
+
+static int _transfer(const transport_t* self, const transport_seg_t* segs, size_t count)
+{
+    recover_device_t* dev = self->ctx;
+    op_t op               = {.kind = OP_TRANSFER, .segs = segs, .size = count};
+
+    return _execute(dev, &op, true, !dev->is_onewire);
+}
+
+static int _execute(recover_device_t* dev, const op_t* op, bool ends_tx, bool can_retry)
+{
+    int res;
+
+    // Continuation of a transaction, its start has already been admitted
+    if (dev->tx_open)
+    {
+        res = _attempt(dev, op);
+    }
+    else
+    {
+        if (recover_get_state(dev) == RECOVER_OPEN)
+        {
+            dev->stats.rejected++;
+            return RECOVER_ERR_OPEN;
+        }
+
+        dev->stats.operations++;
+        res = can_retry ? _retry(dev, op) : _attempt(dev, op);
+    }
+
+    // The backends end the transaction on a failed transfer
+    dev->tx_open = !ends_tx && (res == 0);
+    if (!dev->tx_open)
+    {
+        _settle(dev, res);
+    }
+
+    return res;
+}
+
+static int _attempt(recover_device_t* dev, const op_t* op)
+{
+    switch (op->kind)
+    {
+        case OP_READ:
+            return transport_read(dev->inner, op->data, op->size, op->flags);
+        case OP_WRITE:
+            return transport_write(dev->inner, op->data, op->size, op->flags);
+        case OP_RESET:
+            return transport_reset(dev->inner);
+        case OP_TRANSFER:
+            return transport_transfer(dev->inner, op->segs, op->size);
+    }
+
+    return 1;
+}
+
+static int _retry(recover_device_t* dev, const op_t* op)
+{
+    const recover_policy_t* policy = &dev->policy;
+    recover_bus_t* bus             = dev->bus;
+    uint64_t start                 = bus->get_us();
+    uint32_t backoff               = policy->backoff_us;
+    uint8_t retries                = (dev->state == RECOVER_HALF_OPEN) ? 0 : policy->retries;
+    int res;
+
+    res = _attempt(dev, op);
+
+    for (uint8_t i = 1; (res != 0) && (i <= retries); i++)
+    {
+        if ((policy->budget_us != 0) && (bus->get_us() - start + backoff > policy->budget_us))
+        {
+            break;
+        }
+
+        if ((policy->clear_after != 0) && (i % policy->clear_after == 0) && (bus->clear != NULL))
+        {
+            bus->clear(bus->arg);
+            bus->clears++;
+        }
+
+        if ((backoff != 0) && (bus->delay != NULL))
+        {
+            bus->delay(bus->arg, backoff);
+        }
+
+        backoff = (backoff > policy->backoff_max_us / 2) ? policy->backoff_max_us : backoff * 2;
+
+        dev->stats.retries++;
+        res = _attempt(dev, op);
+    }
+
+    return res;
+}
+
+static void _settle(recover_device_t* dev, int res)
+{
+    if (res == 0)
+    {
+        dev->state  = RECOVER_CLOSED;
+        dev->failed = 0;
+        return;
+    }
+
+    dev->stats.failures++;
+    if (dev->failed < UINT8_MAX)
+    {
+        dev->failed++;
+    }
+
+    if ((dev->state == RECOVER_HALF_OPEN) ||
+        ((dev->policy.trip_after != 0) && (dev->failed >= dev->policy.trip_after)))
+    {
+        dev->state     = RECOVER_OPEN;
+        dev->reopen_us = dev->bus->get_us() + dev->policy.cooloff_us;
+        dev->failed    = 0;
+        dev->stats.trips++;
+
+        if (dev->policy.reset != NULL)
+        {
+            dev->policy.reset(dev->inner);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef __RECOVER_H__
+#define __RECOVER_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "transport.h"
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define RECOVER_ERR_OPEN (-3) //! the breaker is open, the device was not accessed
+
+/* ===== TYPES ============================================================== */
+
+typedef uint64_t (*recover_get_us_t)(void);
+typedef void (*recover_delay_t)(void* arg, uint32_t us);
+typedef int (*recover_clear_t)(void* arg);
+typedef int (*recover_reset_t)(const transport_t* inner);
+
+typedef enum
+{
+    RECOVER_CLOSED,    //! normal operation
+    RECOVER_OPEN,      //! failing, operations are rejected until the cool-off ends
+    RECOVER_HALF_OPEN, //! cool-off over, the next operation is a single probe
+} recover_state_t;
+
+/*
+ * Platform hooks shared by the devices of one bus. clear frees a bus held by a
+ * slave that lost track of the transfer: up to 9 SCL pulses until SDA is released,
+ * followed by a STOP (by GPIO or the controller's recovery feature). It may be
+ * NULL, as may delay for busy loops without backoff.
+ */
+typedef struct
+{
+    recover_get_us_t get_us;
+    recover_delay_t delay;
+    recover_clear_t clear;
+    void* arg;
+
+    uint32_t clears;
+} recover_bus_t;
+
+typedef struct
+{
+    uint8_t retries;         //! further attempts after a failed one
+    uint32_t backoff_us;     //! before the first retry, doubled for every further one
+    uint32_t backoff_max_us;
+    uint32_t budget_us;      //! no retry is started beyond this time since the first attempt, 0 for no limit
+    uint8_t clear_after;     //! failed attempts in a row before each bus clear, 0 disables it
+    uint8_t trip_after;      //! failed operations in a row opening the breaker, 0 disables it
+    uint32_t cooloff_us;
+    recover_reset_t reset;   //! optional, run when the breaker opens, e.g. a soft reset
+} recover_policy_t;
+
+typedef struct
+{
+    uint64_t operations;
+    uint64_t retries;
+    uint64_t failures; //! operations failed after all retries
+    uint64_t rejected; //! operations refused while the breaker was open
+    uint32_t trips;
+} recover_stats_t;
+
+/*
+ * Transport wrapper retrying failed operations under a policy. An operation is
+ * a whole I2C transaction when the driver hands it over as a transfer, otherwise
+ * the first read or write of a transaction, e.g. the address phase a 24xx NACKs
+ * during its write cycle. A failure later in a transaction cannot be repeated on
+ * its own and is passed through. On 1-Wire only the reset is retried, until a
+ * presence pulse is seen.
+ *
+ * Every operation that still fails counts towards the breaker, which rejects the
+ * device for cooloff_us once it opens, so a dead device costs no bus time and
+ * the worst case of an operation is bounded by the retries and the budget.
+ * Not thread-safe, wrap a busmgr device when the bus is shared between threads.
+ */
+typedef struct
+{
+    transport_t transport;
+    const transport_t* inner;
+    recover_bus_t* bus;
+    recover_policy_t policy;
+    bool is_onewire;
+
+    bool tx_open;
+    recover_state_t state;
+    uint8_t failed;     //! operations failed in a row
+    uint64_t reopen_us;
+    recover_stats_t stats;
+} recover_device_t;
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+void recover_bus_init(recover_bus_t* bus, recover_get_us_t get_us, recover_delay_t delay, recover_clear_t clear, void* arg);
+
+//! Returns the transport to hand to the driver
+const transport_t* recover_device_init(recover_device_t* dev,
+                                       recover_bus_t* bus,
+                                       const transport_t* inner,
+                                       const recover_policy_t* policy,
+                                       bool is_onewire);
+
+//! Updates an open breaker whose cool-off has ended to half-open
+recover_state_t recover_get_state(recover_device_t* dev);
+
+//! Closes the breaker, e.g. after the device has been replaced
+void recover_device_rearm(recover_device_t* dev);
+
+#endif /* __RECOVER_H__ */
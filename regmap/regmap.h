@@ -0,0 +1,54 @@
+#ifndef __REGMAP_H__
+#define __REGMAP_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include <stdint.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+/*
+ * Register fields are described as "shift, width" pairs, e.g.
+ *
+ *   #define INA226_CONF_MODE 0, 3
+ *
+ * and every accessor below folds to constant masks and shifts, so the generated
+ * code is the one of a hand written mask and shift. Unlike C bitfields the bit
+ * positions do not depend on the compiler or its ABI, and raw register words are
+ * never accessed through a pointer to another type.
+ *
+ * Drivers still hand out decoded bitfield structs, and filling one costs a mask
+ * and an insert per field. Register reads through them are therefore somewhat
+ * larger than the former type punned byte copies, most of all for registers with
+ * many fields; code working on raw words with REGMAP_GET() does not pay this.
+ */
+
+#define REGMAP_SHIFT(...) _REGMAP_SHIFT(__VA_ARGS__)
+#define REGMAP_WIDTH(...) _REGMAP_WIDTH(__VA_ARGS__)
+#define REGMAP_MASK(...)  _REGMAP_MASK(__VA_ARGS__)
+
+//! REGMAP_GET(raw, field): field value extracted from a raw register
+#define REGMAP_GET(raw, ...) _REGMAP_GET(raw, __VA_ARGS__)
+
+//! REGMAP_VAL(field, value): value placed at the field position, fields of one register are combined with |
+#define REGMAP_VAL(...) _REGMAP_VAL(__VA_ARGS__)
+
+//! REGMAP_SET(raw, field, value): raw register with one field replaced
+#define REGMAP_SET(raw, ...) _REGMAP_SET(raw, __VA_ARGS__)
+
+//! Multi-field update, mask selects the bits taken from value
+#define REGMAP_UPDATE(raw, mask, value) (((raw) & ~(mask)) | ((value) & (mask)))
+
+// the field expands to two arguments, hence the extra level of indirection
+#define _REGMAP_SHIFT(shift, width)           (shift)
+#define _REGMAP_WIDTH(shift, width)           (width)
+#define _REGMAP_MASK(shift, width)            ((uint32_t)((1ull << (width)) - 1u) << (shift))
+#define _REGMAP_GET(raw, shift, width)        (((uint32_t)(raw) >> (shift)) & (uint32_t)((1ull << (width)) - 1u))
+#define _REGMAP_VAL(shift, width, value)      (((uint32_t)(value) << (shift)) & _REGMAP_MASK(shift, width))
+#define _REGMAP_SET(raw, shift, width, value) (((raw) & ~_REGMAP_MASK(shift, width)) | _REGMAP_VAL(shift, width, value))
+
+/* ===== TYPES ============================================================== */
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+#endif /* __REGMAP_H__ */
@@ -3,8 +3,18 @@
 
 #include "si7006.h"
 
+#include <stddef.h>
+
+#include "instr.h"
+
 /* ===== DEFINITIONS ======================================================== */
 
+// transport calls are accounted to the calling function when built with DRIVERS_INSTR
+#define _read(self, data, size, is_last)  INSTR_IO(_io_read(self, data, size, is_last), size, 0, is_last)
+#define _write(self, data, size, is_last) INSTR_IO(_io_write(self, data, size, is_last), 0, size, is_last)
+#define _command_read(self, cmd, data, size) \
+    INSTR_IO(_io_command_read(self, cmd, sizeof(cmd), data, size), size, sizeof(cmd), true)
+
 #define RETURN_CONDITIONAL(res, desired) \
     if ((res) != (desired))              \
     {                                    \
@@ -35,43 +45,13 @@
     }
 
 /* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
 
-typedef enum
-{
-    SI7006_CMD_MEASURE_RH          = 0xE5,
-    SI7006_CMD_NOHOLD_MEASURE_RH   = 0xF5,
-    SI7006_CMD_MEASURE_TEMP        = 0xE3,
-    SI7006_CMD_NOHOLD_MEASURE_TEMP = 0xF3,
-    SI7006_CMD_READ_TEMP           = 0xE0,
-    SI7006_CMD_RESET               = 0xFE,
-    SI7006_CMD_WRITE_RHT           = 0xE6,
-    SI7006_CMD_READ_RHT            = 0xE7,
-    SI7006_CMD_WRITE_HEATER_CTRL   = 0x51,
-    SI7006_CMD_READ_HEATER_CTRL    = 0x11,
-    SI7006_CMD_READ_EID0_0         = 0xFA,
-    SI7006_CMD_READ_EID0_1         = 0x0F,
-    SI7006_CMD_READ_EID1_0         = 0xFC,
-    SI7006_CMD_READ_EID1_1         = 0xC9,
-    SI7006_CMD_READ_FW_REVISION_0  = 0x84,
-    SI7006_CMD_READ_FW_REVISION_1  = 0xB8,
-} si7006_cmd_t;
-
-typedef union
-{
-    uint8_t value;
-
-    struct
-    {
-        uint8_t res0       : 1;
-        uint8_t            : 1;
-        uint8_t heater_en  : 1;
-        uint8_t            : 3;
-        uint8_t vdd_status : 1;
-        uint8_t res1       : 1;
-    };
-} si7006_reg_user_t;
+static int _io_read(si7006_driver_t* self, void* data, uint8_t size, bool is_last);
+static int _io_write(si7006_driver_t* self, const void* data, uint8_t size, bool is_last);
+static int _io_command_read(si7006_driver_t* self, const void* cmd, uint8_t cmd_size, void* data, uint8_t size);
+static void _setup_cache(si7006_driver_t* self, uint8_t user);
 
-/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
 /* ===== GLOBALS AND EXTERNS ================================================ */
 /* ===== LOCAL VARIABLES ==================================================== */
 
@@ -95,17 +75,14 @@ int si7006_write_setup(si7006_driver_t* self, si7006_setup_resolution_t resoluti
 {
     uint8_t out_data[] = {
         SI7006_CMD_WRITE_RHT,
-        (si7006_reg_user_t){
-            .heater_en = heater_en,
-            .res0      = resolution & 1,
-            .res1      = (resolution >> 1) & 1,
-        }
-            .value,
+        REGMAP_VAL(SI7006_USER_HEATER_EN, heater_en) |
+            REGMAP_VAL(SI7006_USER_RES0, resolution & 1) |
+            REGMAP_VAL(SI7006_USER_RES1, (resolution >> 1) & 1),
     };
 
     int res;
 
-    res = self->write(&out_data, sizeof(out_data), true);
+    res = _write(self, &out_data, sizeof(out_data), true);
     RETURN_CONDITIONAL(res, 0);
 
     self->heater_en  = heater_en;
@@ -116,22 +93,18 @@ int si7006_write_setup(si7006_driver_t* self, si7006_setup_resolution_t resoluti
 
 int si7006_read_setup(si7006_driver_t* self, si7006_setup_resolution_t* resolution, bool* heater_en, bool* vdd_ok)
 {
-    const uint8_t const out_data[] = {
+    const uint8_t out_data[] = {
         SI7006_CMD_READ_RHT,
     };
 
-    si7006_reg_user_t in_data;
+    uint8_t in_data;
 
     int res;
-    self->heater_en  = heater_en;
-    self->resolution = resolution;
 
-    self->write(&out_data, sizeof(out_data), false);
-    res = self->write(&in_data, sizeof(in_data), true);
+    res = _command_read(self, out_data, &in_data, sizeof(in_data));
+    RETURN_CONDITIONAL(res, 0);
 
-    self->heater_en  = in_data.heater_en;
-    self->resolution = in_data.res0 | (in_data.res0 << 1);
-    self->vdd_ok     = (in_data.vdd_status == 0);
+    _setup_cache(self, in_data);
 
     SAFE_ASSIGN(resolution, self->resolution);
     SAFE_ASSIGN(heater_en, self->heater_en);
@@ -140,16 +113,44 @@ int si7006_read_setup(si7006_driver_t* self, si7006_setup_resolution_t* resoluti
     return res;
 }
 
+int si7006_update_setup(si7006_driver_t* self, uint8_t mask, uint8_t value)
+{
+    const uint8_t read_cmd[] = {
+        SI7006_CMD_READ_RHT,
+    };
+
+    uint8_t out_data[] = {
+        SI7006_CMD_WRITE_RHT,
+        0,
+    };
+
+    int res;
+
+    res = _command_read(self, read_cmd, &out_data[1], 1);
+    RETURN_CONDITIONAL(res, 0);
+
+    out_data[1] = REGMAP_UPDATE(out_data[1], mask, value);
+
+    res = _write(self, &out_data, sizeof(out_data), true);
+    RETURN_CONDITIONAL(res, 0);
+
+    _setup_cache(self, out_data[1]);
+
+    return res;
+}
+
 int si7006_read_heater_ctrl(si7006_driver_t* self, si7006_reg_heater_ctrl_t* value)
 {
-    const uint8_t const out_data[] = {
+    const uint8_t out_data[] = {
         SI7006_CMD_READ_HEATER_CTRL,
     };
 
+    uint8_t raw;
     int res;
 
-    self->write(&out_data, sizeof(out_data), false);
-    res = self->read(value, 1, true);
+    res = _command_read(self, out_data, &raw, 1);
+
+    value->current = REGMAP_GET(raw, SI7006_HEATER_CTRL_CURRENT);
 
     return res;
 }
@@ -157,19 +158,19 @@ int si7006_write_heater_ctrl(si7006_driver_t* self, si7006_reg_heater_ctrl_t val
 {
     uint8_t out_data[] = {
         SI7006_CMD_WRITE_HEATER_CTRL,
-        (uint8_t)value,
+        REGMAP_VAL(SI7006_HEATER_CTRL_CURRENT, value.current),
     };
 
     int res;
 
-    res = self->write(&out_data, sizeof(out_data), false);
+    res = _write(self, &out_data, sizeof(out_data), true);
 
     return res;
 }
 
 int si7006_read_eid(si7006_driver_t* self, si7006_reg_eid_t* value)
 {
-    const uint8_t const out_data[2][2] = {
+    const uint8_t out_data[2][2] = {
         {
             SI7006_CMD_READ_EID0_0,
             SI7006_CMD_READ_EID0_1,
@@ -183,8 +184,7 @@ int si7006_read_eid(si7006_driver_t* self, si7006_reg_eid_t* value)
     int res;
     uint8_t in_data[8];
 
-    self->write(&out_data[0], sizeof(out_data[0]), false);
-    res = self->read(&in_data, 8, true);
+    res = _command_read(self, out_data[0], &in_data, 8);
     RETURN_CONDITIONAL(res, 0);
 
     value->id[4] = in_data[6];
@@ -192,8 +192,7 @@ int si7006_read_eid(si7006_driver_t* self, si7006_reg_eid_t* value)
     value->id[6] = in_data[2];
     value->id[7] = in_data[0];
 
-    res = self->write(&out_data[1], sizeof(out_data[1]), false);
-    res |= self->read(&in_data, 6, true);
+    res = _command_read(self, out_data[1], &in_data, 6);
     RETURN_CONDITIONAL(res, 0);
 
     value->id[0] = in_data[4];
@@ -206,30 +205,34 @@ int si7006_read_eid(si7006_driver_t* self, si7006_reg_eid_t* value)
 
 int si7006_read_fw_revision(si7006_driver_t* self, si7006_reg_revision_t* value)
 {
-    const uint8_t const out_data[] = {
+    const uint8_t out_data[] = {
         SI7006_CMD_READ_FW_REVISION_0,
         SI7006_CMD_READ_FW_REVISION_1,
     };
 
     int res;
 
-    self->write(&out_data, sizeof(out_data), false);
-    res = self->read(value, 1, true);
+    res = _command_read(self, out_data, &value->full, 1);
 
     return res;
 }
 
+uint16_t si7006_get_conversion_time_ms(si7006_driver_t* self, bool is_rh)
+{
+    return is_rh ? _tconv_rht[self->resolution] : _tconv_t[self->resolution];
+}
+
 int si7006_measure_temp(si7006_driver_t* self, uint16_t* value)
 {
-    const uint8_t const out_data[] = {
+    const uint8_t out_data[] = {
         SI7006_CMD_MEASURE_TEMP,
     };
 
     int res;
 
-    self->write(&out_data, sizeof(out_data), false);
+    _write(self, &out_data, sizeof(out_data), false);
     self->wait(_tconv_t[self->resolution]);
-    res = self->read(value, 2, true);
+    res = _read(self, value, 2, true);
 
     *value = FROM_BE16(*value);
 
@@ -238,15 +241,21 @@ int si7006_measure_temp(si7006_driver_t* self, uint16_t* value)
 
 int si7006_nohold_measure_temp(si7006_driver_t* self, uint16_t* value)
 {
-    const uint8_t const out_data[] = {
+    const uint8_t out_data[] = {
         SI7006_CMD_NOHOLD_MEASURE_TEMP,
     };
 
     int res;
 
-    self->write(&out_data, sizeof(out_data), false);
+    // the command ends its transaction, the conversion runs without holding the bus
+    res = _write(self, &out_data, sizeof(out_data), true);
+    if (res != 0)
+    {
+        return res;
+    }
+
     self->wait(_tconv_t[self->resolution]);
-    res = self->read(value, 2, true);
+    res = _read(self, value, 2, true);
 
     *value = FROM_BE16(*value);
 
@@ -255,15 +264,15 @@ int si7006_nohold_measure_temp(si7006_driver_t* self, uint16_t* value)
 
 int si7006_measure_rh(si7006_driver_t* self, uint16_t* value)
 {
-    const uint8_t const out_data[] = {
+    const uint8_t out_data[] = {
         SI7006_CMD_MEASURE_RH,
     };
 
     int res;
 
-    self->write(&out_data, sizeof(out_data), false);
+    _write(self, &out_data, sizeof(out_data), false);
     self->wait(_tconv_rht[self->resolution]);
-    res = self->read(value, 2, true);
+    res = _read(self, value, 2, true);
 
     *value = FROM_BE16(*value);
 
@@ -272,15 +281,41 @@ int si7006_measure_rh(si7006_driver_t* self, uint16_t* value)
 
 int si7006_nohold_measure_rh(si7006_driver_t* self, uint16_t* value)
 {
-    const uint8_t const out_data[] = {
+    const uint8_t out_data[] = {
         SI7006_CMD_NOHOLD_MEASURE_RH,
     };
 
     int res;
 
-    self->write(&out_data, sizeof(out_data), false);
+    // the command ends its transaction, the conversion runs without holding the bus
+    res = _write(self, &out_data, sizeof(out_data), true);
+    if (res != 0)
+    {
+        return res;
+    }
+
     self->wait(_tconv_rht[self->resolution]);
-    res = self->read(value, 2, true);
+    res = _read(self, value, 2, true);
+
+    *value = FROM_BE16(*value);
+
+    return res;
+}
+
+int si7006_nohold_start(si7006_driver_t* self, bool is_rh)
+{
+    const uint8_t out_data[] = {
+        is_rh ? SI7006_CMD_NOHOLD_MEASURE_RH : SI7006_CMD_NOHOLD_MEASURE_TEMP,
+    };
+
+    return _write(self, &out_data, sizeof(out_data), true);
+}
+
+int si7006_nohold_collect(si7006_driver_t* self, uint16_t* value)
+{
+    int res;
+
+    res = _read(self, value, 2, true);
 
     *value = FROM_BE16(*value);
 
@@ -288,3 +323,46 @@ int si7006_nohold_measure_rh(si7006_driver_t* self, uint16_t* value)
 }
 
 /* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static int _io_read(si7006_driver_t* self, void* data, uint8_t size, bool is_last)
+{
+    if (self->transport != NULL)
+    {
+        return transport_read(self->transport, data, size, is_last ? TRANSPORT_FLAG_LAST : 0);
+    }
+
+    return self->read(data, size, is_last);
+}
+
+static int _io_write(si7006_driver_t* self, const void* data, uint8_t size, bool is_last)
+{
+    if (self->transport != NULL)
+    {
+        return transport_write(self->transport, data, size, is_last ? TRANSPORT_FLAG_LAST : 0);
+    }
+
+    return self->write(data, size, is_last);
+}
+
+static int _io_command_read(si7006_driver_t* self, const void* cmd, uint8_t cmd_size, void* data, uint8_t size)
+{
+    transport_seg_t segs[] = {
+        {.data = (void*)cmd, .size = cmd_size, .flags = 0},
+        {.data = data, .size = size, .flags = TRANSPORT_FLAG_READ | TRANSPORT_FLAG_LAST},
+    };
+
+    if (self->transport != NULL)
+    {
+        return transport_transfer(self->transport, segs, 2);
+    }
+
+    self->write(cmd, cmd_size, false);
+    return self->read(data, size, true);
+}
+
+static void _setup_cache(si7006_driver_t* self, uint8_t user)
+{
+    self->heater_en  = REGMAP_GET(user, SI7006_USER_HEATER_EN);
+    self->resolution = REGMAP_GET(user, SI7006_USER_RES0) | (REGMAP_GET(user, SI7006_USER_RES1) << 1);
+    self->vdd_ok     = (REGMAP_GET(user, SI7006_USER_VDD_STATUS) == 0);
+}
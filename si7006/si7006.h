@@ -6,12 +6,20 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "regmap.h"
+#include "transport.h"
+
 /* ===== DEFINITIONS ======================================================== */
 
 #define SI7006_I2C_ADDRESS (0x40)
 
-#define SI7006_RH_RAW2PHYS(raw)   ((raw)*1.90734e-3f - 6.0f)
-#define SI7006_TEMP_RAW2PHYS(raw) ((raw)*2.68127e-3f - 46.85f)
+#define SI7006_RH_SCALE    (1.90734e-3f)
+#define SI7006_RH_OFFSET   (-6.0f)
+#define SI7006_TEMP_SCALE  (2.68127e-3f)
+#define SI7006_TEMP_OFFSET (-46.85f)
+
+#define SI7006_RH_RAW2PHYS(raw)   ((raw)*SI7006_RH_SCALE + SI7006_RH_OFFSET)
+#define SI7006_TEMP_RAW2PHYS(raw) ((raw)*SI7006_TEMP_SCALE + SI7006_TEMP_OFFSET)
 
 #define SI7006_RH_RAW2PHYS_Q7p9(raw)   (((uint16_t)(raw)*125 >> 7) - 3072)
 #define SI7006_TEMP_RAW2PHYS_Q8p8(raw) ((int16_t)(((int32_t)(raw)*22492 - 393006285) / 32768))
@@ -28,8 +36,38 @@
 
 #define SI7006_POWERUP_TIME (80e-3f)
 
+// register fields as "shift, width", see regmap.h
+#define SI7006_USER_RES0           0, 1
+#define SI7006_USER_HEATER_EN      2, 1
+#define SI7006_USER_VDD_STATUS     6, 1
+#define SI7006_USER_RES1           7, 1
+#define SI7006_HEATER_CTRL_CURRENT 0, 4
+#define SI7006_REVISION_MINOR      0, 4
+#define SI7006_REVISION_MAJOR      4, 4
+
 /* ===== TYPES ============================================================== */
 
+//! Commands, the electronic ID and firmware revision ones are two bytes, _0 first
+typedef enum
+{
+    SI7006_CMD_MEASURE_RH          = 0xE5,
+    SI7006_CMD_NOHOLD_MEASURE_RH   = 0xF5,
+    SI7006_CMD_MEASURE_TEMP        = 0xE3,
+    SI7006_CMD_NOHOLD_MEASURE_TEMP = 0xF3,
+    SI7006_CMD_READ_TEMP           = 0xE0,
+    SI7006_CMD_RESET               = 0xFE,
+    SI7006_CMD_WRITE_RHT           = 0xE6,
+    SI7006_CMD_READ_RHT            = 0xE7,
+    SI7006_CMD_WRITE_HEATER_CTRL   = 0x51,
+    SI7006_CMD_READ_HEATER_CTRL    = 0x11,
+    SI7006_CMD_READ_EID0_0         = 0xFA,
+    SI7006_CMD_READ_EID0_1         = 0x0F,
+    SI7006_CMD_READ_EID1_0         = 0xFC,
+    SI7006_CMD_READ_EID1_1         = 0xC9,
+    SI7006_CMD_READ_FW_REVISION_0  = 0x84,
+    SI7006_CMD_READ_FW_REVISION_1  = 0xB8,
+} si7006_cmd_t;
+
 typedef enum
 {
     SI7006_DEVICE_ID_ENGINEER0 = 0x00,
@@ -42,6 +80,14 @@ typedef enum
     SI7006_DEVICE_ID_ENGINEER1 = 0xFF,
 } si7006_device_id_t;
 
+typedef enum
+{
+    SI7006_SETUP_RESOLUTION_RH12_T14,
+    SI7006_SETUP_RESOLUTION_RH8_T12,
+    SI7006_SETUP_RESOLUTION_RH10_T13,
+    SI7006_SETUP_RESOLUTION_RH11_T11,
+} si7006_setup_resolution_t;
+
 typedef int (*si7006_read_t)(void* data, uint8_t size, bool is_last);
 typedef int (*si7006_write_t)(const void* data, uint8_t size, bool is_last);
 typedef void (*si7006_wait_ms_t)(uint16_t value);
@@ -52,7 +98,9 @@ typedef struct
     si7006_write_t write;
     si7006_wait_ms_t wait;
 
-    si7006_setup_resolution_t res;
+    const transport_t* transport; //! used instead of read/write when set
+
+    si7006_setup_resolution_t resolution;
     bool heater_en : 1;
     bool vdd_ok    : 1;
 } si7006_driver_t;
@@ -60,16 +108,11 @@ typedef struct
 /* ===== GLOBALS AND EXTERNS ================================================ */
 /* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
 
-typedef enum
-{
-    SI7006_SETUP_RESOLUTION_RH12_T14,
-    SI7006_SETUP_RESOLUTION_RH8_T12,
-    SI7006_SETUP_RESOLUTION_RH10_T13,
-    SI7006_SETUP_RESOLUTION_RH11_T11,
-} si7006_setup_resolution_t;
-
 int si7006_write_setup(si7006_driver_t* self, si7006_setup_resolution_t resolution, bool heater_en);
-int si7006_read_setup(si7006_driver_t* self, si7006_setup_resolution_t* resolution, bool* heater_en);
+int si7006_read_setup(si7006_driver_t* self, si7006_setup_resolution_t* resolution, bool* heater_en, bool* vdd_ok);
+
+//! Read-modify-write of the user register, only the bits in mask are taken from value (SI7006_USER_* fields)
+int si7006_update_setup(si7006_driver_t* self, uint8_t mask, uint8_t value);
 
 typedef enum
 {
@@ -116,10 +159,21 @@ typedef union
 
 int si7006_read_fw_revision(si7006_driver_t* self, si7006_reg_revision_t* value);
 
+//! Conversion time of the current resolution, RH conversion includes the temperature one
+uint16_t si7006_get_conversion_time_ms(si7006_driver_t* self, bool is_rh);
+
 int si7006_measure_temp(si7006_driver_t* self, uint16_t* value);
 int si7006_nohold_measure_temp(si7006_driver_t* self, uint16_t* value);
 
 int si7006_measure_rh(si7006_driver_t* self, uint16_t* value);
 int si7006_nohold_measure_rh(si7006_driver_t* self, uint16_t* value);
 
+/*
+ * Split no-hold measurement: the start releases the bus, si7006_nohold_collect()
+ * may follow after si7006_get_conversion_time_ms() and fails while the sensor
+ * still NACKs its address.
+ */
+int si7006_nohold_start(si7006_driver_t* self, bool is_rh);
+int si7006_nohold_collect(si7006_driver_t* self, uint16_t* value);
+
 #endif /* __SI7006_H__ */
@@ -0,0 +1,208 @@
+
+/* ===== INCLUDES =========================================================== */
+
+#include "sim.h"
+
+#include <string.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define BITS_PER_BYTE (9)
+
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static sim_dev_t* _find(sim_bus_t* bus, uint16_t address);
+static int _start(sim_bus_t* bus, uint16_t address, bool is_read);
+static void _stop(sim_bus_t* bus);
+static int _read(const transport_t* self, void* data, size_t size, uint8_t flags);
+static int _write(const transport_t* self, const void* data, size_t size, uint8_t flags);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+void sim_bus_init(sim_bus_t* bus, uint32_t freq_hz)
+{
+    memset(bus, 0, sizeof(*bus));
+    bus->bit_ns = 1000000000u / freq_hz;
+}
+
+void sim_bus_attach(sim_bus_t* bus, sim_dev_t* dev, uint16_t address)
+{
+    dev->bus     = bus;
+    dev->address = address;
+    dev->next    = bus->devs;
+    bus->devs    = dev;
+}
+
+void sim_bus_advance(sim_bus_t* bus, uint64_t ns)
+{
+    bus->now_ns += ns;
+}
+
+void sim_bus_reset_counters(sim_bus_t* bus)
+{
+    memset(&bus->counters, 0, sizeof(bus->counters));
+}
+
+void sim_transport_init(transport_t* transport, sim_bus_t* bus, uint16_t address)
+{
+    *transport = (transport_t){
+        .ctx     = bus,
+        .bus     = bus,
+        .address = address,
+        .read    = _read,
+        .write   = _write,
+    };
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static sim_dev_t* _find(sim_bus_t* bus, uint16_t address)
+{
+    for (sim_dev_t* dev = bus->devs; dev != NULL; dev = dev->next)
+    {
+        if (dev->address == address)
+        {
+            return dev;
+        }
+    }
+
+    return NULL;
+}
+
+static int _start(sim_bus_t* bus, uint16_t address, bool is_read)
+{
+    sim_dev_t* dev = _find(bus, address);
+    bool ack;
+
+    if (bus->active != NULL)
+    {
+        bus->counters.restarts++;
+
+        // A repeated START addressed to another device ends the transaction of the previous one
+        if ((bus->active != dev) && (bus->active->ops->stop != NULL))
+        {
+            bus->active->ops->stop(bus->active);
+        }
+    }
+    else
+    {
+        bus->counters.starts++;
+    }
+
+    bus->now_ns += (uint64_t)bus->bit_ns * (BITS_PER_BYTE + 1);
+    bus->active         = dev;
+    bus->active_is_read = is_read;
+
+    if (dev == NULL)
+    {
+        ack = false;
+    }
+    else
+    {
+        dev->addressed++;
+        ack = dev->ops->start(dev, is_read);
+
+        if (dev->fault.nack_count != 0)
+        {
+            dev->fault.nack_count--;
+            ack = false;
+        }
+        else if ((dev->fault.nack_every != 0) && ((dev->addressed % dev->fault.nack_every) == 0))
+        {
+            ack = false;
+        }
+    }
+
+    if (!ack)
+    {
+        bus->counters.nacks++;
+        _stop(bus);
+        return SIM_ERR_NACK;
+    }
+
+    return 0;
+}
+
+static void _stop(sim_bus_t* bus)
+{
+    if ((bus->active != NULL) && (bus->active->ops->stop != NULL))
+    {
+        bus->active->ops->stop(bus->active);
+    }
+
+    bus->counters.stops++;
+    bus->now_ns += bus->bit_ns;
+    bus->active = NULL;
+}
+
+static int _read(const transport_t* self, void* data, size_t size, uint8_t flags)
+{
+    sim_bus_t* bus = self->ctx;
+    uint8_t* bytes = data;
+    int res;
+
+    if ((bus->active == NULL) || !bus->active_is_read || (bus->active->address != self->address))
+    {
+        res = _start(bus, self->address, true);
+        if (res != 0)
+        {
+            return res;
+        }
+    }
+
+    for (size_t i = 0; i < size; i++)
+    {
+        bytes[i] = bus->active->ops->read(bus->active) ^ bus->active->fault.read_xor;
+        bus->now_ns += (uint64_t)bus->bit_ns * BITS_PER_BYTE + bus->active->fault.stretch_ns;
+    }
+
+    bus->counters.bytes_read += size;
+
+    if (flags & TRANSPORT_FLAG_LAST)
+    {
+        _stop(bus);
+    }
+
+    return 0;
+}
+
+static int _write(const transport_t* self, const void* data, size_t size, uint8_t flags)
+{
+    sim_bus_t* bus       = self->ctx;
+    const uint8_t* bytes = data;
+    int res;
+
+    if ((bus->active == NULL) || bus->active_is_read || (bus->active->address != self->address))
+    {
+        res = _start(bus, self->address, false);
+        if (res != 0)
+        {
+            return res;
+        }
+    }
+
+    for (size_t i = 0; i < size; i++)
+    {
+        bool ack = bus->active->ops->write(bus->active, bytes[i]);
+
+        bus->now_ns += (uint64_t)bus->bit_ns * BITS_PER_BYTE + bus->active->fault.stretch_ns;
+        bus->counters.bytes_written++;
+
+        if (!ack)
+        {
+            bus->counters.nacks++;
+            _stop(bus);
+            return SIM_ERR_NACK;
+        }
+    }
+
+    if (flags & TRANSPORT_FLAG_LAST)
+    {
+        _stop(bus);
+    }
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+#ifndef __SIM_H__
+#define __SIM_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "transport.h"
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define SIM_ERR_NACK (-1)
+
+/* ===== TYPES ============================================================== */
+
+typedef struct sim_bus sim_bus_t;
+typedef struct sim_dev sim_dev_t;
+
+/*
+ * Device model callbacks. start() and write() return false to NACK, start() is
+ * called for every START and repeated START addressed to the device.
+ */
+typedef struct
+{
+    bool (*start)(sim_dev_t* dev, bool is_read);
+    bool (*write)(sim_dev_t* dev, uint8_t byte);
+    uint8_t (*read)(sim_dev_t* dev);
+    void (*stop)(sim_dev_t* dev);
+} sim_dev_ops_t;
+
+typedef struct
+{
+    uint32_t nack_count;    //! NACK the next nack_count address phases
+    uint32_t nack_every;    //! NACK every nack_every-th address phase, 0 disables
+    uint8_t read_xor;       //! XORed into every byte read from the device
+    uint32_t stretch_ns;    //! extra clock stretching per byte
+} sim_fault_t;
+
+struct sim_dev
+{
+    const sim_dev_ops_t* ops;
+    sim_bus_t* bus;
+    sim_dev_t* next;
+    uint16_t address;
+    sim_fault_t fault;
+    uint32_t addressed;
+};
+
+typedef struct
+{
+    uint64_t starts;
+    uint64_t restarts;
+    uint64_t stops;
+    uint64_t bytes_written;
+    uint64_t bytes_read;
+    uint64_t nacks;
+} sim_counters_t;
+
+/*
+ * Simulated I2C bus. Time is virtual: it advances with every bit on the wire and
+ * through sim_bus_advance(), device models derive conversion progress from it.
+ */
+struct sim_bus
+{
+    uint64_t now_ns;
+    uint32_t bit_ns;
+    sim_dev_t* devs;
+
+    sim_dev_t* active;
+    bool active_is_read;
+    sim_counters_t counters;
+};
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+void sim_bus_init(sim_bus_t* bus, uint32_t freq_hz);
+void sim_bus_attach(sim_bus_t* bus, sim_dev_t* dev, uint16_t address);
+void sim_bus_advance(sim_bus_t* bus, uint64_t ns);
+void sim_bus_reset_counters(sim_bus_t* bus);
+
+//! Transport addressing a device on the simulated bus, with the usual TRANSPORT_FLAG_LAST semantics
+void sim_transport_init(transport_t* transport, sim_bus_t* bus, uint16_t address);
+
+#endif /* __SIM_H__ */
@@ -0,0 +1,118 @@
+#ifndef __SIM_DEVICES_H__
+#define __SIM_DEVICES_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include "sim.h"
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define SIM_MC24XX_MAX_PAGE (256)
+
+/* ===== TYPES ============================================================== */
+
+/*
+ * Register accurate device models. Fields after the "inputs" comment are the
+ * physical quantities the model measures and may be changed at any time.
+ */
+
+typedef struct
+{
+    sim_dev_t dev;
+    uint16_t regs[8];
+    uint8_t pointer;
+    uint8_t index;
+    uint8_t msb;
+    bool read_lsb;
+    bool converting;
+    uint64_t conv_done_ns;
+
+    // inputs
+    int16_t shunt_raw;
+    uint16_t vbus_raw;
+} sim_ina226_t;
+
+typedef struct
+{
+    sim_dev_t dev;
+    uint8_t cmd[2];
+    uint8_t cmd_len;
+    uint8_t user;
+    uint8_t heater;
+    uint8_t out[8];
+    uint8_t out_len;
+    uint8_t out_pos;
+    bool measuring;
+    bool hold;
+    uint64_t ready_ns;
+    uint16_t last_temp;
+
+    // inputs
+    uint16_t rh_raw;
+    uint16_t temp_raw;
+    uint8_t serial[8];
+} sim_si7006_t;
+
+typedef struct
+{
+    sim_dev_t dev;
+    uint8_t regs[0x20];
+    uint8_t addr;
+    bool has_cmd;
+    uint64_t cycle_start_ns;
+    uint8_t persist;
+
+    // inputs, counts of a 100 ms integration at low gain
+    uint32_t ch0_in;
+    uint32_t ch1_in;
+} sim_tsl2591_t;
+
+typedef struct
+{
+    sim_dev_t dev;
+    bool is_4010;
+    uint8_t regs[0x10];
+    uint8_t addr;
+    bool has_addr;
+    bool prox_busy;
+    bool alight_busy;
+    uint64_t prox_ready_ns;
+    uint64_t alight_ready_ns;
+    uint64_t next_self_timed_ns;
+    uint8_t exceed;
+    uint32_t rng;
+    uint32_t alight_conv_ns;
+
+    // inputs, proximity counts at 200 mA and peak-to-peak noise
+    uint16_t prox_in;
+    uint16_t prox_noise;
+    uint16_t alight_in;
+} sim_vcnl40x0_t;
+
+typedef struct
+{
+    sim_dev_t dev;
+    uint8_t* mem;
+    uint32_t size;
+    uint16_t page_size;
+    uint32_t write_cycle_ns;
+    uint32_t addr;
+    uint8_t addr_bytes;
+    uint8_t page[SIM_MC24XX_MAX_PAGE];
+    uint16_t pending;
+    uint64_t busy_until_ns;
+} sim_mc24xx_t;
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+void sim_ina226_init(sim_ina226_t* self);
+void sim_si7006_init(sim_si7006_t* self);
+void sim_tsl2591_init(sim_tsl2591_t* self);
+bool sim_tsl2591_int_pending(sim_tsl2591_t* self);
+void sim_vcnl4000_init(sim_vcnl40x0_t* self);
+void sim_vcnl4010_init(sim_vcnl40x0_t* self);
+bool sim_vcnl4010_int_pending(sim_vcnl40x0_t* self);
+void sim_mc24xx_init(sim_mc24xx_t* self, uint8_t* mem, uint32_t size, uint16_t page_size);
+
+#endif /* __SIM_DEVICES_H__ */
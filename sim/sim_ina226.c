@@ -0,0 +1,249 @@
+/* ===== INCLUDES =========================================================== */
+
+#include "sim_devices.h"
+#include "ina226.h"
+
+#include <string.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define CONFIG_DEFAULT 0x4127
+#define CONFIG_RESET   (1u << 15)
+#define MASK_CVRF      (1u << 3)
+#define MASK_WRITEABLE 0xFC03
+
+#define CONFIG_MODE(config)      ((config)&7)
+#define CONFIG_VSHCT(config)     (((config) >> 3) & 7)
+#define CONFIG_VBUSCT(config)    (((config) >> 6) & 7)
+#define CONFIG_AVG(config)       (((config) >> 9) & 7)
+#define MODE_HAS_SHUNT(mode)     ((mode)&1)
+#define MODE_HAS_VBUS(mode)      ((mode)&2)
+#define MODE_IS_CONTINUOUS(mode) ((mode)&4)
+
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static bool _start(sim_dev_t* dev, bool is_read);
+static bool _write(sim_dev_t* dev, uint8_t byte);
+static uint8_t _read(sim_dev_t* dev);
+static void _reset(sim_ina226_t* self);
+static void _update(sim_ina226_t* self);
+static void _trigger(sim_ina226_t* self, uint64_t from_ns);
+static uint16_t _reg_get(sim_ina226_t* self, uint8_t reg);
+static void _reg_set(sim_ina226_t* self, uint8_t reg, uint16_t value);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+
+static const sim_dev_ops_t _ops = {
+    .start = _start,
+    .write = _write,
+    .read  = _read,
+};
+
+static const uint16_t _conv_time_us[] = {140, 204, 332, 588, 1100, 2116, 4156, 8244};
+static const uint16_t _averages[]     = {1, 4, 16, 64, 128, 256, 512, 1024};
+
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+void sim_ina226_init(sim_ina226_t* self)
+{
+    memset(self, 0, sizeof(*self));
+    self->dev.ops = &_ops;
+    _reset(self);
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static bool _start(sim_dev_t* dev, bool is_read)
+{
+    sim_ina226_t* self = (sim_ina226_t*)dev;
+
+    // converting in the background from the first START after the reset
+    if (self->converting && (self->conv_done_ns == 0))
+    {
+        _trigger(self, dev->bus->now_ns);
+    }
+
+    self->index    = 0;
+    self->read_lsb = false;
+    (void)is_read;
+
+    return true;
+}
+
+static bool _write(sim_dev_t* dev, uint8_t byte)
+{
+    sim_ina226_t* self = (sim_ina226_t*)dev;
+
+    switch (self->index++)
+    {
+    case 0:
+        self->pointer = byte;
+        break;
+
+    case 1:
+        self->msb = byte;
+        break;
+
+    case 2:
+        _reg_set(self, self->pointer, (uint16_t)((self->msb << 8) | byte));
+        break;
+
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+static uint8_t _read(sim_dev_t* dev)
+{
+    sim_ina226_t* self = (sim_ina226_t*)dev;
+    uint16_t value;
+
+    _update(self);
+
+    value = _reg_get(self, self->pointer);
+
+    if (self->read_lsb)
+    {
+        // reading the mask register clears the conversion ready flag
+        if (self->pointer == INA226_REG_MASK_ENABLE)
+        {
+            self->regs[INA226_REG_MASK_ENABLE] &= ~MASK_CVRF;
+        }
+
+        self->read_lsb = false;
+        return value & 0xFF;
+    }
+
+    self->read_lsb = true;
+    return value >> 8;
+}
+
+static void _reset(sim_ina226_t* self)
+{
+    memset(self->regs, 0, sizeof(self->regs));
+    self->regs[INA226_REG_CONFIGURATION] = CONFIG_DEFAULT;
+    self->converting                     = true;
+    self->conv_done_ns                   = 0;
+}
+
+static void _update(sim_ina226_t* self)
+{
+    uint64_t now = self->dev.bus->now_ns;
+    uint16_t config;
+    int32_t current;
+
+    if (!self->converting || (now < self->conv_done_ns))
+    {
+        return;
+    }
+
+    config = self->regs[INA226_REG_CONFIGURATION];
+
+    if (MODE_HAS_SHUNT(CONFIG_MODE(config)))
+    {
+        self->regs[INA226_REG_SHUNT_VOLTAGE] = (uint16_t)self->shunt_raw;
+    }
+    if (MODE_HAS_VBUS(CONFIG_MODE(config)))
+    {
+        self->regs[INA226_REG_BUS_VOLTAGE] = self->vbus_raw & 0x7FFF;
+    }
+
+    current = ((int32_t)(int16_t)self->regs[INA226_REG_SHUNT_VOLTAGE] * self->regs[INA226_REG_CALIBRATION]) / 2048;
+    self->regs[INA226_REG_CURRENT] = (uint16_t)(int16_t)current;
+    self->regs[INA226_REG_POWER] =
+        (uint16_t)(((uint32_t)(current < 0 ? -current : current) * self->regs[INA226_REG_BUS_VOLTAGE]) / 20000);
+
+    self->regs[INA226_REG_MASK_ENABLE] |= MASK_CVRF;
+
+    if (MODE_IS_CONTINUOUS(CONFIG_MODE(config)))
+    {
+        _trigger(self, self->conv_done_ns);
+    }
+    else
+    {
+        self->converting = false;
+    }
+}
+
+static void _trigger(sim_ina226_t* self, uint64_t from_ns)
+{
+    uint16_t config = self->regs[INA226_REG_CONFIGURATION];
+    uint8_t mode    = CONFIG_MODE(config);
+    uint64_t us     = 0;
+
+    if (MODE_HAS_SHUNT(mode))
+    {
+        us += _conv_time_us[CONFIG_VSHCT(config)];
+    }
+    if (MODE_HAS_VBUS(mode))
+    {
+        us += _conv_time_us[CONFIG_VBUSCT(config)];
+    }
+
+    if (us == 0)
+    {
+        self->converting = false;
+        return;
+    }
+
+    self->converting   = true;
+    self->conv_done_ns = from_ns + us * _averages[CONFIG_AVG(config)] * 1000u;
+
+    // idle continuous conversions are skipped rather than replayed one by one
+    if (self->conv_done_ns < self->dev.bus->now_ns)
+    {
+        self->conv_done_ns = self->dev.bus->now_ns;
+    }
+}
+
+static uint16_t _reg_get(sim_ina226_t* self, uint8_t reg)
+{
+    switch (reg)
+    {
+    case INA226_REG_MANUFACTURER:
+        return INA226_MANUFACTURER;
+
+    case INA226_REG_CHIP_ID:
+        return INA226_CHIP_IDENTIFIER;
+
+    default:
+        return (reg < 8) ? self->regs[reg] : 0xFFFF;
+    }
+}
+
+static void _reg_set(sim_ina226_t* self, uint8_t reg, uint16_t value)
+{
+    switch (reg)
+    {
+    case INA226_REG_CONFIGURATION:
+        if (value & CONFIG_RESET)
+        {
+            _reset(self);
+            _trigger(self, self->dev.bus->now_ns);
+            return;
+        }
+        self->regs[reg] = value | (CONFIG_DEFAULT & 0x4000);
+        self->regs[INA226_REG_MASK_ENABLE] &= ~MASK_CVRF;
+        _trigger(self, self->dev.bus->now_ns);
+        break;
+
+    case INA226_REG_CALIBRATION:
+        self->regs[reg] = value & 0x7FFF;
+        break;
+
+    case INA226_REG_MASK_ENABLE:
+        self->regs[reg] = (self->regs[reg] & ~MASK_WRITEABLE) | (value & MASK_WRITEABLE);
+        break;
+
+    case INA226_REG_ALERT_LIMIT:
+        self->regs[reg] = value;
+        break;
+
+    default:
+        break;
+    }
+}
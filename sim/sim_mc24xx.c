@@ -0,0 +1,131 @@
+/* ===== INCLUDES =========================================================== */
+
+#include "sim_devices.h"
+#include "mc24xx.h"
+
+#include <string.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define ADDRESS_BYTES (2)
+
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static bool _start(sim_dev_t* dev, bool is_read);
+static bool _write(sim_dev_t* dev, uint8_t byte);
+static uint8_t _read(sim_dev_t* dev);
+static void _stop(sim_dev_t* dev);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+
+static const sim_dev_ops_t _ops = {
+    .start = _start,
+    .write = _write,
+    .read  = _read,
+    .stop  = _stop,
+};
+
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+void sim_mc24xx_init(sim_mc24xx_t* self, uint8_t* mem, uint32_t size, uint16_t page_size)
+{
+    memset(self, 0, sizeof(*self));
+    self->dev.ops        = &_ops;
+    self->mem            = mem;
+    self->size           = size;
+    self->page_size      = (page_size > SIM_MC24XX_MAX_PAGE) ? SIM_MC24XX_MAX_PAGE : page_size;
+    self->write_cycle_ns = MC24XX_WRITE_CYCLE_MS * 1000000u;
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static bool _start(sim_dev_t* dev, bool is_read)
+{
+    sim_mc24xx_t* self = (sim_mc24xx_t*)dev;
+
+    // no acknowledge during the internal write cycle, this is what ACK polling relies on
+    if (dev->bus->now_ns < self->busy_until_ns)
+    {
+        self->addr_bytes = 0;
+        self->pending    = 0;
+        return false;
+    }
+
+    if (!is_read)
+    {
+        self->addr_bytes = 0;
+        self->pending    = 0;
+    }
+
+    return true;
+}
+
+static bool _write(sim_dev_t* dev, uint8_t byte)
+{
+    sim_mc24xx_t* self = (sim_mc24xx_t*)dev;
+
+    if (self->addr_bytes < ADDRESS_BYTES)
+    {
+        self->addr = ((self->addr << 8) | byte) & 0xFFFF;
+        self->addr_bytes++;
+
+        if (self->addr_bytes == ADDRESS_BYTES)
+        {
+            self->addr %= self->size;
+        }
+
+        return true;
+    }
+
+    // bytes past the page size overwrite the start of the latch, as the real page buffer does
+    self->page[self->pending % self->page_size] = byte;
+    if (self->pending < UINT16_MAX)
+    {
+        self->pending++;
+    }
+
+    return true;
+}
+
+static uint8_t _read(sim_dev_t* dev)
+{
+    sim_mc24xx_t* self = (sim_mc24xx_t*)dev;
+    uint8_t value      = self->mem[self->addr];
+
+    self->addr = (self->addr + 1) % self->size;
+
+    return value;
+}
+
+static void _stop(sim_dev_t* dev)
+{
+    sim_mc24xx_t* self = (sim_mc24xx_t*)dev;
+    uint32_t page_start;
+    uint16_t count;
+    uint16_t first;
+
+    if ((self->addr_bytes < ADDRESS_BYTES) || (self->pending == 0))
+    {
+        return;
+    }
+
+    page_start = self->addr - (self->addr % self->page_size);
+    count      = (self->pending > self->page_size) ? self->page_size : self->pending;
+    first      = (self->pending > self->page_size) ? (uint16_t)(self->pending % self->page_size) : 0;
+
+    // the address counter wraps inside the page
+    for (uint16_t i = 0; i < count; i++)
+    {
+        uint32_t skip = (self->pending > self->page_size) ? (uint32_t)(self->pending - self->page_size) : 0;
+        uint32_t offs = (self->addr - page_start + skip + i) % self->page_size;
+
+        self->mem[page_start + offs] = self->page[(first + i) % self->page_size];
+    }
+
+    self->addr          = page_start + (self->addr - page_start + self->pending) % self->page_size;
+    self->pending       = 0;
+    self->addr_bytes    = 0;
+    self->busy_until_ns = dev->bus->now_ns + self->write_cycle_ns;
+}
@@ -0,0 +1,308 @@
+/* ===== INCLUDES =========================================================== */
+
+#include "sim_devices.h"
+#include "si7006.h"
+
+#include <string.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define CMD_MEASURE_RH          0xE5
+#define CMD_NOHOLD_MEASURE_RH   0xF5
+#define CMD_MEASURE_TEMP        0xE3
+#define CMD_NOHOLD_MEASURE_TEMP 0xF3
+#define CMD_READ_TEMP           0xE0
+#define CMD_RESET               0xFE
+#define CMD_WRITE_RHT           0xE6
+#define CMD_READ_RHT            0xE7
+#define CMD_WRITE_HEATER_CTRL   0x51
+#define CMD_READ_HEATER_CTRL    0x11
+#define CMD_READ_EID0           0xFA0F
+#define CMD_READ_EID1           0xFCC9
+#define CMD_READ_FW_REVISION    0x84B8
+
+#define USER_DEFAULT   0x3A
+#define USER_WRITEABLE 0x85
+#define FW_REVISION    0x20
+
+#define SEC2NS(sec) ((uint64_t)((sec)*1e9f))
+
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static bool _start(sim_dev_t* dev, bool is_read);
+static bool _write(sim_dev_t* dev, uint8_t byte);
+static uint8_t _read(sim_dev_t* dev);
+static void _stop(sim_dev_t* dev);
+static bool _needs_more(const sim_si7006_t* self);
+static void _execute(sim_si7006_t* self);
+static void _measure(sim_si7006_t* self, bool is_rh, bool hold);
+static void _out_word(sim_si7006_t* self, uint16_t value);
+static uint8_t _crc8(const uint8_t* data, uint8_t size);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+
+static const sim_dev_ops_t _ops = {
+    .start = _start,
+    .write = _write,
+    .read  = _read,
+    .stop  = _stop,
+};
+
+// indexed by the resolution bits {res1, res0}
+static const uint64_t _tconv_rh_ns[] = {
+    [SI7006_SETUP_RESOLUTION_RH12_T14] = SEC2NS(SI7006_TCONV_RH12),
+    [SI7006_SETUP_RESOLUTION_RH8_T12]  = SEC2NS(SI7006_TCONV_RH8),
+    [SI7006_SETUP_RESOLUTION_RH10_T13] = SEC2NS(SI7006_TCONV_RH10),
+    [SI7006_SETUP_RESOLUTION_RH11_T11] = SEC2NS(SI7006_TCONV_RH11),
+};
+
+static const uint64_t _tconv_t_ns[] = {
+    [SI7006_SETUP_RESOLUTION_RH12_T14] = SEC2NS(SI7006_TCONV_T14),
+    [SI7006_SETUP_RESOLUTION_RH8_T12]  = SEC2NS(SI7006_TCONV_T12),
+    [SI7006_SETUP_RESOLUTION_RH10_T13] = SEC2NS(SI7006_TCONV_T13),
+    [SI7006_SETUP_RESOLUTION_RH11_T11] = SEC2NS(SI7006_TCONV_T11),
+};
+
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+void sim_si7006_init(sim_si7006_t* self)
+{
+    const uint8_t serial[8] = {0x78, 0x56, 0x34, SI7006_DEVICE_ID_SI7006, 0xDE, 0xBC, 0x9A, 0x12};
+
+    memset(self, 0, sizeof(*self));
+    self->dev.ops = &_ops;
+    self->user    = USER_DEFAULT;
+    memcpy(self->serial, serial, sizeof(serial));
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static bool _start(sim_dev_t* dev, bool is_read)
+{
+    sim_si7006_t* self = (sim_si7006_t*)dev;
+    sim_bus_t* bus     = dev->bus;
+
+    if (!is_read)
+    {
+        self->cmd_len = 0;
+        return true;
+    }
+
+    if (self->measuring)
+    {
+        if (self->hold)
+        {
+            // the clock is stretched until the conversion completes
+            if (bus->now_ns < self->ready_ns)
+            {
+                bus->now_ns = self->ready_ns;
+            }
+        }
+        else if (bus->now_ns < self->ready_ns)
+        {
+            return false;
+        }
+
+        self->measuring = false;
+    }
+
+    return true;
+}
+
+static bool _write(sim_dev_t* dev, uint8_t byte)
+{
+    sim_si7006_t* self = (sim_si7006_t*)dev;
+
+    if (self->cmd_len >= sizeof(self->cmd))
+    {
+        return false;
+    }
+
+    self->cmd[self->cmd_len++] = byte;
+
+    // commands take effect on their last byte, a following repeated START reads the result
+    if (!_needs_more(self))
+    {
+        _execute(self);
+        self->cmd_len = 0;
+    }
+
+    return true;
+}
+
+static uint8_t _read(sim_dev_t* dev)
+{
+    sim_si7006_t* self = (sim_si7006_t*)dev;
+
+    if (self->out_pos >= self->out_len)
+    {
+        return 0xFF;
+    }
+
+    return self->out[self->out_pos++];
+}
+
+static void _stop(sim_dev_t* dev)
+{
+    sim_si7006_t* self = (sim_si7006_t*)dev;
+
+    self->cmd_len = 0;
+}
+
+static bool _needs_more(const sim_si7006_t* self)
+{
+    if (self->cmd_len >= 2)
+    {
+        return false;
+    }
+
+    switch (self->cmd[0])
+    {
+    case CMD_WRITE_RHT:
+    case CMD_WRITE_HEATER_CTRL:
+    case CMD_READ_EID0 >> 8:
+    case CMD_READ_EID1 >> 8:
+    case CMD_READ_FW_REVISION >> 8:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+static void _execute(sim_si7006_t* self)
+{
+    uint16_t cmd = (self->cmd_len >= 2) ? (uint16_t)((self->cmd[0] << 8) | self->cmd[1]) : 0;
+    const uint8_t* sn = self->serial;
+
+    self->out_len   = 0;
+    self->out_pos   = 0;
+    self->measuring = false;
+
+    switch (self->cmd[0])
+    {
+    case CMD_MEASURE_RH:
+    case CMD_NOHOLD_MEASURE_RH:
+        _measure(self, true, self->cmd[0] == CMD_MEASURE_RH);
+        return;
+
+    case CMD_MEASURE_TEMP:
+    case CMD_NOHOLD_MEASURE_TEMP:
+        _measure(self, false, self->cmd[0] == CMD_MEASURE_TEMP);
+        return;
+
+    case CMD_READ_TEMP:
+        _out_word(self, self->last_temp);
+        return;
+
+    case CMD_RESET:
+        self->user      = USER_DEFAULT;
+        self->heater    = 0;
+        self->measuring = false;
+        return;
+
+    case CMD_WRITE_RHT:
+        if (self->cmd_len >= 2)
+        {
+            self->user = (self->user & ~USER_WRITEABLE) | (self->cmd[1] & USER_WRITEABLE);
+        }
+        return;
+
+    case CMD_READ_RHT:
+        self->out[self->out_len++] = self->user;
+        return;
+
+    case CMD_WRITE_HEATER_CTRL:
+        if (self->cmd_len >= 2)
+        {
+            self->heater = self->cmd[1] & 0x0F;
+        }
+        return;
+
+    case CMD_READ_HEATER_CTRL:
+        self->out[self->out_len++] = self->heater;
+        return;
+
+    default:
+        break;
+    }
+
+    if (cmd == CMD_READ_EID0)
+    {
+        // SNA_3 CRC SNA_2 CRC SNA_1 CRC SNA_0 CRC, CRC is cumulative over the serial bytes
+        uint8_t sna[4] = {sn[7], sn[6], sn[5], sn[4]};
+
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            self->out[2 * i]     = sna[i];
+            self->out[2 * i + 1] = _crc8(sna, i + 1);
+        }
+        self->out_len = 8;
+    }
+    else if (cmd == CMD_READ_EID1)
+    {
+        // SNB_3 SNB_2 CRC SNB_1 SNB_0 CRC
+        uint8_t snb[4] = {sn[3], sn[2], sn[1], sn[0]};
+
+        self->out[0]  = snb[0];
+        self->out[1]  = snb[1];
+        self->out[2]  = _crc8(snb, 2);
+        self->out[3]  = snb[2];
+        self->out[4]  = snb[3];
+        self->out[5]  = _crc8(snb, 4);
+        self->out_len = 6;
+    }
+    else if (cmd == CMD_READ_FW_REVISION)
+    {
+        self->out[self->out_len++] = FW_REVISION;
+    }
+}
+
+static void _measure(sim_si7006_t* self, bool is_rh, bool hold)
+{
+    uint8_t resolution = ((self->user >> 6) & 2) | (self->user & 1);
+    uint64_t tconv     = _tconv_t_ns[resolution];
+
+    if (is_rh)
+    {
+        // an RH conversion also measures the temperature
+        tconv += _tconv_rh_ns[resolution];
+        _out_word(self, self->rh_raw & ~3u);
+    }
+    else
+    {
+        _out_word(self, self->temp_raw & ~3u);
+    }
+
+    self->last_temp = self->temp_raw & ~3u;
+    self->measuring = true;
+    self->hold      = hold;
+    self->ready_ns  = self->dev.bus->now_ns + tconv;
+}
+
+static void _out_word(sim_si7006_t* self, uint16_t value)
+{
+    self->out[0]  = value >> 8;
+    self->out[1]  = value & 0xFF;
+    self->out[2]  = _crc8(self->out, 2);
+    self->out_len = 3;
+    self->out_pos = 0;
+}
+
+static uint8_t _crc8(const uint8_t* data, uint8_t size)
+{
+    uint8_t crc = 0;
+
+    for (uint8_t i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
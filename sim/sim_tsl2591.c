@@ -0,0 +1,275 @@
+/* ===== INCLUDES =========================================================== */
+
+#include "sim_devices.h"
+#include "tsl2591.h"
+
+#include <string.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define CMD_SELECT    0x80
+#define CMD_TYPE_MASK 0x60
+#define CMD_TYPE_SF   0x60
+#define CMD_ADDR_MASK 0x1F
+
+#define ENABLE_PON   (1u << 0)
+#define ENABLE_AEN   (1u << 1)
+#define ENABLE_AIEN  (1u << 4)
+#define ENABLE_NPIEN (1u << 7)
+#define CONFIG_SRST  (1u << 7)
+
+#define STATUS_AVALID (1u << 0)
+#define STATUS_AINT   (1u << 4)
+#define STATUS_NPINTR (1u << 5)
+
+#define LAST_WRITEABLE TSL2591_REG_INT_PERS_FILTER
+
+#define CYCLE_NS(config) ((uint64_t)(((config)&7) + 1) * 100000000u)
+
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static bool _start(sim_dev_t* dev, bool is_read);
+static bool _write(sim_dev_t* dev, uint8_t byte);
+static uint8_t _read(sim_dev_t* dev);
+static void _reset(sim_tsl2591_t* self);
+static void _update(sim_tsl2591_t* self);
+static void _special(sim_tsl2591_t* self, uint8_t function);
+static uint16_t _count(const sim_tsl2591_t* self, uint32_t in);
+static uint16_t _reg16(const sim_tsl2591_t* self, uint8_t reg);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+
+static const sim_dev_ops_t _ops = {
+    .start = _start,
+    .write = _write,
+    .read  = _read,
+};
+
+static const uint16_t _gain_x2[] = {
+    [TSL2591_REG_CONFIG_GAIN_LOW]    = (uint16_t)(TSL2591_CHANNEL0_GAIN_LOW * 2.0f),
+    [TSL2591_REG_CONFIG_GAIN_MEDIUM] = (uint16_t)(TSL2591_CHANNEL0_GAIN_MEDIUM * 2.0f),
+    [TSL2591_REG_CONFIG_GAIN_HIGH]   = (uint16_t)(TSL2591_CHANNEL0_GAIN_HIGH * 2.0f),
+    [TSL2591_REG_CONFIG_GAIN_MAX]    = (uint16_t)(TSL2591_CHANNEL0_GAIN_MAX * 2.0f),
+};
+
+static const uint8_t _persist_cycles[] = {1, 1, 2, 3, 5, 10, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60};
+
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+void sim_tsl2591_init(sim_tsl2591_t* self)
+{
+    memset(self, 0, sizeof(*self));
+    self->dev.ops = &_ops;
+    _reset(self);
+}
+
+bool sim_tsl2591_int_pending(sim_tsl2591_t* self)
+{
+    uint8_t enable = self->regs[TSL2591_REG_ENABLE];
+    uint8_t status;
+
+    _update(self);
+    status = self->regs[TSL2591_REG_STATUS];
+
+    return ((enable & ENABLE_AIEN) && (status & STATUS_AINT)) || ((enable & ENABLE_NPIEN) && (status & STATUS_NPINTR));
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static bool _start(sim_dev_t* dev, bool is_read)
+{
+    sim_tsl2591_t* self = (sim_tsl2591_t*)dev;
+
+    if (!is_read)
+    {
+        self->has_cmd = false;
+    }
+
+    return true;
+}
+
+static bool _write(sim_dev_t* dev, uint8_t byte)
+{
+    sim_tsl2591_t* self = (sim_tsl2591_t*)dev;
+    uint8_t prev;
+
+    if (!self->has_cmd)
+    {
+        if (!(byte & CMD_SELECT))
+        {
+            return false;
+        }
+
+        if ((byte & CMD_TYPE_MASK) == CMD_TYPE_SF)
+        {
+            _special(self, byte & CMD_ADDR_MASK);
+        }
+        else
+        {
+            self->addr    = byte & CMD_ADDR_MASK;
+            self->has_cmd = true;
+        }
+
+        return true;
+    }
+
+    _update(self);
+
+    if (self->addr <= LAST_WRITEABLE)
+    {
+        prev                   = self->regs[self->addr];
+        self->regs[self->addr] = byte;
+
+        if ((self->addr == TSL2591_REG_CONFIG) && (byte & CONFIG_SRST))
+        {
+            _reset(self);
+            return true;
+        }
+
+        if (self->addr == TSL2591_REG_ENABLE)
+        {
+            if ((byte & (ENABLE_PON | ENABLE_AEN)) != (ENABLE_PON | ENABLE_AEN))
+            {
+                self->regs[TSL2591_REG_STATUS] &= ~STATUS_AVALID;
+            }
+            else if ((prev & (ENABLE_PON | ENABLE_AEN)) != (ENABLE_PON | ENABLE_AEN))
+            {
+                self->cycle_start_ns = self->dev.bus->now_ns;
+                self->persist        = 0;
+            }
+        }
+        else if (self->addr == TSL2591_REG_CONFIG)
+        {
+            // a new setting restarts the integration cycle
+            self->cycle_start_ns = self->dev.bus->now_ns;
+        }
+    }
+
+    self->addr = (self->addr + 1) & CMD_ADDR_MASK;
+
+    return true;
+}
+
+static uint8_t _read(sim_dev_t* dev)
+{
+    sim_tsl2591_t* self = (sim_tsl2591_t*)dev;
+    uint8_t value;
+
+    _update(self);
+
+    value      = self->regs[self->addr];
+    self->addr = (self->addr + 1) & CMD_ADDR_MASK;
+
+    return value;
+}
+
+static void _reset(sim_tsl2591_t* self)
+{
+    memset(self->regs, 0, sizeof(self->regs));
+    self->regs[TSL2591_REG_DEVICE_ID] = TSL2591_DEVICE_ID;
+    self->persist                     = 0;
+}
+
+static void _update(sim_tsl2591_t* self)
+{
+    uint64_t now    = self->dev.bus->now_ns;
+    uint8_t config  = self->regs[TSL2591_REG_CONFIG];
+    uint64_t cycle  = CYCLE_NS(config);
+    uint8_t* status = &self->regs[TSL2591_REG_STATUS];
+    uint64_t cycles;
+    uint16_t ch0;
+    uint16_t ch1;
+
+    if ((self->regs[TSL2591_REG_ENABLE] & (ENABLE_PON | ENABLE_AEN)) != (ENABLE_PON | ENABLE_AEN))
+    {
+        return;
+    }
+
+    if (now < self->cycle_start_ns + cycle)
+    {
+        return;
+    }
+
+    cycles = (now - self->cycle_start_ns) / cycle;
+    self->cycle_start_ns += cycles * cycle;
+
+    ch0 = _count(self, self->ch0_in);
+    ch1 = _count(self, self->ch1_in);
+
+    self->regs[TSL2591_REG_CHANNEL0_DATA_L] = ch0 & 0xFF;
+    self->regs[TSL2591_REG_CHANNEL0_DATA_H] = ch0 >> 8;
+    self->regs[TSL2591_REG_CHANNEL1_DATA_L] = ch1 & 0xFF;
+    self->regs[TSL2591_REG_CHANNEL1_DATA_H] = ch1 >> 8;
+    *status |= STATUS_AVALID;
+
+    if ((ch0 < _reg16(self, TSL2591_REG_NP_INT_LOW_THRESHOLD_L)) ||
+        (ch0 > _reg16(self, TSL2591_REG_NP_INT_HIGH_THRESHOLD_L)))
+    {
+        *status |= STATUS_NPINTR;
+    }
+
+    if ((self->regs[TSL2591_REG_INT_PERS_FILTER] & 0x0F) == TSL2591_REG_INT_PERS_FILTER_EVERY)
+    {
+        *status |= STATUS_AINT;
+    }
+    else if ((ch0 < _reg16(self, TSL2591_REG_INT_LOW_THRESHOLD_L)) ||
+             (ch0 > _reg16(self, TSL2591_REG_INT_HIGH_THRESHOLD_L)))
+    {
+        // the input is constant over the skipped cycles, so they all count
+        self->persist = (uint8_t)((self->persist + cycles > 60) ? 60 : self->persist + cycles);
+        if (self->persist >= _persist_cycles[self->regs[TSL2591_REG_INT_PERS_FILTER] & 0x0F])
+        {
+            *status |= STATUS_AINT;
+        }
+    }
+    else
+    {
+        self->persist = 0;
+    }
+}
+
+static void _special(sim_tsl2591_t* self, uint8_t function)
+{
+    uint8_t* status = &self->regs[TSL2591_REG_STATUS];
+
+    _update(self);
+
+    switch (function | CMD_SELECT | CMD_TYPE_SF)
+    {
+    case TSL2591_CMD_INT_FORCE:
+        *status |= STATUS_AINT;
+        break;
+
+    case TSL2591_CMD_INT_CLEAR:
+        *status &= ~STATUS_AINT;
+        break;
+
+    case TSL2591_CMD_INT_CLEAR_ALL:
+        *status &= ~(STATUS_AINT | STATUS_NPINTR);
+        break;
+
+    case TSL2591_CMD_NP_INT_CLEAR:
+        *status &= ~STATUS_NPINTR;
+        break;
+
+    default:
+        break;
+    }
+}
+
+static uint16_t _count(const sim_tsl2591_t* self, uint32_t in)
+{
+    uint8_t config     = self->regs[TSL2591_REG_CONFIG];
+    uint8_t itime      = config & 7;
+    uint32_t max_count = (itime == TSL2591_REG_CONFIG_INTEGR_TIME_100ms) ? TSL2591_MAX_COUNT_100MS : TSL2591_MAX_COUNT;
+    uint64_t count     = (uint64_t)in * _gain_x2[(config >> 4) & 3] * (itime + 1) / 2;
+
+    return (count > max_count) ? (uint16_t)max_count : (uint16_t)count;
+}
+
+static uint16_t _reg16(const sim_tsl2591_t* self, uint8_t reg)
+{
+    return (uint16_t)(self->regs[reg] | (self->regs[reg + 1] << 8));
+}
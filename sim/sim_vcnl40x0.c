@@ -0,0 +1,324 @@
+/* ===== INCLUDES =========================================================== */
+
+#include "sim_devices.h"
+#include "vcnl4000.h"
+#include "vcnl4010.h"
+
+#include <string.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define CMD_SELF_TIMED   (1u << 0)
+#define CMD_PROX_EN      (1u << 1)
+#define CMD_PROX_OD      (1u << 3)
+#define CMD_ALIGHT_OD    (1u << 4)
+#define CMD_PROX_READY   (1u << 5)
+#define CMD_ALIGHT_READY (1u << 6)
+
+#define INT_CTRL_SEL_ALIGHT (1u << 0)
+#define INT_CTRL_THRSH_EN   (1u << 1)
+#define INT_CTRL_PROX_EN    (1u << 3)
+#define INT_CTRL_EXCEED(v)  (1u << (((v) >> 5) & 7))
+
+#define INT_STATUS_HIGH (1u << 0)
+#define INT_STATUS_LOW  (1u << 1)
+#define INT_STATUS_PROX (1u << 3)
+
+#define VERSION_4000 0x11
+#define VERSION_4010 0x21
+
+#define IR_CURRENT_REF 20 // prox_in is given at 200 mA
+#define ALIGHT_CONV_NS ((uint32_t)(VCNL4000_ALIGHT_CONVERSION_TIME * 1e9f))
+#define PROX_CONV_NS   ((uint32_t)(VCNL4000_CONVERSION_TIME * 1e9f))
+#define MAX_SKIPPED    256
+
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static void _init(sim_vcnl40x0_t* self, bool is_4010);
+static bool _start(sim_dev_t* dev, bool is_read);
+static bool _write(sim_dev_t* dev, uint8_t byte);
+static uint8_t _read(sim_dev_t* dev);
+static void _reg_set(sim_vcnl40x0_t* self, uint8_t reg, uint8_t value);
+static void _update(sim_vcnl40x0_t* self);
+static uint16_t _measure_prox(sim_vcnl40x0_t* self);
+static void _self_timed(sim_vcnl40x0_t* self);
+static uint16_t _reg16(const sim_vcnl40x0_t* self, uint8_t reg);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+
+static const sim_dev_ops_t _ops = {
+    .start = _start,
+    .write = _write,
+    .read  = _read,
+};
+
+static const uint32_t _prox_period_ns[] = {
+    [VCNL4010_REG_PROX_RATE_1p95HZ]    = 512820513u,
+    [VCNL4010_REG_PROX_RATE_3p90625HZ] = 256000000u,
+    [VCNL4010_REG_PROX_RATE_7p8125HZ]  = 128000000u,
+    [VCNL4010_REG_PROX_RATE_16p625HZ]  = 60150376u,
+    [VCNL4010_REG_PROX_RATE_31p25HZ]   = 32000000u,
+    [VCNL4010_REG_PROX_RATE_62p5HZ]    = 16000000u,
+    [VCNL4010_REG_PROX_RATE_125HZ]     = 8000000u,
+    [VCNL4010_REG_PROX_RATE_250HZ]     = 4000000u,
+};
+
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+void sim_vcnl4000_init(sim_vcnl40x0_t* self)
+{
+    _init(self, false);
+}
+
+void sim_vcnl4010_init(sim_vcnl40x0_t* self)
+{
+    _init(self, true);
+}
+
+bool sim_vcnl4010_int_pending(sim_vcnl40x0_t* self)
+{
+    _update(self);
+
+    return self->regs[VCNL4010_REG_INT_STATUS] != 0;
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static void _init(sim_vcnl40x0_t* self, bool is_4010)
+{
+    memset(self, 0, sizeof(*self));
+    self->dev.ops        = &_ops;
+    self->is_4010        = is_4010;
+    self->rng            = 0x2545F491u;
+    self->alight_conv_ns = ALIGHT_CONV_NS;
+
+    self->regs[VCNL4010_REG_VERSION]      = is_4010 ? VERSION_4010 : VERSION_4000;
+    self->regs[VCNL4010_REG_IR_CURRENT]   = is_4010 ? 2 : 20;
+    self->regs[VCNL4010_REG_ALIGHT_PARAM] = 0x0D;
+}
+
+static bool _start(sim_dev_t* dev, bool is_read)
+{
+    sim_vcnl40x0_t* self = (sim_vcnl40x0_t*)dev;
+
+    if (!is_read)
+    {
+        self->has_addr = false;
+    }
+
+    return true;
+}
+
+static bool _write(sim_dev_t* dev, uint8_t byte)
+{
+    sim_vcnl40x0_t* self = (sim_vcnl40x0_t*)dev;
+
+    if (!self->has_addr)
+    {
+        self->addr     = byte & 0x0F;
+        self->has_addr = true;
+        return true;
+    }
+
+    _update(self);
+    _reg_set(self, self->addr, byte);
+    self->addr = (self->addr + 1) & 0x0F;
+
+    return true;
+}
+
+static uint8_t _read(sim_dev_t* dev)
+{
+    sim_vcnl40x0_t* self = (sim_vcnl40x0_t*)dev;
+    uint8_t value;
+
+    _update(self);
+
+    value      = self->regs[self->addr];
+    self->addr = (self->addr + 1) & 0x0F;
+
+    return value;
+}
+
+static void _reg_set(sim_vcnl40x0_t* self, uint8_t reg, uint8_t value)
+{
+    uint64_t now = self->dev.bus->now_ns;
+    uint8_t* cmd = &self->regs[VCNL4010_REG_COMMAND];
+
+    switch (reg)
+    {
+    case VCNL4010_REG_COMMAND:
+        if (!self->is_4010)
+        {
+            value &= CMD_PROX_OD | CMD_ALIGHT_OD;
+        }
+
+        if ((value & CMD_PROX_OD) && !self->prox_busy)
+        {
+            *cmd &= ~CMD_PROX_READY;
+            self->prox_busy     = true;
+            self->prox_ready_ns = now + PROX_CONV_NS;
+        }
+        if ((value & CMD_ALIGHT_OD) && !self->alight_busy)
+        {
+            *cmd &= ~CMD_ALIGHT_READY;
+            self->alight_busy     = true;
+            self->alight_ready_ns = now + self->alight_conv_ns;
+        }
+
+        if ((value & (CMD_SELF_TIMED | CMD_PROX_EN)) == (CMD_SELF_TIMED | CMD_PROX_EN) &&
+            (*cmd & (CMD_SELF_TIMED | CMD_PROX_EN)) != (CMD_SELF_TIMED | CMD_PROX_EN))
+        {
+            self->next_self_timed_ns = now + _prox_period_ns[self->regs[VCNL4010_REG_PROX_RATE] & 7];
+            self->exceed             = 0;
+        }
+
+        *cmd = (*cmd & (CMD_PROX_READY | CMD_ALIGHT_READY | CMD_PROX_OD | CMD_ALIGHT_OD)) |
+               (value & (CMD_SELF_TIMED | CMD_PROX_EN | (1u << 2)));
+        if (self->prox_busy)
+        {
+            *cmd |= CMD_PROX_OD;
+        }
+        if (self->alight_busy)
+        {
+            *cmd |= CMD_ALIGHT_OD;
+        }
+        break;
+
+    case VCNL4010_REG_VERSION:
+    case VCNL4010_REG_ALIGHT_RESULT_H:
+    case VCNL4010_REG_ALIGHT_RESULT_L:
+    case VCNL4010_REG_PROX_RESULT_H:
+    case VCNL4010_REG_PROX_RESULT_L:
+        break;
+
+    case VCNL4010_REG_IR_CURRENT:
+        self->regs[reg] = value & 0x3F;
+        break;
+
+    case VCNL4010_REG_INT_STATUS:
+        // write one to clear
+        self->regs[reg] &= ~value;
+        break;
+
+    default:
+        if (self->is_4010 || (reg <= VCNL4000_REG_PROX_MODULATOR))
+        {
+            self->regs[reg] = value;
+        }
+        break;
+    }
+}
+
+static void _update(sim_vcnl40x0_t* self)
+{
+    uint64_t now = self->dev.bus->now_ns;
+    uint8_t* cmd = &self->regs[VCNL4010_REG_COMMAND];
+    uint16_t value;
+
+    if (self->prox_busy && (now >= self->prox_ready_ns))
+    {
+        value = _measure_prox(self);
+
+        self->regs[VCNL4010_REG_PROX_RESULT_H] = value >> 8;
+        self->regs[VCNL4010_REG_PROX_RESULT_L] = value & 0xFF;
+        self->prox_busy                        = false;
+        *cmd = (*cmd & ~CMD_PROX_OD) | CMD_PROX_READY;
+    }
+
+    if (self->alight_busy && (now >= self->alight_ready_ns))
+    {
+        self->regs[VCNL4010_REG_ALIGHT_RESULT_H] = self->alight_in >> 8;
+        self->regs[VCNL4010_REG_ALIGHT_RESULT_L] = self->alight_in & 0xFF;
+        self->alight_busy                        = false;
+        *cmd = (*cmd & ~CMD_ALIGHT_OD) | CMD_ALIGHT_READY;
+    }
+
+    if (self->is_4010 && ((*cmd & (CMD_SELF_TIMED | CMD_PROX_EN)) == (CMD_SELF_TIMED | CMD_PROX_EN)))
+    {
+        _self_timed(self);
+    }
+}
+
+static uint16_t _measure_prox(sim_vcnl40x0_t* self)
+{
+    int32_t value = (int32_t)((uint32_t)self->prox_in * self->regs[VCNL4010_REG_IR_CURRENT] / IR_CURRENT_REF);
+
+    if (self->prox_noise != 0)
+    {
+        // xorshift32, uniform noise of prox_noise counts peak-to-peak
+        self->rng ^= self->rng << 13;
+        self->rng ^= self->rng >> 17;
+        self->rng ^= self->rng << 5;
+        value += (int32_t)(self->rng % (self->prox_noise + 1u)) - self->prox_noise / 2;
+    }
+
+    return (value < 0) ? 0 : (value > UINT16_MAX) ? UINT16_MAX : (uint16_t)value;
+}
+
+static void _self_timed(sim_vcnl40x0_t* self)
+{
+    uint64_t now    = self->dev.bus->now_ns;
+    uint64_t period = _prox_period_ns[self->regs[VCNL4010_REG_PROX_RATE] & 7];
+    uint8_t ctrl    = self->regs[VCNL4010_REG_INT_CTRL];
+    uint8_t* status = &self->regs[VCNL4010_REG_INT_STATUS];
+    uint16_t value;
+
+    if (now < self->next_self_timed_ns)
+    {
+        return;
+    }
+
+    // long idle periods replay only the last measurements
+    if ((now - self->next_self_timed_ns) / period > MAX_SKIPPED)
+    {
+        self->next_self_timed_ns += ((now - self->next_self_timed_ns) / period - MAX_SKIPPED) * period;
+    }
+
+    for (; self->next_self_timed_ns <= now; self->next_self_timed_ns += period)
+    {
+        value = _measure_prox(self);
+
+        self->regs[VCNL4010_REG_PROX_RESULT_H] = value >> 8;
+        self->regs[VCNL4010_REG_PROX_RESULT_L] = value & 0xFF;
+        self->regs[VCNL4010_REG_COMMAND] |= CMD_PROX_READY;
+
+        if (ctrl & INT_CTRL_PROX_EN)
+        {
+            *status |= INT_STATUS_PROX;
+        }
+
+        if (!(ctrl & INT_CTRL_THRSH_EN))
+        {
+            continue;
+        }
+
+        if (ctrl & INT_CTRL_SEL_ALIGHT)
+        {
+            value = self->alight_in;
+        }
+
+        if ((value > _reg16(self, VCNL4010_REG_HIGH_THRSH_H)) || (value < _reg16(self, VCNL4010_REG_LOW_THRSH_H)))
+        {
+            if (self->exceed < UINT8_MAX)
+            {
+                self->exceed++;
+            }
+            if (self->exceed >= INT_CTRL_EXCEED(ctrl))
+            {
+                *status |= (value > _reg16(self, VCNL4010_REG_HIGH_THRSH_H)) ? INT_STATUS_HIGH : INT_STATUS_LOW;
+            }
+        }
+        else
+        {
+            self->exceed = 0;
+        }
+    }
+}
+
+static uint16_t _reg16(const sim_vcnl40x0_t* self, uint8_t reg)
+{
+    return (uint16_t)((self->regs[reg] << 8) | self->regs[reg + 1]);
+}
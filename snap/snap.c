@@ -0,0 +1,666 @@
+
+/* ===== INCLUDES =========================================================== */
+
+#include "snap.h"
+
+#include <string.h>
+
+#include "regmap.h"
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define HEADER_SIZE       (8)
+#define ENTRY_HEADER_SIZE (2)
+#define CRC_SIZE          (2)
+#define PAYLOAD_MAX_SIZE  (TSL2591_REG_DEVICE_ID + 1)
+
+#define INA226_PAYLOAD_SIZE  (12)
+#define DS18B20_PAYLOAD_SIZE (12)
+#define SI7006_PAYLOAD_SIZE  (3)
+
+/* ===== TYPES ============================================================== */
+
+typedef int (*block_read_t)(void* driver, uint8_t reg, void* data, uint8_t size);
+typedef int (*block_write_t)(void* driver, uint8_t reg, const void* data, uint8_t size);
+
+//! Registers from address 0 read in one transaction, with the configuration bits of each
+typedef struct
+{
+    block_read_t read;
+    block_write_t write;
+    const uint8_t* masks;
+    uint8_t size;
+    uint8_t id_reg;
+    uint8_t id_mask;
+    uint8_t id_value;
+} block_desc_t;
+
+typedef struct
+{
+    uint8_t reg;
+    uint16_t mask;
+} ina226_reg_desc_t;
+
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static int _capture(snap_dev_t* dev, uint8_t* payload, uint8_t* size);
+static int _apply(snap_dev_t* dev, const uint8_t* payload, uint8_t size);
+static int _ina226_capture(ina226_handle_t* handle, uint8_t* payload);
+static int _ina226_apply(snap_dev_t* dev, const uint8_t* payload);
+static void _ds18b20_capture(const ds18b20_handle_t* handle, uint8_t* payload);
+static int _si7006_capture(si7006_driver_t* driver, uint8_t* payload);
+static int _si7006_apply(snap_dev_t* dev, const uint8_t* payload);
+static int _block_capture(void* driver, const block_desc_t* desc, uint8_t* payload, uint8_t* size);
+static int _block_apply(snap_dev_t* dev, const block_desc_t* desc, const uint8_t* payload);
+
+static int _tsl2591_read(void* driver, uint8_t reg, void* data, uint8_t size);
+static int _tsl2591_write(void* driver, uint8_t reg, const void* data, uint8_t size);
+static int _vcnl4000_read(void* driver, uint8_t reg, void* data, uint8_t size);
+static int _vcnl4000_write(void* driver, uint8_t reg, const void* data, uint8_t size);
+static int _vcnl4010_read(void* driver, uint8_t reg, void* data, uint8_t size);
+static int _vcnl4010_write(void* driver, uint8_t reg, const void* data, uint8_t size);
+
+static int _mc24xx_read(void* arg, uint32_t offset, void* data, size_t size);
+static int _mc24xx_write(void* arg, uint32_t offset, const void* data, size_t size);
+static int _file_read(void* arg, uint32_t offset, void* data, size_t size);
+static int _file_write(void* arg, uint32_t offset, const void* data, size_t size);
+
+static uint16_t _crc16(const uint8_t* data, size_t size);
+static void _put16(uint8_t* p, uint16_t value);
+static uint16_t _get16(const uint8_t* p);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+
+static const ina226_reg_desc_t _ina226_regs[] = {
+    {INA226_REG_CONFIGURATION, (uint16_t)~REGMAP_MASK(INA226_CONF_RESET)},
+    {INA226_REG_CALIBRATION, 0x7FFF}, // bit 15 is reserved
+    {INA226_REG_MASK_ENABLE,
+     REGMAP_MASK(INA226_MASK_ALERT_LATCH_EN) | REGMAP_MASK(INA226_MASK_ALERT_POLARITY) |
+         REGMAP_MASK(INA226_MASK_CONV_READY_ALERT) | REGMAP_MASK(INA226_MASK_POWER_OVERLIMIT) |
+         REGMAP_MASK(INA226_MASK_VBUS_UNDER_LIMIT) | REGMAP_MASK(INA226_MASK_VBUS_OVER_LIMIT) |
+         REGMAP_MASK(INA226_MASK_SHUNT_UNDER_LIMIT) | REGMAP_MASK(INA226_MASK_SHUNT_OVER_LIMIT)},
+    {INA226_REG_ALERT_LIMIT, 0xFFFF},
+};
+
+static const uint8_t _tsl2591_masks[TSL2591_REG_DEVICE_ID + 1] = {
+    [TSL2591_REG_ENABLE] = REGMAP_MASK(TSL2591_ENABLE_PON) | REGMAP_MASK(TSL2591_ENABLE_AEN) |
+                           REGMAP_MASK(TSL2591_ENABLE_AIEN) | REGMAP_MASK(TSL2591_ENABLE_SAI) |
+                           REGMAP_MASK(TSL2591_ENABLE_NPIEN),
+    [TSL2591_REG_CONFIG]                  = REGMAP_MASK(TSL2591_CONFIG_ATIME) | REGMAP_MASK(TSL2591_CONFIG_AGAIN),
+    [TSL2591_REG_INT_LOW_THRESHOLD_L]     = 0xFF,
+    [TSL2591_REG_INT_LOW_THRESHOLD_H]     = 0xFF,
+    [TSL2591_REG_INT_HIGH_THRESHOLD_L]    = 0xFF,
+    [TSL2591_REG_INT_HIGH_THRESHOLD_H]    = 0xFF,
+    [TSL2591_REG_NP_INT_LOW_THRESHOLD_L]  = 0xFF,
+    [TSL2591_REG_NP_INT_LOW_THRESHOLD_H]  = 0xFF,
+    [TSL2591_REG_NP_INT_HIGH_THRESHOLD_L] = 0xFF,
+    [TSL2591_REG_NP_INT_HIGH_THRESHOLD_H] = 0xFF,
+    [TSL2591_REG_INT_PERS_FILTER]         = REGMAP_MASK(TSL2591_PERSIST_APERS),
+};
+
+static const uint8_t _vcnl4000_masks[VCNL4000_REG_PROX_MODULATOR + 1] = {
+    [VCNL4000_REG_IR_CURRENT] = REGMAP_MASK(VCNL4000_IR_CURRENT_VALUE),
+    [VCNL4000_REG_ALIGHT_PARAM] = REGMAP_MASK(VCNL4000_ALIGHT_PARAM_AVERAGE) |
+                                  REGMAP_MASK(VCNL4000_ALIGHT_PARAM_AUTO_OFFSET) |
+                                  REGMAP_MASK(VCNL4000_ALIGHT_PARAM_CONTINUOUS),
+    [VCNL4000_REG_PROX_FREQ] = REGMAP_MASK(VCNL4000_PROX_FREQ_FREQ),
+    [VCNL4000_REG_PROX_MODULATOR] =
+        REGMAP_MASK(VCNL4000_PROX_MODULATOR_DEAD_TIME) | REGMAP_MASK(VCNL4000_PROX_MODULATOR_DELAY_TIME),
+};
+
+static const uint8_t _vcnl4010_masks[VCNL4010_REG_PROX_MODULATOR + 1] = {
+    [VCNL4010_REG_COMMAND] = REGMAP_MASK(VCNL4010_COMMAND_SELF_TIMED_EN) | REGMAP_MASK(VCNL4010_COMMAND_PROX_EN) |
+                             REGMAP_MASK(VCNL4010_COMMAND_ALIGHT_EN),
+    [VCNL4010_REG_PROX_RATE]  = REGMAP_MASK(VCNL4010_PROX_RATE_RATE),
+    [VCNL4010_REG_IR_CURRENT] = REGMAP_MASK(VCNL4010_IR_CURRENT_VALUE),
+    [VCNL4010_REG_ALIGHT_PARAM] =
+        REGMAP_MASK(VCNL4010_ALIGHT_PARAM_AVERAGE) | REGMAP_MASK(VCNL4010_ALIGHT_PARAM_AUTO_OFFSET) |
+        REGMAP_MASK(VCNL4010_ALIGHT_PARAM_RATE) | REGMAP_MASK(VCNL4010_ALIGHT_PARAM_CONTINUOUS),
+    [VCNL4010_REG_INT_CTRL] = REGMAP_MASK(VCNL4010_INT_CTRL_THRSH_SEL) | REGMAP_MASK(VCNL4010_INT_CTRL_THRSH_EN) |
+                              REGMAP_MASK(VCNL4010_INT_CTRL_ALIGHT_READY_EN) |
+                              REGMAP_MASK(VCNL4010_INT_CTRL_PROX_READY_EN) |
+                              REGMAP_MASK(VCNL4010_INT_CTRL_COUNT_EXCEED),
+    [VCNL4010_REG_LOW_THRSH_H]  = 0xFF,
+    [VCNL4010_REG_LOW_THRSH_L]  = 0xFF,
+    [VCNL4010_REG_HIGH_THRSH_H] = 0xFF,
+    [VCNL4010_REG_HIGH_THRSH_L] = 0xFF,
+    [VCNL4010_REG_PROX_MODULATOR] = REGMAP_MASK(VCNL4010_PROX_MODULATOR_DEAD_TIME) |
+                                    REGMAP_MASK(VCNL4010_PROX_MODULATOR_FREQ) |
+                                    REGMAP_MASK(VCNL4010_PROX_MODULATOR_DELAY_TIME),
+};
+
+static const block_desc_t _blocks[] = {
+    [SNAP_DEV_TSL2591] =
+        {
+            .read     = _tsl2591_read,
+            .write    = _tsl2591_write,
+            .masks    = _tsl2591_masks,
+            .size     = sizeof(_tsl2591_masks),
+            .id_reg   = TSL2591_REG_DEVICE_ID,
+            .id_mask  = 0xFF,
+            .id_value = TSL2591_DEVICE_ID,
+        },
+    [SNAP_DEV_VCNL4000] =
+        {
+            .read     = _vcnl4000_read,
+            .write    = _vcnl4000_write,
+            .masks    = _vcnl4000_masks,
+            .size     = sizeof(_vcnl4000_masks),
+            .id_reg   = VCNL4000_REG_VERSION,
+            .id_mask  = REGMAP_MASK(VCNL4000_VERSION_PRODUCT),
+            .id_value = REGMAP_VAL(VCNL4000_VERSION_PRODUCT, VCNL4000_PRODUCT_ID),
+        },
+    [SNAP_DEV_VCNL4010] =
+        {
+            .read     = _vcnl4010_read,
+            .write    = _vcnl4010_write,
+            .masks    = _vcnl4010_masks,
+            .size     = sizeof(_vcnl4010_masks),
+            .id_reg   = VCNL4010_REG_VERSION,
+            .id_mask  = REGMAP_MASK(VCNL4010_VERSION_PRODUCT),
+            .id_value = REGMAP_VAL(VCNL4010_VERSION_PRODUCT, VCNL4010_PRODUCT_ID),
+        },
+};
+
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+void snap_store_mc24xx(snap_store_t* store,
+                       snap_mc24xx_t* ctx,
+                       mc24xx_driver_t* eeprom,
+                       snap_get_us_t get_us,
+                       uint16_t address)
+{
+    ctx->eeprom = eeprom;
+    ctx->get_us = get_us;
+
+    *store = (snap_store_t){
+        .read   = _mc24xx_read,
+        .write  = _mc24xx_write,
+        .arg    = ctx,
+        .offset = address,
+    };
+}
+
+void snap_store_file(snap_store_t* store, FILE* file)
+{
+    *store = (snap_store_t){
+        .read  = _file_read,
+        .write = _file_write,
+        .arg   = file,
+    };
+}
+
+int snap_save(const snap_store_t* store, snap_dev_t* devs, size_t count)
+{
+    uint8_t image[SNAP_MAX_SIZE];
+    uint8_t stored[SNAP_MAX_SIZE];
+    size_t size = HEADER_SIZE;
+    int res;
+
+    if (count > UINT8_MAX)
+    {
+        return 1;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (size + ENTRY_HEADER_SIZE + PAYLOAD_MAX_SIZE + CRC_SIZE > SNAP_MAX_SIZE)
+        {
+            return 1;
+        }
+
+        res = _capture(&devs[i], &image[size + ENTRY_HEADER_SIZE], &image[size + 1]);
+        if (res != 0)
+        {
+            return res;
+        }
+
+        image[size] = (uint8_t)devs[i].type;
+        size += ENTRY_HEADER_SIZE + image[size + 1];
+    }
+
+    size += CRC_SIZE;
+
+    _put16(&image[0], (uint16_t)SNAP_MAGIC);
+    _put16(&image[2], (uint16_t)(SNAP_MAGIC >> 16));
+    image[4] = SNAP_VERSION;
+    image[5] = (uint8_t)count;
+    _put16(&image[6], (uint16_t)size);
+    _put16(&image[size - CRC_SIZE], _crc16(image, size - CRC_SIZE));
+
+    // spares the EEPROM a write cycle when nothing changed since the last save
+    if ((store->read(store->arg, store->offset, stored, size) == 0) && (memcmp(stored, image, size) == 0))
+    {
+        return 0;
+    }
+
+    return store->write(store->arg, store->offset, image, size);
+}
+
+int snap_restore(const snap_store_t* store, snap_dev_t* devs, size_t count)
+{
+    uint8_t image[SNAP_MAX_SIZE];
+    size_t size;
+    size_t pos;
+    int failed = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        devs[i].res    = 1;
+        devs[i].writes = 0;
+    }
+
+    if (store->read(store->arg, store->offset, image, HEADER_SIZE) != 0)
+    {
+        return 1;
+    }
+
+    size = _get16(&image[6]);
+
+    if ((_get16(&image[0]) != (uint16_t)SNAP_MAGIC) || (_get16(&image[2]) != (uint16_t)(SNAP_MAGIC >> 16)) ||
+        (image[4] != SNAP_VERSION) || (image[5] != count) || (size < HEADER_SIZE + CRC_SIZE) ||
+        (size > SNAP_MAX_SIZE))
+    {
+        return 1;
+    }
+
+    if ((store->read(store->arg, store->offset + HEADER_SIZE, &image[HEADER_SIZE], size - HEADER_SIZE) != 0) ||
+        (_get16(&image[size - CRC_SIZE]) != _crc16(image, size - CRC_SIZE)))
+    {
+        return 1;
+    }
+
+    // the whole device list is checked before anything is written to a device
+    pos = HEADER_SIZE;
+    for (size_t i = 0; i < count; i++)
+    {
+        if ((pos + ENTRY_HEADER_SIZE > size - CRC_SIZE) || (image[pos] != devs[i].type) ||
+            (pos + ENTRY_HEADER_SIZE + image[pos + 1] > size - CRC_SIZE))
+        {
+            return 1;
+        }
+
+        pos += ENTRY_HEADER_SIZE + image[pos + 1];
+    }
+
+    pos = HEADER_SIZE;
+    for (size_t i = 0; i < count; i++)
+    {
+        devs[i].res = _apply(&devs[i], &image[pos + ENTRY_HEADER_SIZE], image[pos + 1]);
+        failed |= (devs[i].res != 0);
+
+        pos += ENTRY_HEADER_SIZE + image[pos + 1];
+    }
+
+    return failed;
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static int _capture(snap_dev_t* dev, uint8_t* payload, uint8_t* size)
+{
+    switch (dev->type)
+    {
+        case SNAP_DEV_INA226:
+            *size = INA226_PAYLOAD_SIZE;
+            return _ina226_capture(dev->driver, payload);
+
+        case SNAP_DEV_DS18B20:
+            *size = DS18B20_PAYLOAD_SIZE;
+            _ds18b20_capture(dev->driver, payload);
+            return ((const ds18b20_handle_t*)dev->driver)->inited ? 0 : 1;
+
+        case SNAP_DEV_SI7006:
+            *size = SI7006_PAYLOAD_SIZE;
+            return _si7006_capture(dev->driver, payload);
+
+        case SNAP_DEV_TSL2591:
+        case SNAP_DEV_VCNL4000:
+        case SNAP_DEV_VCNL4010:
+            return _block_capture(dev->driver, &_blocks[dev->type], payload, size);
+    }
+
+    return 1;
+}
+
+static int _apply(snap_dev_t* dev, const uint8_t* payload, uint8_t size)
+{
+    ds18b20_handle_t* handle;
+
+    switch (dev->type)
+    {
+        case SNAP_DEV_INA226:
+            return (size == INA226_PAYLOAD_SIZE) ? _ina226_apply(dev, payload) : 1;
+
+        case SNAP_DEV_DS18B20:
+            if (size != DS18B20_PAYLOAD_SIZE)
+            {
+                return 1;
+            }
+
+            // resume addresses the sensor the way it was addressed when saved
+            handle         = dev->driver;
+            handle->use_id = payload[11];
+            return ds18b20_resume(handle,
+                                  (uint64_t)_get16(&payload[0]) | ((uint64_t)_get16(&payload[2]) << 16) |
+                                      ((uint64_t)_get16(&payload[4]) << 32) | ((uint64_t)_get16(&payload[6]) << 48),
+                                  &payload[8]);
+
+        case SNAP_DEV_SI7006:
+            return (size == SI7006_PAYLOAD_SIZE) ? _si7006_apply(dev, payload) : 1;
+
+        case SNAP_DEV_TSL2591:
+        case SNAP_DEV_VCNL4000:
+        case SNAP_DEV_VCNL4010:
+            return (size == _blocks[dev->type].size) ? _block_apply(dev, &_blocks[dev->type], payload) : 1;
+    }
+
+    return 1;
+}
+
+static int _ina226_capture(ina226_handle_t* handle, uint8_t* payload)
+{
+    uint16_t value;
+    int res;
+
+    for (size_t i = 0; i < sizeof(_ina226_regs) / sizeof(_ina226_regs[0]); i++)
+    {
+        res = ina226_reg_read(handle, _ina226_regs[i].reg, &value);
+        if (res != 0)
+        {
+            return res;
+        }
+
+        // flags and reserved bits would make every snapshot differ from the stored one
+        _put16(&payload[2 * i], value & _ina226_regs[i].mask);
+    }
+
+    memcpy(&payload[8], &handle->curr_sens, sizeof(handle->curr_sens));
+
+    return 0;
+}
+
+static int _ina226_apply(snap_dev_t* dev, const uint8_t* payload)
+{
+    ina226_handle_t* handle = dev->driver;
+    ina226_chip_info_t info;
+    uint16_t value;
+    uint16_t saved;
+    int res;
+
+    res = ina226_get_chip_info(handle, &info);
+    if ((res != 0) || (info.manufacturer != INA226_MANUFACTURER) || (info.chip_id != INA226_CHIP_IDENTIFIER))
+    {
+        return (res != 0) ? res : 1;
+    }
+
+    for (size_t i = 0; i < sizeof(_ina226_regs) / sizeof(_ina226_regs[0]); i++)
+    {
+        res = ina226_reg_read(handle, _ina226_regs[i].reg, &value);
+        if (res != 0)
+        {
+            return res;
+        }
+
+        saved = _get16(&payload[2 * i]);
+        if (((value ^ saved) & _ina226_regs[i].mask) != 0)
+        {
+            res = ina226_reg_write(handle, _ina226_regs[i].reg, REGMAP_UPDATE(value, _ina226_regs[i].mask, saved));
+            if (res != 0)
+            {
+                return res;
+            }
+            dev->writes++;
+        }
+    }
+
+    memcpy(&handle->curr_sens, &payload[8], sizeof(handle->curr_sens));
+
+    return 0;
+}
+
+static void _ds18b20_capture(const ds18b20_handle_t* handle, uint8_t* payload)
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        _put16(&payload[2 * i], (uint16_t)(handle->dev_id >> (16 * i)));
+    }
+
+    memcpy(&payload[8], handle->scratchpad, sizeof(handle->scratchpad));
+    payload[11] = handle->use_id;
+}
+
+static int _si7006_capture(si7006_driver_t* driver, uint8_t* payload)
+{
+    si7006_setup_resolution_t resolution;
+    si7006_reg_heater_ctrl_t heater;
+    bool heater_en;
+    int res;
+
+    res = si7006_read_setup(driver, &resolution, &heater_en, NULL);
+    if (res == 0)
+    {
+        res = si7006_read_heater_ctrl(driver, &heater);
+    }
+
+    payload[0] = (uint8_t)resolution;
+    payload[1] = heater_en;
+    payload[2] = heater.current;
+
+    return res;
+}
+
+static int _si7006_apply(snap_dev_t* dev, const uint8_t* payload)
+{
+    si7006_driver_t* driver = dev->driver;
+    si7006_setup_resolution_t resolution;
+    si7006_reg_heater_ctrl_t heater;
+    bool heater_en;
+    int res;
+
+    // the user register read refreshes the driver's resolution as well
+    res = si7006_read_setup(driver, &resolution, &heater_en, NULL);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    if ((resolution != payload[0]) || (heater_en != payload[1]))
+    {
+        res = si7006_write_setup(driver, (si7006_setup_resolution_t)payload[0], payload[1]);
+        if (res != 0)
+        {
+            return res;
+        }
+        dev->writes++;
+    }
+
+    res = si7006_read_heater_ctrl(driver, &heater);
+    if ((res == 0) && (heater.current != payload[2]))
+    {
+        res = si7006_write_heater_ctrl(driver, (si7006_reg_heater_ctrl_t){.current = payload[2]});
+        dev->writes++;
+    }
+
+    return res;
+}
+
+static int _block_capture(void* driver, const block_desc_t* desc, uint8_t* payload, uint8_t* size)
+{
+    int res;
+
+    *size = desc->size;
+
+    res = desc->read(driver, 0, payload, desc->size);
+
+    // only the configuration is kept, the results and status change from one capture to the next
+    for (uint8_t reg = 0; reg < desc->size; reg++)
+    {
+        payload[reg] &= desc->masks[reg];
+    }
+
+    return res;
+}
+
+static int _block_apply(snap_dev_t* dev, const block_desc_t* desc, const uint8_t* payload)
+{
+    uint8_t regs[PAYLOAD_MAX_SIZE];
+    uint8_t value;
+    int res;
+
+    res = desc->read(dev->driver, 0, regs, desc->size);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    if ((regs[desc->id_reg] & desc->id_mask) != desc->id_value)
+    {
+        return 1;
+    }
+
+    // register 0 enables the measurements and goes last
+    for (uint8_t i = 1; i <= desc->size; i++)
+    {
+        uint8_t reg = i % desc->size;
+
+        if (((regs[reg] ^ payload[reg]) & desc->masks[reg]) == 0)
+        {
+            continue;
+        }
+
+        value = REGMAP_UPDATE(regs[reg], desc->masks[reg], payload[reg]);
+        res   = desc->write(dev->driver, reg, &value, 1);
+        if (res != 0)
+        {
+            return res;
+        }
+        dev->writes++;
+    }
+
+    return 0;
+}
+
+static int _tsl2591_read(void* driver, uint8_t reg, void* data, uint8_t size)
+{
+    return tsl2591_read_regs(driver, (tsl2591_reg_t)reg, data, size);
+}
+
+static int _tsl2591_write(void* driver, uint8_t reg, const void* data, uint8_t size)
+{
+    return tsl2591_write_regs(driver, (tsl2591_reg_t)reg, data, size);
+}
+
+static int _vcnl4000_read(void* driver, uint8_t reg, void* data, uint8_t size)
+{
+    return vcnl4000_read_regs(driver, (vcnl4000_reg_t)reg, data, size);
+}
+
+static int _vcnl4000_write(void* driver, uint8_t reg, const void* data, uint8_t size)
+{
+    return vcnl4000_write_regs(driver, (vcnl4000_reg_t)reg, data, size);
+}
+
+static int _vcnl4010_read(void* driver, uint8_t reg, void* data, uint8_t size)
+{
+    return vcnl4010_read_regs(driver, (vcnl4010_reg_t)reg, data, size);
+}
+
+static int _vcnl4010_write(void* driver, uint8_t reg, const void* data, uint8_t size)
+{
+    return vcnl4010_write_regs(driver, (vcnl4010_reg_t)reg, data, size);
+}
+
+static int _mc24xx_read(void* arg, uint32_t offset, void* data, size_t size)
+{
+    snap_mc24xx_t* ctx = arg;
+
+    return mc24xx_read_data(ctx->eeprom, (uint16_t)offset, data, (uint16_t)size);
+}
+
+static int _mc24xx_write(void* arg, uint32_t offset, const void* data, size_t size)
+{
+    snap_mc24xx_t* ctx   = arg;
+    const uint8_t* bytes = data;
+    uint32_t start;
+    int res;
+
+    // a page write wraps around within its page, so the data is split at the page boundaries
+    while (size != 0)
+    {
+        size_t chunk = MC24XX_PAGE_SIZE - (offset % MC24XX_PAGE_SIZE);
+
+        if (chunk > size)
+        {
+            chunk = size;
+        }
+
+        res = mc24xx_write_data(ctx->eeprom, (uint16_t)offset, bytes, (uint16_t)chunk);
+        if (res != 0)
+        {
+            return res;
+        }
+
+        // the poll rate depends on the bus clock, so the write cycle is bounded in time
+        start = ctx->get_us();
+        do
+        {
+            res = mc24xx_poll_ready(ctx->eeprom, 1);
+        } while ((res != 0) && (ctx->get_us() - start < SNAP_MC24XX_TIMEOUT_US));
+
+        if (res != 0)
+        {
+            return res;
+        }
+
+        offset += chunk;
+        bytes += chunk;
+        size -= chunk;
+    }
+
+    return 0;
+}
+
+static int _file_read(void* arg, uint32_t offset, void* data, size_t size)
+{
+    FILE* file = arg;
+
+    return (fseek(file, (long)offset, SEEK_SET) != 0) || (fread(data, 1, size, file) != size);
+}
+
+static int _file_write(void* arg, uint32_t offset, const void* data, size_t size)
+{
+    FILE* file = arg;
+
+    return (fseek(file, (long)offset, SEEK_SET) != 0) || (fwrite(data, 1, size, file) != size) ||
+           (fflush(file) != 0);
+}
+
+static uint16_t _crc16(const uint8_t* data, size_t size)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+static void _put16(uint8_t* p, uint16_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static uint16_t _get16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
@@ -0,0 +1,113 @@
+#ifndef __SNAP_H__
+#define __SNAP_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ds18b20.h"
+#include "ina226.h"
+#include "mc24xx.h"
+#include "si7006.h"
+#include "tsl2591.h"
+#include "vcnl4000.h"
+#include "vcnl4010.h"
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define SNAP_MAGIC    (0x50414E53) // "SNAP"
+#define SNAP_VERSION  (1)
+#define SNAP_MAX_SIZE (256)
+
+#define SNAP_MC24XX_TIMEOUT_US (2 * MC24XX_WRITE_CYCLE_MS * 1000) //! acknowledge polling after every page
+
+/* ===== TYPES ============================================================== */
+
+typedef int (*snap_read_t)(void* arg, uint32_t offset, void* data, size_t size);
+typedef int (*snap_write_t)(void* arg, uint32_t offset, const void* data, size_t size);
+
+typedef struct
+{
+    snap_read_t read;
+    snap_write_t write;
+    void* arg;
+    uint32_t offset; //! of the snapshot within the store
+} snap_store_t;
+
+typedef uint32_t (*snap_get_us_t)(void);
+
+//! Context of an EEPROM store, it has to stay in place as long as the store is used
+typedef struct
+{
+    mc24xx_driver_t* eeprom;
+    snap_get_us_t get_us;
+} snap_mc24xx_t;
+
+typedef enum
+{
+    SNAP_DEV_INA226,   //! ina226_handle_t
+    SNAP_DEV_DS18B20,  //! ds18b20_handle_t
+    SNAP_DEV_SI7006,   //! si7006_driver_t
+    SNAP_DEV_TSL2591,  //! tsl2591_driver_t
+    SNAP_DEV_VCNL4000, //! vcnl4000_driver_t
+    SNAP_DEV_VCNL4010, //! vcnl4010_driver_t
+} snap_dev_type_t;
+
+/*
+ * A device taking part in a snapshot. The driver structure has to carry its bus
+ * binding before snap_restore(), i.e. the transport or callbacks are assigned
+ * directly instead of through ina226_init*() or ds18b20_init(), which is what a
+ * warm boot avoids.
+ */
+typedef struct
+{
+    snap_dev_type_t type;
+    void* driver;
+
+    int res;        //! of the last restore, the device needs a full init when not 0
+    uint8_t writes; //! registers the last restore had to rewrite
+} snap_dev_t;
+
+/*
+ * Snapshot layout: magic u32, version u8, device count u8 and size u16 of the
+ * whole snapshot (little-endian), then per device its type u8, payload size u8
+ * and payload, closed by a CRC-16/CCITT over everything before it. Payloads:
+ *   INA226          configuration, calibration, mask/enable and alert limit
+ *                   registers, curr_sens
+ *   DS18B20         dev_id, TL, TH, configuration, use_id
+ *   Si7006          resolution, heater enable and heater current
+ *   TSL2591/VCNL40x0 the register block from address 0 up to the ID register
+ *
+ * A restore checks the ID registers (INA226 manufacturer and chip ID, TSL2591
+ * device ID, VCNL40x0 product ID, Si7006 user register read, DS18B20 ROM code
+ * and scratchpad, see ds18b20_resume()) and only writes registers whose
+ * configuration bits differ from the snapshot.
+ * Status and result bits are ignored. The command or enable register of the
+ * light sensors is written last, after the configuration it starts.
+ */
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+//! Page-wise writes with acknowledge polling, address is the first byte of the region
+void snap_store_mc24xx(snap_store_t* store,
+                       snap_mc24xx_t* ctx,
+                       mc24xx_driver_t* eeprom,
+                       snap_get_us_t get_us,
+                       uint16_t address);
+//! file opened in binary update mode, e.g. "r+b"
+void snap_store_file(snap_store_t* store, FILE* file);
+
+//! Captures the devices after their full init, the store is only written when the snapshot changed
+int snap_save(const snap_store_t* store, snap_dev_t* devs, size_t count);
+
+/*
+ * Returns 0 when every device was restored. A snapshot that is missing, corrupt
+ * or taken of a different device list fails all devices, otherwise res of each
+ * device tells whether it needs a full init.
+ */
+int snap_restore(const snap_store_t* store, snap_dev_t* devs, size_t count);
+
+#endif /* __SNAP_H__ */
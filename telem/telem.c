@@ -0,0 +1,409 @@
+
+/* ===== INCLUDES =========================================================== */
+
+#include "telem.h"
+
+#include <string.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define VARINT_MAX_SIZE (5)
+#define COLUMN_MAX_SIZE (0xFFFF)
+#define FLAG_SIGNED     (1 << 0)
+
+#define BITS2BYTES(bits) (((bits) + 7) / 8)
+
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static size_t _column_bytes(const telem_channel_t* channel, const telem_column_t* col);
+static bool _fits(const telem_channel_t* channel, const telem_column_t* col);
+static void _put_varint(telem_column_t* col, uint32_t value);
+static int _get_varint(telem_column_t* col, uint32_t* value);
+static void _put_bits(telem_column_t* col, uint32_t value, uint8_t bits);
+static uint32_t _get_bits(telem_column_t* col, uint8_t bits);
+static void _put_u16(uint8_t* p, uint16_t value);
+static void _put_u32(uint8_t* p, uint32_t value);
+static uint16_t _get_u16(const uint8_t* p);
+static uint32_t _get_u32(const uint8_t* p);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+int telem_encoder_init(telem_encoder_t* enc, const telem_channel_t* channels, uint8_t count, void* buf, size_t size)
+{
+    size_t slice;
+
+    if ((count == 0) || (count > TELEM_MAX_CHANNELS))
+    {
+        return 1;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if ((channels[i].encoding > TELEM_ENC_BITPACK) || (channels[i].bits == 0) || (channels[i].bits > 32))
+        {
+            return 1;
+        }
+    }
+
+    slice = size / count;
+    if (slice > COLUMN_MAX_SIZE)
+    {
+        slice = COLUMN_MAX_SIZE;
+    }
+
+    memset(enc, 0, sizeof(*enc));
+    enc->channels = channels;
+    enc->count    = count;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        enc->cols[i].data = (uint8_t*)buf + i * slice;
+        enc->cols[i].size = slice;
+    }
+
+    return 0;
+}
+
+int telem_encoder_add(telem_encoder_t* enc, const int32_t* values)
+{
+    if (enc->rows == UINT16_MAX)
+    {
+        return 1;
+    }
+
+    for (uint8_t i = 0; i < enc->count; i++)
+    {
+        if (!_fits(&enc->channels[i], &enc->cols[i]))
+        {
+            return 1;
+        }
+    }
+
+    for (uint8_t i = 0; i < enc->count; i++)
+    {
+        const telem_channel_t* channel = &enc->channels[i];
+        telem_column_t* col            = &enc->cols[i];
+        uint32_t value                 = (uint32_t)values[i];
+
+        if (channel->encoding == TELEM_ENC_DELTA)
+        {
+            uint32_t delta = value - col->prev;
+
+            // zig-zag, small negative deltas stay small
+            _put_varint(col, (delta << 1) ^ (0u - (delta >> 31)));
+            col->prev = value;
+        }
+        else
+        {
+            _put_bits(col, value, channel->bits);
+        }
+    }
+
+    enc->rows++;
+
+    return 0;
+}
+
+int telem_encoder_finish(telem_encoder_t* enc, void* out, size_t size, size_t* length)
+{
+    uint8_t* p = out;
+
+    *length = telem_encoder_frame_size(enc);
+    if (*length > size)
+    {
+        return 1;
+    }
+
+    _put_u32(p, TELEM_MAGIC);
+    p[4] = TELEM_VERSION;
+    p[5] = enc->count;
+    _put_u16(&p[6], enc->rows);
+    p += TELEM_HEADER_SIZE;
+
+    for (uint8_t i = 0; i < enc->count; i++)
+    {
+        const telem_channel_t* channel = &enc->channels[i];
+        uint32_t scale;
+        uint32_t offset;
+
+        memcpy(&scale, &channel->scale, sizeof(scale));
+        memcpy(&offset, &channel->offset, sizeof(offset));
+
+        p[0] = channel->id;
+        p[1] = channel->encoding;
+        p[2] = channel->bits;
+        p[3] = channel->is_signed ? FLAG_SIGNED : 0;
+        _put_u32(&p[4], scale);
+        _put_u32(&p[8], offset);
+        _put_u16(&p[12], (uint16_t)_column_bytes(channel, &enc->cols[i]));
+        p += TELEM_CHANNEL_SIZE;
+    }
+
+    for (uint8_t i = 0; i < enc->count; i++)
+    {
+        size_t bytes = _column_bytes(&enc->channels[i], &enc->cols[i]);
+
+        memcpy(p, enc->cols[i].data, bytes);
+        p += bytes;
+
+        enc->cols[i].pos  = 0;
+        enc->cols[i].prev = 0;
+    }
+
+    enc->rows = 0;
+
+    return 0;
+}
+
+size_t telem_encoder_frame_size(const telem_encoder_t* enc)
+{
+    size_t size = TELEM_HEADER_SIZE + (size_t)enc->count * TELEM_CHANNEL_SIZE;
+
+    for (uint8_t i = 0; i < enc->count; i++)
+    {
+        size += _column_bytes(&enc->channels[i], &enc->cols[i]);
+    }
+
+    return size;
+}
+
+int telem_decoder_init(telem_decoder_t* dec, const void* frame, size_t size, size_t* length)
+{
+    const uint8_t* p = frame;
+    size_t total;
+
+    if ((size < TELEM_HEADER_SIZE) || (_get_u32(p) != TELEM_MAGIC) || (p[4] != TELEM_VERSION))
+    {
+        return 1;
+    }
+
+    memset(dec, 0, sizeof(*dec));
+    dec->count = p[5];
+    dec->rows  = _get_u16(&p[6]);
+
+    total = TELEM_HEADER_SIZE + (size_t)dec->count * TELEM_CHANNEL_SIZE;
+    if ((dec->count == 0) || (dec->count > TELEM_MAX_CHANNELS) || (total > size))
+    {
+        return 1;
+    }
+
+    p += TELEM_HEADER_SIZE;
+    for (uint8_t i = 0; i < dec->count; i++)
+    {
+        telem_channel_t* channel = &dec->channels[i];
+        uint32_t scale           = _get_u32(&p[4]);
+        uint32_t offset          = _get_u32(&p[8]);
+
+        channel->id        = p[0];
+        channel->encoding  = p[1];
+        channel->bits      = p[2];
+        channel->is_signed = (p[3] & FLAG_SIGNED) != 0;
+        memcpy(&channel->scale, &scale, sizeof(scale));
+        memcpy(&channel->offset, &offset, sizeof(offset));
+
+        dec->cols[i].size = _get_u16(&p[12]);
+
+        if ((channel->encoding > TELEM_ENC_BITPACK) || (channel->bits == 0) || (channel->bits > 32))
+        {
+            return 1;
+        }
+        if ((channel->encoding == TELEM_ENC_BITPACK) && (dec->cols[i].size < BITS2BYTES((size_t)dec->rows * channel->bits)))
+        {
+            return 1;
+        }
+
+        p += TELEM_CHANNEL_SIZE;
+    }
+
+    for (uint8_t i = 0; i < dec->count; i++)
+    {
+        if (total + dec->cols[i].size > size)
+        {
+            return 1;
+        }
+
+        dec->cols[i].data = (uint8_t*)frame + total;
+        total += dec->cols[i].size;
+    }
+
+    if (length != NULL)
+    {
+        *length = total;
+    }
+
+    return 0;
+}
+
+int telem_decoder_next(telem_decoder_t* dec, int32_t* values)
+{
+    if (dec->row == dec->rows)
+    {
+        return 1;
+    }
+
+    for (uint8_t i = 0; i < dec->count; i++)
+    {
+        const telem_channel_t* channel = &dec->channels[i];
+        telem_column_t* col            = &dec->cols[i];
+        uint32_t value;
+
+        if (channel->encoding == TELEM_ENC_DELTA)
+        {
+            if (_get_varint(col, &value) != 0)
+            {
+                return 1;
+            }
+
+            col->prev += (value >> 1) ^ (0u - (value & 1));
+            value = col->prev;
+        }
+        else
+        {
+            value = _get_bits(col, channel->bits);
+
+            if (channel->is_signed && (channel->bits < 32))
+            {
+                uint32_t sign = 1u << (channel->bits - 1);
+
+                value = (value ^ sign) - sign;
+            }
+        }
+
+        values[i] = (int32_t)value;
+    }
+
+    dec->row++;
+
+    return 0;
+}
+
+float telem_to_phys(const telem_channel_t* channel, int32_t raw)
+{
+    return (float)raw * channel->scale + channel->offset;
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static size_t _column_bytes(const telem_channel_t* channel, const telem_column_t* col)
+{
+    return (channel->encoding == TELEM_ENC_DELTA) ? col->pos : BITS2BYTES(col->pos);
+}
+
+static bool _fits(const telem_channel_t* channel, const telem_column_t* col)
+{
+    if (channel->encoding == TELEM_ENC_DELTA)
+    {
+        return (col->size - col->pos) >= VARINT_MAX_SIZE;
+    }
+
+    return (col->size * 8 - col->pos) >= channel->bits;
+}
+
+static void _put_varint(telem_column_t* col, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        col->data[col->pos++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+
+    col->data[col->pos++] = (uint8_t)value;
+}
+
+static int _get_varint(telem_column_t* col, uint32_t* value)
+{
+    uint32_t result = 0;
+
+    for (uint8_t shift = 0; shift < 35; shift += 7)
+    {
+        if (col->pos == col->size)
+        {
+            return 1;
+        }
+
+        uint8_t byte = col->data[col->pos++];
+
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            *value = result;
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void _put_bits(telem_column_t* col, uint32_t value, uint8_t bits)
+{
+    while (bits != 0)
+    {
+        uint8_t shift = col->pos & 7;
+        uint8_t count = 8 - shift;
+        uint8_t* byte = &col->data[col->pos >> 3];
+
+        if (count > bits)
+        {
+            count = bits;
+        }
+        if (shift == 0)
+        {
+            *byte = 0;
+        }
+
+        *byte |= (uint8_t)((value & ((1u << count) - 1u)) << shift);
+
+        value >>= count;
+        bits -= count;
+        col->pos += count;
+    }
+}
+
+static uint32_t _get_bits(telem_column_t* col, uint8_t bits)
+{
+    uint32_t value = 0;
+    uint8_t done   = 0;
+
+    while (done != bits)
+    {
+        uint8_t shift = col->pos & 7;
+        uint8_t count = 8 - shift;
+
+        if (count > bits - done)
+        {
+            count = bits - done;
+        }
+
+        value |= (uint32_t)((col->data[col->pos >> 3] >> shift) & ((1u << count) - 1u)) << done;
+
+        done += count;
+        col->pos += count;
+    }
+
+    return value;
+}
+
+static void _put_u16(uint8_t* p, uint16_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void _put_u32(uint8_t* p, uint32_t value)
+{
+    _put_u16(p, (uint16_t)value);
+    _put_u16(&p[2], (uint16_t)(value >> 16));
+}
+
+static uint16_t _get_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t _get_u32(const uint8_t* p)
+{
+    return _get_u16(p) | ((uint32_t)_get_u16(&p[2]) << 16);
+}
@@ -0,0 +1,94 @@
+#ifndef __TELEM_H__
+#define __TELEM_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define TELEM_MAX_CHANNELS (16)
+
+#define TELEM_MAGIC   (0x464D4C54) // "TLMF"
+#define TELEM_VERSION (1)
+
+#define TELEM_HEADER_SIZE  (8)
+#define TELEM_CHANNEL_SIZE (14)
+
+/* ===== TYPES ============================================================== */
+
+typedef enum
+{
+    TELEM_ENC_DELTA,   //! zig-zag varint of the difference to the previous row, for slowly changing values
+    TELEM_ENC_BITPACK, //! the low bits of every value, for noisy or bounded values
+} telem_encoding_t;
+
+/*
+ * Channel description, stored in every frame. Physical value = raw * scale + offset,
+ * see telem_channels.h for the driver outputs.
+ */
+typedef struct
+{
+    uint8_t id;
+    uint8_t encoding;  //! \ref telem_encoding_t
+    uint8_t bits;      //! value width, 1..32
+    bool is_signed;
+    float scale;
+    float offset;
+} telem_channel_t;
+
+typedef struct
+{
+    uint8_t* data;
+    size_t size;
+    size_t pos;      //! bytes for delta, bits for bitpack
+    uint32_t prev;
+} telem_column_t;
+
+/*
+ * Frame layout, little-endian:
+ *   header  magic u32, version u8, channel count u8, row count u16
+ *   channel id u8, encoding u8, bits u8, flags u8, scale f32, offset f32, column size u16
+ *   columns in channel order
+ * The encoder keeps every column in its own slice of the caller's buffer and
+ * copies them together on telem_encoder_finish().
+ */
+typedef struct
+{
+    const telem_channel_t* channels;
+    uint8_t count;
+    uint16_t rows;
+    telem_column_t cols[TELEM_MAX_CHANNELS];
+} telem_encoder_t;
+
+typedef struct
+{
+    telem_channel_t channels[TELEM_MAX_CHANNELS];
+    uint8_t count;
+    uint16_t rows;
+    uint16_t row;
+    telem_column_t cols[TELEM_MAX_CHANNELS];
+} telem_decoder_t;
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+//! Splits buf between the columns, channels must outlive the encoder
+int telem_encoder_init(telem_encoder_t* enc, const telem_channel_t* channels, uint8_t count, void* buf, size_t size);
+//! values holds one raw value per channel, returns 1 without side effects when the frame is full
+int telem_encoder_add(telem_encoder_t* enc, const int32_t* values);
+//! Writes the frame and starts an empty one, returns 1 when out is too small
+int telem_encoder_finish(telem_encoder_t* enc, void* out, size_t size, size_t* length);
+//! Size of the frame telem_encoder_finish() would write now
+size_t telem_encoder_frame_size(const telem_encoder_t* enc);
+
+//! The frame must stay valid while it is decoded, length receives its size to step to the next one
+int telem_decoder_init(telem_decoder_t* dec, const void* frame, size_t size, size_t* length);
+//! Returns 1 after the last row or on a corrupt column
+int telem_decoder_next(telem_decoder_t* dec, int32_t* values);
+
+float telem_to_phys(const telem_channel_t* channel, int32_t raw);
+
+#endif /* __TELEM_H__ */
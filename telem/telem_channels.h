@@ -0,0 +1,52 @@
+#ifndef __TELEM_CHANNELS_H__
+#define __TELEM_CHANNELS_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include "ds18b20.h"
+#include "ina226.h"
+#include "si7006.h"
+#include "telem.h"
+#include "tsl2591.h"
+#include "vcnl4000.h"
+#include "vcnl4010.h"
+
+/* ===== DEFINITIONS ======================================================== */
+
+/*
+ * Channel descriptions of the raw driver outputs, usable as initialisers of a
+ * telem_channel_t array. Temperatures and humidity drift slowly and are delta
+ * coded, light and proximity counts are noisy and bit-packed at their width.
+ */
+
+// raw scratchpad word, 1/16 degC at every resolution
+#define TELEM_CHANNEL_DS18B20_TEMP(ch_id) \
+    {.id = (ch_id), .encoding = TELEM_ENC_DELTA, .bits = 16, .is_signed = true, .scale = DS18B20_RAW2PHYS_12BIT(1)}
+
+#define TELEM_CHANNEL_SI7006_RH(ch_id) \
+    {.id = (ch_id), .encoding = TELEM_ENC_DELTA, .bits = 16, .scale = SI7006_RH_SCALE, .offset = SI7006_RH_OFFSET}
+#define TELEM_CHANNEL_SI7006_TEMP(ch_id) \
+    {.id = (ch_id), .encoding = TELEM_ENC_DELTA, .bits = 16, .scale = SI7006_TEMP_SCALE, .offset = SI7006_TEMP_OFFSET}
+
+#define TELEM_CHANNEL_INA226_SHUNT(ch_id) \
+    {.id = (ch_id), .encoding = TELEM_ENC_DELTA, .bits = 16, .is_signed = true, .scale = INA226_SHUNT_LSB}
+#define TELEM_CHANNEL_INA226_VBUS(ch_id) \
+    {.id = (ch_id), .encoding = TELEM_ENC_DELTA, .bits = 16, .scale = INA226_VBUS_LSB}
+
+// counts, the irradiance depends on the gain and integration time in use
+#define TELEM_CHANNEL_TSL2591_CH0(ch_id) {.id = (ch_id), .encoding = TELEM_ENC_BITPACK, .bits = 16, .scale = 1.0f}
+#define TELEM_CHANNEL_TSL2591_CH1(ch_id) {.id = (ch_id), .encoding = TELEM_ENC_BITPACK, .bits = 16, .scale = 1.0f}
+
+#define TELEM_CHANNEL_VCNL4000_PROX(ch_id) {.id = (ch_id), .encoding = TELEM_ENC_BITPACK, .bits = 16, .scale = 1.0f}
+#define TELEM_CHANNEL_VCNL4000_ALIGHT(ch_id) \
+    {.id = (ch_id), .encoding = TELEM_ENC_BITPACK, .bits = 16, .scale = VCNL4000_ALIGHT_RAW2PHYS(1.0f)}
+
+#define TELEM_CHANNEL_VCNL4010_PROX(ch_id) {.id = (ch_id), .encoding = TELEM_ENC_BITPACK, .bits = 16, .scale = 1.0f}
+#define TELEM_CHANNEL_VCNL4010_ALIGHT(ch_id) \
+    {.id = (ch_id), .encoding = TELEM_ENC_BITPACK, .bits = 16, .scale = VCNL4010_ALIGHT_RAW2PHYS(1.0f)}
+
+/* ===== TYPES ============================================================== */
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+#endif /* __TELEM_CHANNELS_H__ */
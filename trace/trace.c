@@ -0,0 +1,417 @@
+
+/* ===== INCLUDES =========================================================== */
+
+// clock_gettime() under -std=c11
+#define _POSIX_C_SOURCE 200809L
+
+#include "trace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define HEADER_SIZE     (5)
+#define VARINT_MAX_SIZE (10)
+
+#define OP_FLAGS_SHIFT (2)
+
+/* ===== TYPES ============================================================== */
+
+typedef struct
+{
+    uint8_t op;
+    uint16_t address;
+    int res;
+    size_t size;
+    const uint8_t* data;
+} trace_record_t;
+
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static uint64_t _clock_monotonic(void);
+
+static int _rec_read(const transport_t* self, void* data, size_t size, uint8_t flags);
+static int _rec_write(const transport_t* self, const void* data, size_t size, uint8_t flags);
+static int _rec_reset(const transport_t* self);
+static int _rec_transfer(const transport_t* self, const transport_seg_t* segs, size_t count);
+static void _rec_emit(trace_rec_device_t* dev, uint64_t start, uint8_t op, int res, const void* data, size_t size);
+static void _rec_put(trace_recorder_t* recorder, const void* data, size_t size);
+static size_t _put_varint(uint8_t* p, uint64_t value);
+
+static int _replay_read(const transport_t* self, void* data, size_t size, uint8_t flags);
+static int _replay_write(const transport_t* self, const void* data, size_t size, uint8_t flags);
+static int _replay_reset(const transport_t* self);
+static int _replay_next(trace_replay_t* replay, trace_record_t* record);
+static int _get_varint(trace_replay_t* replay, uint64_t* value);
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+int trace_recorder_init(trace_recorder_t* recorder, trace_write_t write, void* arg, trace_clock_t clock)
+{
+    const uint8_t header[HEADER_SIZE] = {
+        (uint8_t)TRACE_MAGIC,
+        (uint8_t)(TRACE_MAGIC >> 8),
+        (uint8_t)(TRACE_MAGIC >> 16),
+        (uint8_t)(TRACE_MAGIC >> 24),
+        TRACE_VERSION,
+    };
+
+    memset(recorder, 0, sizeof(*recorder));
+
+    recorder->write   = write;
+    recorder->arg     = arg;
+    recorder->clock   = (clock != NULL) ? clock : _clock_monotonic;
+    recorder->last_ns = recorder->clock();
+
+    _rec_put(recorder, header, sizeof(header));
+
+    return 0;
+}
+
+int trace_recorder_flush(trace_recorder_t* recorder)
+{
+    int res = 0;
+
+    if (recorder->fill != 0)
+    {
+        res = recorder->write(recorder->arg, recorder->buf, recorder->fill);
+        recorder->fill = 0;
+
+        if (res != 0)
+        {
+            recorder->write_errors++;
+        }
+    }
+
+    return res;
+}
+
+const transport_t* trace_rec_device_init(trace_rec_device_t* dev, trace_recorder_t* recorder, const transport_t* inner)
+{
+    dev->inner    = inner;
+    dev->recorder = recorder;
+
+    dev->transport = (transport_t){
+        .ctx      = dev,
+        .bus      = inner->bus,
+        .address  = inner->address,
+        .read     = _rec_read,
+        .write    = _rec_write,
+        .reset    = _rec_reset,
+        .transfer = (inner->transfer != NULL) ? _rec_transfer : NULL,
+    };
+
+    return &dev->transport;
+}
+
+int trace_file_write(void* arg, const void* data, size_t size)
+{
+    return fwrite(data, 1, size, (FILE*)arg) != size;
+}
+
+int trace_replay_init(trace_replay_t* replay, const void* data, size_t size)
+{
+    const uint8_t* p = data;
+
+    if ((size < HEADER_SIZE) ||
+        ((p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24)) != TRACE_MAGIC) ||
+        (p[4] != TRACE_VERSION))
+    {
+        return 1;
+    }
+
+    memset(replay, 0, sizeof(*replay));
+
+    replay->data = p;
+    replay->size = size;
+    replay->pos  = HEADER_SIZE;
+
+    return 0;
+}
+
+void trace_replay_rewind(trace_replay_t* replay)
+{
+    replay->pos = HEADER_SIZE;
+}
+
+bool trace_replay_done(const trace_replay_t* replay)
+{
+    return replay->pos >= replay->size;
+}
+
+void trace_replay_transport_init(transport_t* transport, trace_replay_t* replay, uint16_t address)
+{
+    *transport = (transport_t){
+        .ctx     = replay,
+        .address = address,
+        .read    = _replay_read,
+        .write   = _replay_write,
+        .reset   = _replay_reset,
+    };
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static uint64_t _clock_monotonic(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int _rec_read(const transport_t* self, void* data, size_t size, uint8_t flags)
+{
+    trace_rec_device_t* dev = self->ctx;
+    uint64_t start          = dev->recorder->clock();
+    int res                 = transport_read(dev->inner, data, size, flags);
+
+    _rec_emit(dev, start, TRACE_OP_READ | (flags << OP_FLAGS_SHIFT), res, data, (res == 0) ? size : 0);
+
+    return res;
+}
+
+static int _rec_write(const transport_t* self, const void* data, size_t size, uint8_t flags)
+{
+    trace_rec_device_t* dev = self->ctx;
+    uint64_t start          = dev->recorder->clock();
+    int res                 = transport_write(dev->inner, data, size, flags);
+
+    _rec_emit(dev, start, TRACE_OP_WRITE | (flags << OP_FLAGS_SHIFT), res, data, size);
+
+    return res;
+}
+
+static int _rec_reset(const transport_t* self)
+{
+    trace_rec_device_t* dev = self->ctx;
+    uint64_t start          = dev->recorder->clock();
+    int res                 = transport_reset(dev->inner);
+
+    _rec_emit(dev, start, TRACE_OP_RESET, res, NULL, 0);
+
+    return res;
+}
+
+/*
+ * Recorded as the read/write sequence transport_transfer() falls back to, so the
+ * replay needs no transfer of its own. A failed transfer is recorded as its first
+ * segment failing, which is where the fallback stops.
+ */
+static int _rec_transfer(const transport_t* self, const transport_seg_t* segs, size_t count)
+{
+    trace_rec_device_t* dev = self->ctx;
+    uint64_t start          = dev->recorder->clock();
+    int res                 = transport_transfer(dev->inner, segs, count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t flags = segs[i].flags;
+        bool is_read  = (flags & TRANSPORT_FLAG_READ) != 0;
+
+        if (i == count - 1)
+        {
+            flags |= TRANSPORT_FLAG_LAST;
+        }
+        flags &= ~TRANSPORT_FLAG_READ;
+
+        _rec_emit(dev,
+                  start,
+                  (is_read ? TRACE_OP_READ : TRACE_OP_WRITE) | (flags << OP_FLAGS_SHIFT),
+                  res,
+                  segs[i].data,
+                  (is_read && (res != 0)) ? 0 : segs[i].size);
+
+        if (res != 0)
+        {
+            break;
+        }
+    }
+
+    return res;
+}
+
+static void _rec_emit(trace_rec_device_t* dev, uint64_t start, uint8_t op, int res, const void* data, size_t size)
+{
+    trace_recorder_t* recorder = dev->recorder;
+    uint8_t head[1 + 4 * VARINT_MAX_SIZE];
+    size_t len = 0;
+    uint64_t delta = (start > recorder->last_ns) ? (start - recorder->last_ns) : 0;
+
+    head[len++] = op;
+    len += _put_varint(&head[len], dev->inner->address);
+    len += _put_varint(&head[len], delta);
+    len += _put_varint(&head[len], ((uint64_t)(int64_t)res << 1) ^ (uint64_t)((int64_t)res >> 63));
+    len += _put_varint(&head[len], size);
+
+    _rec_put(recorder, head, len);
+    _rec_put(recorder, data, size);
+
+    recorder->last_ns = start;
+    recorder->records++;
+}
+
+static void _rec_put(trace_recorder_t* recorder, const void* data, size_t size)
+{
+    if (recorder->fill + size > TRACE_BUF_SIZE)
+    {
+        trace_recorder_flush(recorder);
+    }
+
+    if (size > TRACE_BUF_SIZE)
+    {
+        if (recorder->write(recorder->arg, data, size) != 0)
+        {
+            recorder->write_errors++;
+        }
+        return;
+    }
+
+    memcpy(&recorder->buf[recorder->fill], data, size);
+    recorder->fill += size;
+}
+
+static size_t _put_varint(uint8_t* p, uint64_t value)
+{
+    size_t len = 0;
+
+    while (value >= 0x80)
+    {
+        p[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+
+    p[len++] = (uint8_t)value;
+
+    return len;
+}
+
+static int _replay_read(const transport_t* self, void* data, size_t size, uint8_t flags)
+{
+    trace_replay_t* replay = self->ctx;
+    trace_record_t record;
+    int res;
+
+    res = _replay_next(replay, &record);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    if ((record.op != (TRACE_OP_READ | (flags << OP_FLAGS_SHIFT))) || (record.address != self->address) ||
+        ((record.res == 0) && (record.size != size)))
+    {
+        replay->mismatches++;
+        return TRACE_ERR_MISMATCH;
+    }
+
+    memcpy(data, record.data, record.size);
+
+    return record.res;
+}
+
+static int _replay_write(const transport_t* self, const void* data, size_t size, uint8_t flags)
+{
+    trace_replay_t* replay = self->ctx;
+    trace_record_t record;
+    int res;
+
+    res = _replay_next(replay, &record);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    if ((record.op != (TRACE_OP_WRITE | (flags << OP_FLAGS_SHIFT))) || (record.address != self->address) ||
+        (record.size != size) || (memcmp(record.data, data, size) != 0))
+    {
+        replay->mismatches++;
+        return TRACE_ERR_MISMATCH;
+    }
+
+    return record.res;
+}
+
+static int _replay_reset(const transport_t* self)
+{
+    trace_replay_t* replay = self->ctx;
+    trace_record_t record;
+    int res;
+
+    res = _replay_next(replay, &record);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    if ((record.op != TRACE_OP_RESET) || (record.address != self->address))
+    {
+        replay->mismatches++;
+        return TRACE_ERR_MISMATCH;
+    }
+
+    return record.res;
+}
+
+static int _replay_next(trace_replay_t* replay, trace_record_t* record)
+{
+    uint64_t address;
+    uint64_t delta;
+    uint64_t res;
+    uint64_t size;
+
+    if (replay->pos >= replay->size)
+    {
+        return TRACE_ERR_END;
+    }
+
+    record->op = replay->data[replay->pos++];
+
+    if ((_get_varint(replay, &address) != 0) || (_get_varint(replay, &delta) != 0) ||
+        (_get_varint(replay, &res) != 0) || (_get_varint(replay, &size) != 0) ||
+        (size > replay->size - replay->pos))
+    {
+        replay->pos = replay->size;
+        return TRACE_ERR_END;
+    }
+
+    record->address = (uint16_t)address;
+    record->res     = (int)(int64_t)((res >> 1) ^ (0u - (res & 1)));
+    record->size    = (size_t)size;
+    record->data    = &replay->data[replay->pos];
+
+    replay->pos += record->size;
+    replay->now_ns += delta;
+    replay->records++;
+
+    return 0;
+}
+
+static int _get_varint(trace_replay_t* replay, uint64_t* value)
+{
+    uint64_t result = 0;
+
+    for (uint8_t shift = 0; shift < 64; shift += 7)
+    {
+        if (replay->pos >= replay->size)
+        {
+            return 1;
+        }
+
+        uint8_t byte = replay->data[replay->pos++];
+
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            *value = result;
+            return 0;
+        }
+    }
+
+    return 1;
+}
@@ -0,0 +1,104 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "transport.h"
+
+/* ===== DEFINITIONS ======================================================== */
+
+#define TRACE_MAGIC   (0x43525442) // "BTRC"
+#define TRACE_VERSION (1)
+
+#define TRACE_BUF_SIZE (512)
+
+#define TRACE_ERR_MISMATCH (-1) //! the driver issued a transfer that differs from the recorded one
+#define TRACE_ERR_END      (-2) //! the trace is exhausted
+
+/* ===== TYPES ============================================================== */
+
+typedef enum
+{
+    TRACE_OP_WRITE,
+    TRACE_OP_READ,
+    TRACE_OP_RESET,
+} trace_op_t;
+
+typedef uint64_t (*trace_clock_t)(void);
+typedef int (*trace_write_t)(void* arg, const void* data, size_t size);
+
+/*
+ * Trace layout: magic u32 and version u8 (little-endian), then one record per
+ * transfer:
+ *   op u8          trace_op_t in bits 0-1, transport flags from bit 2
+ *   address        varint
+ *   time           varint, nanoseconds since the previous record started
+ *   result         zig-zag varint
+ *   size           varint, followed by the bytes read or written
+ * Records are buffered and handed to write in chunks. A recorder is shared by
+ * every device it wraps and is not thread-safe, serialise the devices with
+ * busmgr when they run from several threads.
+ */
+typedef struct
+{
+    trace_write_t write;
+    void* arg;
+    trace_clock_t clock;
+    uint64_t last_ns;
+    uint8_t buf[TRACE_BUF_SIZE];
+    size_t fill;
+
+    uint64_t records;
+    uint32_t write_errors;
+} trace_recorder_t;
+
+typedef struct
+{
+    transport_t transport;
+    const transport_t* inner;
+    trace_recorder_t* recorder;
+} trace_rec_device_t;
+
+/*
+ * Replay of a trace held in memory. Reads are served from the trace and writes
+ * are compared with it, both return the recorded result. now_ns follows the
+ * recorded timing and can drive the application clock.
+ */
+typedef struct
+{
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+    uint64_t now_ns;
+
+    uint64_t records;
+    uint64_t mismatches;
+} trace_replay_t;
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+//! CLOCK_MONOTONIC is used when clock is NULL
+int trace_recorder_init(trace_recorder_t* recorder, trace_write_t write, void* arg, trace_clock_t clock);
+int trace_recorder_flush(trace_recorder_t* recorder);
+
+//! Returns the transport to hand to the driver, every transfer on it is recorded
+const transport_t* trace_rec_device_init(trace_rec_device_t* dev, trace_recorder_t* recorder, const transport_t* inner);
+
+//! write callback for a FILE* opened in binary mode
+int trace_file_write(void* arg, const void* data, size_t size);
+
+//! Returns 1 when data does not start with a trace header
+int trace_replay_init(trace_replay_t* replay, const void* data, size_t size);
+//! Restarts from the first record, e.g. to loop a recording in a benchmark
+void trace_replay_rewind(trace_replay_t* replay);
+bool trace_replay_done(const trace_replay_t* replay);
+
+//! Transport replaying the records of one device, the drivers have to run in the recorded order
+void trace_replay_transport_init(transport_t* transport, trace_replay_t* replay, uint16_t address);
+
+#endif /* __TRACE_H__ */
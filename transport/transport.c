@@ -0,0 +1,107 @@
+
+/* ===== INCLUDES =========================================================== */
+
+#include "transport.h"
+
+/* ===== DEFINITIONS ======================================================== */
+/* ===== TYPES ============================================================== */
+/* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== LOCAL VARIABLES ==================================================== */
+/* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
+
+int transport_read(const transport_t* self, void* data, size_t size, uint8_t flags)
+{
+    return self->read(self, data, size, flags);
+}
+
+int transport_write(const transport_t* self, const void* data, size_t size, uint8_t flags)
+{
+    return self->write(self, data, size, flags);
+}
+
+int transport_reset(const transport_t* self)
+{
+    return (self->reset != NULL) ? self->reset(self) : 0;
+}
+
+int transport_transfer(const transport_t* self, const transport_seg_t* segs, size_t count)
+{
+    int res = 0;
+
+    if (self->transfer != NULL)
+    {
+        return self->transfer(self, segs, count);
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t flags = segs[i].flags;
+
+        if (i == count - 1)
+        {
+            flags |= TRANSPORT_FLAG_LAST;
+        }
+
+        if (flags & TRANSPORT_FLAG_READ)
+        {
+            res = self->read(self, segs[i].data, segs[i].size, flags & ~TRANSPORT_FLAG_READ);
+        }
+        else
+        {
+            res = self->write(self, segs[i].data, segs[i].size, flags);
+        }
+
+        if (res != 0)
+        {
+            return res;
+        }
+    }
+
+    return res;
+}
+
+int transport_submit(const transport_t* self,
+                     const transport_seg_t* segs,
+                     size_t count,
+                     transport_done_t done,
+                     void* arg)
+{
+    int res;
+
+    if (self->submit != NULL)
+    {
+        return self->submit(self, segs, count, done, arg);
+    }
+
+    res = transport_transfer(self, segs, count);
+
+    if (done != NULL)
+    {
+        done(arg, res);
+    }
+
+    return 0;
+}
+
+int transport_reg_read(const transport_t* self, uint8_t reg, void* data, size_t size)
+{
+    transport_seg_t segs[] = {
+        {.data = &reg, .size = 1, .flags = 0},
+        {.data = data, .size = size, .flags = TRANSPORT_FLAG_READ | TRANSPORT_FLAG_LAST},
+    };
+
+    return transport_transfer(self, segs, 2);
+}
+
+int transport_reg_write(const transport_t* self, uint8_t reg, const void* data, size_t size)
+{
+    transport_seg_t segs[] = {
+        {.data = &reg, .size = 1, .flags = (size != 0) ? 0 : TRANSPORT_FLAG_LAST},
+        {.data = (void*)data, .size = size, .flags = TRANSPORT_FLAG_LAST},
+    };
+
+    return transport_transfer(self, segs, (size != 0) ? 2 : 1);
+}
+
+/* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
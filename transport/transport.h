@@ -0,0 +1,79 @@
+#ifndef __TRANSPORT_H__
+#define __TRANSPORT_H__
+
+/* ===== INCLUDES =========================================================== */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ===== DEFINITIONS ======================================================== */
+
+/*
+ * Transfer flags. Without TRANSPORT_FLAG_LAST the bus is kept: a write followed by
+ * a write continues the same I2C message, a change of direction issues a repeated
+ * START. TRANSPORT_FLAG_LAST ends the transaction with a STOP.
+ */
+#define TRANSPORT_FLAG_LAST   (1 << 0)
+#define TRANSPORT_FLAG_STRONG (1 << 1) //! 1-Wire strong pull-up after the transfer
+#define TRANSPORT_FLAG_READ   (1 << 2) //! segment direction, write if not set
+
+/* ===== TYPES ============================================================== */
+
+typedef struct
+{
+    void* data;
+    size_t size;
+    uint8_t flags;
+} transport_seg_t;
+
+typedef struct transport transport_t;
+
+typedef int (*transport_read_t)(const transport_t* self, void* data, size_t size, uint8_t flags);
+typedef int (*transport_write_t)(const transport_t* self, const void* data, size_t size, uint8_t flags);
+typedef int (*transport_reset_t)(const transport_t* self);
+typedef int (*transport_transfer_t)(const transport_t* self, const transport_seg_t* segs, size_t count);
+typedef void (*transport_done_t)(void* arg, int res);
+typedef int (*transport_submit_t)(const transport_t* self,
+                                  const transport_seg_t* segs,
+                                  size_t count,
+                                  transport_done_t done,
+                                  void* arg);
+
+/*
+ * Device transport. One backend function set serves any number of devices and
+ * buses, the instance carries everything the backend needs to address a device.
+ */
+struct transport
+{
+    void* ctx;        //! backend private data
+    void* bus;        //! bus handle
+    uint16_t address; //! 7-bit I2C address, unused on 1-Wire
+
+    transport_read_t read;
+    transport_write_t write;
+    transport_reset_t reset;       //! optional, 1-Wire reset and presence detect
+    transport_transfer_t transfer; //! optional, whole transaction as a segment list
+    transport_submit_t submit;     //! optional, asynchronous transfer
+};
+
+/* ===== GLOBALS AND EXTERNS ================================================ */
+/* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
+
+int transport_read(const transport_t* self, void* data, size_t size, uint8_t flags);
+int transport_write(const transport_t* self, const void* data, size_t size, uint8_t flags);
+int transport_reset(const transport_t* self);
+
+//! Falls back to a sequence of read/write calls when the backend has no transfer
+int transport_transfer(const transport_t* self, const transport_seg_t* segs, size_t count);
+//! Falls back to a synchronous transfer followed by the completion callback
+int transport_submit(const transport_t* self,
+                     const transport_seg_t* segs,
+                     size_t count,
+                     transport_done_t done,
+                     void* arg);
+
+int transport_reg_read(const transport_t* self, uint8_t reg, void* data, size_t size);
+int transport_reg_write(const transport_t* self, uint8_t reg, const void* data, size_t size);
+
+#endif /* __TRANSPORT_H__ */
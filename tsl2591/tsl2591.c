@@ -3,8 +3,14 @@
 
 #include "tsl2591.h"
 
+#include "instr.h"
+
 /* ===== DEFINITIONS ======================================================== */
 
+// transport calls are accounted to the calling function when built with DRIVERS_INSTR
+#define _read(self, reg, data, size)  INSTR_IO(_io_read(self, reg, data, size), size, 1, true)
+#define _write(self, reg, data, size) INSTR_IO(_io_write(self, reg, data, size), 0, 1 + (size), true)
+
 #define IS_BIG_ENDIAN   \
     (!(union {          \
           uint16_t u16; \
@@ -21,125 +27,576 @@
 
 #define FROM_LE16(val) (IS_LITTLE_ENDIAN ? (val) : (((uint16_t)(val) >> 8) | ((uint16_t)(val) << 8)))
 
+// The 3 bit field also holds the reserved values 6 and 7, they are taken as 600 ms
+#define INTEGR_TIME(itime) \
+    (((itime) > TSL2591_REG_CONFIG_INTEGR_TIME_600ms) ? TSL2591_REG_CONFIG_INTEGR_TIME_600ms : (itime))
+
+#define INTEGR_TIME_MS(itime) (((uint16_t)INTEGR_TIME(itime) + 1) * 100)
+
+#define LUX_COEF_Q24(again, atime_ms) \
+    ((uint32_t)(TSL2591_LUX_DF * 10.0f / ((again) * (atime_ms)) * 16777216.0f + 0.5f))
+
+#define LUX_COEF_Q24_ROW(again)     \
+    {                               \
+        LUX_COEF_Q24(again, 100.0f), \
+        LUX_COEF_Q24(again, 200.0f), \
+        LUX_COEF_Q24(again, 300.0f), \
+        LUX_COEF_Q24(again, 400.0f), \
+        LUX_COEF_Q24(again, 500.0f), \
+        LUX_COEF_Q24(again, 600.0f), \
+    }
+
 /* ===== TYPES ============================================================== */
 /* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static int _io_read(tsl2591_driver_t* self, uint8_t reg, void* data, uint8_t size);
+static int _io_write(tsl2591_driver_t* self, uint8_t reg, const void* data, uint8_t size);
+
+static uint32_t _sensitivity(uint8_t gain, uint8_t integr_time);
+static int _event_rearm(tsl2591_driver_t* self, tsl2591_event_t* event, uint16_t level);
 /* ===== GLOBALS AND EXTERNS ================================================ */
 /* ===== LOCAL VARIABLES ==================================================== */
+
+static const float _gain_ch0[] = {
+    [TSL2591_REG_CONFIG_GAIN_LOW]    = TSL2591_CHANNEL0_GAIN_LOW,
+    [TSL2591_REG_CONFIG_GAIN_MEDIUM] = TSL2591_CHANNEL0_GAIN_MEDIUM,
+    [TSL2591_REG_CONFIG_GAIN_HIGH]   = TSL2591_CHANNEL0_GAIN_HIGH,
+    [TSL2591_REG_CONFIG_GAIN_MAX]    = TSL2591_CHANNEL0_GAIN_MAX,
+};
+
+//! Channel 0 gain doubled so that the medium gain is an integer
+static const uint16_t _gain_x2[] = {
+    [TSL2591_REG_CONFIG_GAIN_LOW]    = (uint16_t)(TSL2591_CHANNEL0_GAIN_LOW * 2.0f),
+    [TSL2591_REG_CONFIG_GAIN_MEDIUM] = (uint16_t)(TSL2591_CHANNEL0_GAIN_MEDIUM * 2.0f),
+    [TSL2591_REG_CONFIG_GAIN_HIGH]   = (uint16_t)(TSL2591_CHANNEL0_GAIN_HIGH * 2.0f),
+    [TSL2591_REG_CONFIG_GAIN_MAX]    = (uint16_t)(TSL2591_CHANNEL0_GAIN_MAX * 2.0f),
+};
+
+//! millilux per hundredth of a count, Q24, indexed by [gain][integr_time]
+static const uint32_t _lux_coef_q24[4][6] = {
+    [TSL2591_REG_CONFIG_GAIN_LOW]    = LUX_COEF_Q24_ROW(TSL2591_CHANNEL0_GAIN_LOW),
+    [TSL2591_REG_CONFIG_GAIN_MEDIUM] = LUX_COEF_Q24_ROW(TSL2591_CHANNEL0_GAIN_MEDIUM),
+    [TSL2591_REG_CONFIG_GAIN_HIGH]   = LUX_COEF_Q24_ROW(TSL2591_CHANNEL0_GAIN_HIGH),
+    [TSL2591_REG_CONFIG_GAIN_MAX]    = LUX_COEF_Q24_ROW(TSL2591_CHANNEL0_GAIN_MAX),
+};
+
 /* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
 
+int tsl2591_read_regs(tsl2591_driver_t* self, tsl2591_reg_t reg, void* data, uint8_t size)
+{
+    return _read(self, reg, data, size);
+}
+
+int tsl2591_write_regs(tsl2591_driver_t* self, tsl2591_reg_t reg, const void* data, uint8_t size)
+{
+    return _write(self, reg, data, size);
+}
+
+int tsl2591_update_reg(tsl2591_driver_t* self, tsl2591_reg_t reg, uint8_t mask, uint8_t value)
+{
+    uint8_t raw;
+    int res;
+
+    res = _read(self, reg, &raw, 1);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    raw = REGMAP_UPDATE(raw, mask, value);
+
+    return _write(self, reg, &raw, 1);
+}
+
 int tsl2591_read_enable(tsl2591_driver_t* self, tsl2591_reg_enable_t* value)
 {
-    return self->read(TSL2591_REG_ENABLE, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, TSL2591_REG_ENABLE, &raw, 1);
+    *value = (tsl2591_reg_enable_t){
+        .power_on        = REGMAP_GET(raw, TSL2591_ENABLE_PON),
+        .als             = REGMAP_GET(raw, TSL2591_ENABLE_AEN),
+        .interrupt       = REGMAP_GET(raw, TSL2591_ENABLE_AIEN),
+        .sleep_after_int = REGMAP_GET(raw, TSL2591_ENABLE_SAI),
+        .no_persist_int  = REGMAP_GET(raw, TSL2591_ENABLE_NPIEN),
+    };
+
+    return res;
 }
 int tsl2591_write_enable(tsl2591_driver_t* self, tsl2591_reg_enable_t value)
 {
-    return self->write(TSL2591_REG_ENABLE, &value, 1);
+    uint8_t raw = REGMAP_VAL(TSL2591_ENABLE_PON, value.power_on) | REGMAP_VAL(TSL2591_ENABLE_AEN, value.als) |
+                  REGMAP_VAL(TSL2591_ENABLE_AIEN, value.interrupt) |
+                  REGMAP_VAL(TSL2591_ENABLE_SAI, value.sleep_after_int) |
+                  REGMAP_VAL(TSL2591_ENABLE_NPIEN, value.no_persist_int);
+
+    return _write(self, TSL2591_REG_ENABLE, &raw, 1);
 }
 
 int tsl2591_read_config(tsl2591_driver_t* self, tsl2591_reg_config_t* value)
 {
-    return self->read(TSL2591_REG_CONFIG, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, TSL2591_REG_CONFIG, &raw, 1);
+    *value = (tsl2591_reg_config_t){
+        .integr_time = REGMAP_GET(raw, TSL2591_CONFIG_ATIME),
+        .gain        = REGMAP_GET(raw, TSL2591_CONFIG_AGAIN),
+        .sw_reset    = REGMAP_GET(raw, TSL2591_CONFIG_SRESET),
+    };
+
+    return res;
 }
 int tsl2591_write_config(tsl2591_driver_t* self, tsl2591_reg_config_t value)
 {
-    return self->write(TSL2591_REG_CONFIG, &value, 1);
+    uint8_t raw = REGMAP_VAL(TSL2591_CONFIG_ATIME, value.integr_time) | REGMAP_VAL(TSL2591_CONFIG_AGAIN, value.gain) |
+                  REGMAP_VAL(TSL2591_CONFIG_SRESET, value.sw_reset);
+
+    return _write(self, TSL2591_REG_CONFIG, &raw, 1);
 }
 
 int tsl2591_read_int_low_threashold(tsl2591_driver_t* self, uint16_t* value)
 {
     int res;
-    res    = self->read(TSL2591_REG_INT_LOW_THRESHOLD_L, value, 2);
+    res    = _read(self, TSL2591_REG_INT_LOW_THRESHOLD_L, value, 2);
     *value = FROM_LE16(*value);
-    return res
+    return res;
 }
 int tsl2591_write_int_low_threashold(tsl2591_driver_t* self, uint16_t value)
 {
     int res;
     value = FROM_LE16(value);
-    res   = self->write(TSL2591_REG_INT_LOW_THRESHOLD_L, &value, 2);
-    return res
+    res   = _write(self, TSL2591_REG_INT_LOW_THRESHOLD_L, &value, 2);
+    return res;
 }
 int tsl2591_read_int_high_threashold(tsl2591_driver_t* self, uint16_t* value)
 {
     int res;
-    res    = self->read(TSL2591_REG_INT_HIGH_THRESHOLD_L, value, 2);
+    res    = _read(self, TSL2591_REG_INT_HIGH_THRESHOLD_L, value, 2);
     *value = FROM_LE16(*value);
-    return res
+    return res;
 }
 int tsl2591_write_int_high_threashold(tsl2591_driver_t* self, uint16_t value)
 {
     int res;
     value = FROM_LE16(value);
-    res   = self->write(TSL2591_REG_INT_HIGH_THRESHOLD_L, &value, 2);
-    return res
+    res   = _write(self, TSL2591_REG_INT_HIGH_THRESHOLD_L, &value, 2);
+    return res;
 }
 
 int tsl2591_read_np_int_low_threashold(tsl2591_driver_t* self, uint16_t* value)
 {
     int res;
-    res    = self->read(TSL2591_REG_NP_INT_LOW_THRESHOLD_L, value, 2);
+    res    = _read(self, TSL2591_REG_NP_INT_LOW_THRESHOLD_L, value, 2);
     *value = FROM_LE16(*value);
-    return res
+    return res;
 }
 int tsl2591_write_np_int_low_threashold(tsl2591_driver_t* self, uint16_t value)
 {
     int res;
     value = FROM_LE16(value);
-    res   = self->write(TSL2591_REG_NP_INT_LOW_THRESHOLD_L, &value, 2);
-    return res
+    res   = _write(self, TSL2591_REG_NP_INT_LOW_THRESHOLD_L, &value, 2);
+    return res;
 }
 int tsl2591_read_np_int_high_threashold(tsl2591_driver_t* self, uint16_t* value)
 {
     int res;
-    res    = self->read(TSL2591_REG_NP_INT_HIGH_THRESHOLD_L, value, 2);
+    res    = _read(self, TSL2591_REG_NP_INT_HIGH_THRESHOLD_L, value, 2);
     *value = FROM_LE16(*value);
-    return res
+    return res;
 }
 int tsl2591_write_np_int_high_threashold(tsl2591_driver_t* self, uint16_t value)
 {
     int res;
     value = FROM_LE16(value);
-    res   = self->write(TSL2591_REG_NP_INT_HIGH_THRESHOLD_L, &value, 2);
-    return res
+    res   = _write(self, TSL2591_REG_NP_INT_HIGH_THRESHOLD_L, &value, 2);
+    return res;
+}
+
+int tsl2591_write_int_threasholds(tsl2591_driver_t* self, uint16_t low, uint16_t high)
+{
+    uint8_t data[] = {
+        (uint8_t)low,
+        (uint8_t)(low >> 8),
+        (uint8_t)high,
+        (uint8_t)(high >> 8),
+    };
+
+    return _write(self, TSL2591_REG_INT_LOW_THRESHOLD_L, data, sizeof(data));
 }
 
 int tsl2591_read_int_pers_filter(tsl2591_driver_t* self, tsl2591_reg_int_pers_filter_t* value)
 {
-    return self->read(TSL2591_REG_INT_PERS_FILTER, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, TSL2591_REG_INT_PERS_FILTER, &raw, 1);
+    *value = (tsl2591_reg_int_pers_filter_t)REGMAP_GET(raw, TSL2591_PERSIST_APERS);
+
+    return res;
 }
 int tsl2591_write_int_pers_filter(tsl2591_driver_t* self, tsl2591_reg_int_pers_filter_t value)
 {
-    return self->write(TSL2591_REG_INT_PERS_FILTER, &value, 1);
+    uint8_t raw = REGMAP_VAL(TSL2591_PERSIST_APERS, value);
+
+    return _write(self, TSL2591_REG_INT_PERS_FILTER, &raw, 1);
 }
 
 int tsl2591_read_package_id(tsl2591_driver_t* self, tsl2591_reg_package_id_t* value)
 {
-    return self->read(TSL2591_REG_PACKAGE_ID, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, TSL2591_REG_PACKAGE_ID, &raw, 1);
+    *value = (tsl2591_reg_package_id_t){.id = REGMAP_GET(raw, TSL2591_PACKAGE_PID)};
+
+    return res;
 }
 
 int tsl2591_read_device_id(tsl2591_driver_t* self, uint8_t* value)
 {
-    return self->read(TSL2591_REG_DEVICE_ID, value, 1);
+    return _read(self, TSL2591_REG_DEVICE_ID, value, 1);
 }
 
 int tsl2591_read_status(tsl2591_driver_t* self, tsl2591_reg_status_t* value)
 {
-    return self->read(TSL2591_REG_STATUS, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, TSL2591_REG_STATUS, &raw, 1);
+    *value = tsl2591_status_from_raw(raw);
+
+    return res;
+}
+
+tsl2591_reg_status_t tsl2591_status_from_raw(uint8_t raw)
+{
+    return (tsl2591_reg_status_t){
+        .valid        = REGMAP_GET(raw, TSL2591_STATUS_AVALID),
+        .interrupt    = REGMAP_GET(raw, TSL2591_STATUS_AINT),
+        .np_interrupt = REGMAP_GET(raw, TSL2591_STATUS_NPINTR),
+    };
+}
+
+int tsl2591_write_cmd(tsl2591_driver_t* self, tsl2591_cmd_t cmd)
+{
+    return _write(self, cmd, NULL, 0);
 }
 
 int tsl2591_read_channel0(tsl2591_driver_t* self, uint16_t* value)
 {
     int res;
-    res    = self->read(TSL2591_REG_CHANNEL0_DATA_L, value, 2);
+    res    = _read(self, TSL2591_REG_CHANNEL0_DATA_L, value, 2);
     *value = FROM_LE16(*value);
-    return res
+    return res;
 }
 int tsl2591_read_channel1(tsl2591_driver_t* self, uint16_t* value)
 {
     int res;
-    res    = self->read(TSL2591_REG_CHANNEL1_DATA_L, value, 2);
+    res    = _read(self, TSL2591_REG_CHANNEL1_DATA_L, value, 2);
     *value = FROM_LE16(*value);
-    return res
+    return res;
+}
+
+int tsl2591_read_sample(tsl2591_driver_t* self, tsl2591_sample_t* value)
+{
+    uint8_t data[TSL2591_REG_CHANNEL1_DATA_H - TSL2591_REG_STATUS + 1];
+    int res;
+
+    res = _read(self, TSL2591_REG_STATUS, data, sizeof(data));
+    if (res != 0)
+    {
+        return res;
+    }
+
+    value->status = tsl2591_status_from_raw(data[0]);
+    value->ch0 = (uint16_t)data[1] | ((uint16_t)data[2] << 8);
+    value->ch1 = (uint16_t)data[3] | ((uint16_t)data[4] << 8);
+
+    return value->status.valid ? 0 : 1;
+}
+
+uint16_t tsl2591_calc_integr_time_ms(tsl2591_reg_config_t config)
+{
+    return INTEGR_TIME_MS(config.integr_time);
+}
+
+uint16_t tsl2591_calc_max_count(tsl2591_reg_config_t config)
+{
+    return (config.integr_time == TSL2591_REG_CONFIG_INTEGR_TIME_100ms) ? TSL2591_MAX_COUNT_100MS : TSL2591_MAX_COUNT;
+}
+
+bool tsl2591_is_saturated(tsl2591_reg_config_t config, uint16_t ch0, uint16_t ch1)
+{
+    uint16_t max_count = tsl2591_calc_max_count(config);
+    return (ch0 >= max_count) || (ch1 >= max_count);
+}
+
+float tsl2591_calc_lux(tsl2591_reg_config_t config, uint16_t ch0, uint16_t ch1)
+{
+    if (tsl2591_is_saturated(config, ch0, ch1))
+    {
+        return TSL2591_LUX_OVERFLOW;
+    }
+
+    float cpl  = (float)INTEGR_TIME_MS(config.integr_time) * _gain_ch0[config.gain] / TSL2591_LUX_DF;
+    float lux1 = ((float)ch0 - TSL2591_LUX_COEF_B * (float)ch1) / cpl;
+    float lux2 = (TSL2591_LUX_COEF_C * (float)ch0 - TSL2591_LUX_COEF_D * (float)ch1) / cpl;
+    float lux  = (lux1 > lux2) ? lux1 : lux2;
+
+    return (lux > 0.0f) ? lux : 0.0f;
+}
+
+uint32_t tsl2591_calc_lux_mlx(tsl2591_reg_config_t config, uint16_t ch0, uint16_t ch1)
+{
+    if (tsl2591_is_saturated(config, ch0, ch1))
+    {
+        return TSL2591_LUX_OVERFLOW_MLX;
+    }
+
+    // Coefficients B, C and D scaled by 100 are exact integers
+    int32_t n1 = 100 * (int32_t)ch0 - 164 * (int32_t)ch1;
+    int32_t n2 = 59 * (int32_t)ch0 - 86 * (int32_t)ch1;
+    int32_t n  = (n1 > n2) ? n1 : n2;
+
+    if (n <= 0)
+    {
+        return 0;
+    }
+
+    return (uint32_t)(((uint64_t)n * _lux_coef_q24[config.gain][INTEGR_TIME(config.integr_time)]) >> 24);
+}
+
+void tsl2591_calc_lux_batch(tsl2591_reg_config_t config,
+                            const uint16_t* restrict ch0,
+                            const uint16_t* restrict ch1,
+                            float* restrict lux,
+                            size_t count)
+{
+    // Loop body is branch free so that the compiler can vectorise it
+    const float max_count = (float)tsl2591_calc_max_count(config);
+    const float inv_cpl   = TSL2591_LUX_DF / ((float)INTEGR_TIME_MS(config.integr_time) * _gain_ch0[config.gain]);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        float c0   = (float)ch0[i];
+        float c1   = (float)ch1[i];
+        float lux1 = (c0 - TSL2591_LUX_COEF_B * c1) * inv_cpl;
+        float lux2 = (TSL2591_LUX_COEF_C * c0 - TSL2591_LUX_COEF_D * c1) * inv_cpl;
+        float l    = (lux1 > lux2) ? lux1 : lux2;
+
+        l      = (l > 0.0f) ? l : 0.0f;
+        lux[i] = ((c0 >= max_count) || (c1 >= max_count)) ? TSL2591_LUX_OVERFLOW : l;
+    }
+}
+
+float tsl2591_calc_irradiance(tsl2591_reg_config_t config, uint16_t ch0)
+{
+    return (float)ch0 * TSL2591_CHANNEL0_RESOLUTION_WHITE_WM2 * 100.0f
+           / ((float)INTEGR_TIME_MS(config.integr_time) * _gain_ch0[config.gain]);
+}
+
+void tsl2591_autorange_init(tsl2591_autorange_t* range,
+                            tsl2591_reg_config_t config,
+                            tsl2591_reg_config_integr_time_t max_integr_time)
+{
+    range->config          = config;
+    range->config.sw_reset = 0;
+    range->max_integr_time = INTEGR_TIME(max_integr_time);
+    range->low_pct         = TSL2591_AUTORANGE_LOW_PCT;
+    range->high_pct        = TSL2591_AUTORANGE_HIGH_PCT;
+    range->target_pct      = TSL2591_AUTORANGE_TARGET_PCT;
+}
+
+int tsl2591_autorange_update(tsl2591_driver_t* self,
+                             tsl2591_autorange_t* range,
+                             const tsl2591_sample_t* sample,
+                             bool* changed)
+{
+    tsl2591_reg_config_t next = range->config;
+    uint32_t peak             = (sample->ch0 > sample->ch1) ? sample->ch0 : sample->ch1;
+    uint32_t full             = tsl2591_calc_max_count(range->config);
+
+    *changed = false;
+
+    if (tsl2591_is_saturated(range->config, sample->ch0, sample->ch1))
+    {
+        // Real level is unknown, the least sensitive setting gives a usable sample soonest
+        next.gain        = TSL2591_REG_CONFIG_GAIN_LOW;
+        next.integr_time = TSL2591_REG_CONFIG_INTEGR_TIME_100ms;
+    }
+    else if ((peak * 100 < range->low_pct * full) || (peak * 100 > range->high_pct * full))
+    {
+        uint32_t cur_sens  = _sensitivity(range->config.gain, range->config.integr_time);
+        uint32_t best_sens = 0;
+
+        next.gain        = TSL2591_REG_CONFIG_GAIN_LOW;
+        next.integr_time = TSL2591_REG_CONFIG_INTEGR_TIME_100ms;
+
+        for (uint8_t gain = TSL2591_REG_CONFIG_GAIN_LOW; gain <= TSL2591_REG_CONFIG_GAIN_MAX; gain++)
+        {
+            for (uint8_t itime = 0; itime <= range->max_integr_time; itime++)
+            {
+                tsl2591_reg_config_t cand = {.integr_time = itime, .gain = gain};
+                uint32_t sens             = _sensitivity(gain, itime);
+                uint64_t predicted        = (uint64_t)peak * sens / cur_sens;
+                uint64_t target           = (uint64_t)range->target_pct * tsl2591_calc_max_count(cand) / 100;
+
+                if ((predicted <= target) && (sens > best_sens))
+                {
+                    best_sens        = sens;
+                    next.gain        = gain;
+                    next.integr_time = itime;
+                }
+            }
+        }
+    }
+
+    if ((next.gain == range->config.gain) && (next.integr_time == range->config.integr_time))
+    {
+        return 0;
+    }
+
+    int res = tsl2591_write_config(self, next);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    range->config = next;
+    *changed      = true;
+
+    return res;
+}
+
+int tsl2591_event_start(tsl2591_driver_t* self,
+                        tsl2591_event_t* event,
+                        tsl2591_reg_config_t config,
+                        tsl2591_reg_int_pers_filter_t filter,
+                        uint32_t now_ms,
+                        tsl2591_sample_t* sample)
+{
+    int res;
+
+    event->window_pct     = TSL2591_EVENT_WINDOW_PCT;
+    event->window_min     = TSL2591_EVENT_WINDOW_MIN;
+    event->integr_time_ms = INTEGR_TIME_MS(config.integr_time);
+    event->last_ms        = now_ms;
+    event->cycles         = 0;
+    event->transactions   = 0;
+
+    res = tsl2591_write_int_pers_filter(self, filter);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    *sample = (tsl2591_sample_t){0};
+    res     = tsl2591_read_sample(self, sample);
+    if (res == 0)
+    {
+        res = INSTR_SCOPE(_event_rearm(self, event, sample->ch0));
+    }
+    else if (res == 1)
+    {
+        // not integrating yet: an inverted window makes the first valid sample raise INT
+        res = tsl2591_write_int_threasholds(self, UINT16_MAX, 0);
+        event->transactions++;
+    }
+    if (res != 0)
+    {
+        return res;
+    }
+
+    res = tsl2591_write_enable(self, (tsl2591_reg_enable_t){.power_on = 1, .als = 1, .interrupt = 1});
+    event->transactions += 3;
+
+    return res;
+}
+
+int tsl2591_event_irq(tsl2591_driver_t* self, tsl2591_event_t* event, uint32_t now_ms, tsl2591_sample_t* sample)
+{
+    int res;
+
+    event->cycles += (now_ms - event->last_ms) / event->integr_time_ms;
+    event->last_ms = now_ms;
+
+    res = tsl2591_read_sample(self, sample);
+    event->transactions++;
+    if (res != 0)
+    {
+        // the line is level triggered, leaving INT set would keep it asserted
+        tsl2591_write_cmd(self, TSL2591_CMD_INT_CLEAR);
+        event->transactions++;
+        return res;
+    }
+
+    return INSTR_SCOPE(_event_rearm(self, event, sample->ch0));
+}
+
+int tsl2591_event_stop(tsl2591_driver_t* self, tsl2591_event_t* event)
+{
+    event->transactions++;
+    return tsl2591_write_enable(self, (tsl2591_reg_enable_t){.power_on = 1, .als = 1});
+}
+
+uint32_t tsl2591_event_saved(const tsl2591_event_t* event)
+{
+    return (event->cycles > event->transactions) ? (event->cycles - event->transactions) : 0;
 }
 
 /* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static uint32_t _sensitivity(uint8_t gain, uint8_t integr_time)
+{
+    return (uint32_t)_gain_x2[gain] * ((uint32_t)integr_time + 1);
+}
+
+static int _event_rearm(tsl2591_driver_t* self, tsl2591_event_t* event, uint16_t level)
+{
+    uint32_t half = (uint32_t)level * event->window_pct / 100;
+    uint32_t high;
+    int res;
+
+    if (half < event->window_min)
+    {
+        half = event->window_min;
+    }
+
+    high = level + half;
+
+    res = tsl2591_write_int_threasholds(self,
+                                        (level > half) ? (uint16_t)(level - half) : 0,
+                                        (high > UINT16_MAX) ? UINT16_MAX : (uint16_t)high);
+    event->transactions++;
+    if (res != 0)
+    {
+        return res;
+    }
+
+    res = tsl2591_write_cmd(self, TSL2591_CMD_INT_CLEAR);
+    event->transactions++;
+
+    return res;
+}
+
+static int _io_read(tsl2591_driver_t* self, uint8_t reg, void* data, uint8_t size)
+{
+    if (self->transport != NULL)
+    {
+        return transport_reg_read(self->transport, TSL2591_CMD_NORMAL | reg, data, size);
+    }
+
+    return self->read(reg, data, size);
+}
+
+static int _io_write(tsl2591_driver_t* self, uint8_t reg, const void* data, uint8_t size)
+{
+    if (self->transport != NULL)
+    {
+        return transport_reg_write(self->transport, TSL2591_CMD_NORMAL | reg, data, size);
+    }
+
+    return self->write(reg, data, size);
+}
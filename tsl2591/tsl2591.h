@@ -3,11 +3,20 @@
 
 /* ===== INCLUDES =========================================================== */
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "regmap.h"
+#include "transport.h"
+
 /* ===== DEFINITIONS ======================================================== */
 
 #define TSL2591_I2C_ADDRESS 0x29
+#define TSL2591_DEVICE_ID   0x50
+
+//! Command byte prefix of a normal register access, added by the driver on a transport
+#define TSL2591_CMD_NORMAL 0xA0
 
 #define TSL2591_CHANNEL0_RESOLUTION_WHITE_WM2 3.786444e-5f
 #define TSL2591_CHANNEL0_RESOLUTION_850NM_WM2 3.883495e-5f
@@ -23,6 +32,33 @@
 #define TSL2591_CHANNEL1_GAIN_HIGH            400.0f
 #define TSL2591_CHANNEL1_GAIN_MAX             9900.0f
 
+#define TSL2591_MAX_COUNT_100MS (36863)
+#define TSL2591_MAX_COUNT       (65535)
+
+#define TSL2591_LUX_DF     (408.0f)
+#define TSL2591_LUX_COEF_B (1.64f)
+#define TSL2591_LUX_COEF_C (0.59f)
+#define TSL2591_LUX_COEF_D (0.86f)
+
+//! Returned by the lux calculations when a channel is saturated
+#define TSL2591_LUX_OVERFLOW     (-1.0f)
+#define TSL2591_LUX_OVERFLOW_MLX (UINT32_MAX)
+
+// register fields as "shift, width", see regmap.h
+#define TSL2591_ENABLE_PON    0, 1
+#define TSL2591_ENABLE_AEN    1, 1
+#define TSL2591_ENABLE_AIEN   4, 1
+#define TSL2591_ENABLE_SAI    6, 1
+#define TSL2591_ENABLE_NPIEN  7, 1
+#define TSL2591_CONFIG_ATIME  0, 3
+#define TSL2591_CONFIG_AGAIN  4, 2
+#define TSL2591_CONFIG_SRESET 7, 1
+#define TSL2591_PERSIST_APERS 0, 4
+#define TSL2591_PACKAGE_PID   4, 2
+#define TSL2591_STATUS_AVALID 0, 1
+#define TSL2591_STATUS_AINT   4, 1
+#define TSL2591_STATUS_NPINTR 5, 1
+
 /* ===== TYPES ============================================================== */
 
 typedef enum
@@ -47,13 +83,24 @@ typedef enum
     TSL2591_REG_CHANNEL1_DATA_H         = 0x17,
 } tsl2591_reg_t;
 
+//! Special function commands, sent as the register address with no payload
+typedef enum
+{
+    TSL2591_CMD_INT_FORCE     = 0xE4,
+    TSL2591_CMD_INT_CLEAR     = 0xE6,
+    TSL2591_CMD_INT_CLEAR_ALL = 0xE7,
+    TSL2591_CMD_NP_INT_CLEAR  = 0xEA,
+} tsl2591_cmd_t;
+
 typedef int (*tsl2591_read_t)(uint8_t reg, void* data, uint8_t size);
 typedef int (*tsl2591_write_t)(uint8_t reg, const void* data, uint8_t size);
 
 typedef struct
 {
     tsl2591_read_t read;
-    tsl2591_read_t write;
+    tsl2591_write_t write;
+
+    const transport_t* transport; //! used instead of read/write when set
 } tsl2591_driver_t;
 
 /* ===== GLOBALS AND EXTERNS ================================================ */
@@ -70,6 +117,13 @@ typedef struct
     uint8_t no_persist_int  : 1;
 } tsl2591_reg_enable_t;
 
+//! Raw access to size consecutive registers in one transaction
+int tsl2591_read_regs(tsl2591_driver_t* self, tsl2591_reg_t reg, void* data, uint8_t size);
+int tsl2591_write_regs(tsl2591_driver_t* self, tsl2591_reg_t reg, const void* data, uint8_t size);
+
+//! Writes the bits selected by mask from value with a single read and write, e.g. several REGMAP_VAL() fields
+int tsl2591_update_reg(tsl2591_driver_t* self, tsl2591_reg_t reg, uint8_t mask, uint8_t value);
+
 int tsl2591_read_enable(tsl2591_driver_t* self, tsl2591_reg_enable_t* value);
 int tsl2591_write_enable(tsl2591_driver_t* self, tsl2591_reg_enable_t value);
 
@@ -113,6 +167,9 @@ int tsl2591_write_np_int_low_threashold(tsl2591_driver_t* self, uint16_t value);
 int tsl2591_read_np_int_high_threashold(tsl2591_driver_t* self, uint16_t* value);
 int tsl2591_write_np_int_high_threashold(tsl2591_driver_t* self, uint16_t value);
 
+//! Writes both persist thresholds in a single transaction
+int tsl2591_write_int_threasholds(tsl2591_driver_t* self, uint16_t low, uint16_t high);
+
 typedef enum
 {
     TSL2591_REG_INT_PERS_FILTER_EVERY,
@@ -157,8 +214,105 @@ typedef struct
 } tsl2591_reg_status_t;
 
 int tsl2591_read_status(tsl2591_driver_t* self, tsl2591_reg_status_t* value);
+tsl2591_reg_status_t tsl2591_status_from_raw(uint8_t raw);
+
+int tsl2591_write_cmd(tsl2591_driver_t* self, tsl2591_cmd_t cmd);
 
 int tsl2591_read_channel0(tsl2591_driver_t* self, uint16_t* value);
 int tsl2591_read_channel1(tsl2591_driver_t* self, uint16_t* value);
 
+typedef struct
+{
+    uint16_t ch0;
+    uint16_t ch1;
+    tsl2591_reg_status_t status;
+} tsl2591_sample_t;
+
+//! Reads STATUS and both channels in a single transaction, returns 1 if the sample is not valid
+int tsl2591_read_sample(tsl2591_driver_t* self, tsl2591_sample_t* value);
+
+uint16_t tsl2591_calc_integr_time_ms(tsl2591_reg_config_t config);
+uint16_t tsl2591_calc_max_count(tsl2591_reg_config_t config);
+bool tsl2591_is_saturated(tsl2591_reg_config_t config, uint16_t ch0, uint16_t ch1);
+
+/*
+ * Lux is calculated as max(ch0 - B*ch1, C*ch0 - D*ch1) * DF / (atime_ms * again).
+ *
+ * The float and batch variants use single precision math, the integer variant uses
+ * precomputed Q24 coefficients and returns millilux. All of them agree within
+ * 5e-5 * lux + 0.01 count (0.01 * DF / (atime_ms * again) lx); the integer result
+ * may additionally be truncated by 1 mlx. The reserved integration times 6 and 7
+ * are taken as 600 ms here and in the other calc functions.
+ */
+float tsl2591_calc_lux(tsl2591_reg_config_t config, uint16_t ch0, uint16_t ch1);
+uint32_t tsl2591_calc_lux_mlx(tsl2591_reg_config_t config, uint16_t ch0, uint16_t ch1);
+void tsl2591_calc_lux_batch(tsl2591_reg_config_t config,
+                            const uint16_t* ch0,
+                            const uint16_t* ch1,
+                            float* lux,
+                            size_t count);
+
+//! White light irradiance in W/m2 seen by channel 0
+float tsl2591_calc_irradiance(tsl2591_reg_config_t config, uint16_t ch0);
+
+#define TSL2591_AUTORANGE_LOW_PCT    (10)
+#define TSL2591_AUTORANGE_HIGH_PCT   (80)
+#define TSL2591_AUTORANGE_TARGET_PCT (50)
+
+typedef struct
+{
+    tsl2591_reg_config_t config; //! setting currently written to the device
+    uint8_t max_integr_time;     //! \ref tsl2591_reg_config_integr_time_t
+    uint8_t low_pct;             //! sensitivity is raised below this share of full scale
+    uint8_t high_pct;            //! sensitivity is lowered above this share of full scale
+    uint8_t target_pct;          //! share of full scale the new setting aims at
+} tsl2591_autorange_t;
+
+void tsl2591_autorange_init(tsl2591_autorange_t* range,
+                            tsl2591_reg_config_t config,
+                            tsl2591_reg_config_integr_time_t max_integr_time);
+
+/*
+ * Jumps straight to the gain/integration time that brings the peak channel closest
+ * to the target share of full scale, so a transition takes one cycle (two when the
+ * sample was saturated). The config register is written only when the setting
+ * changes, *changed tells the caller to drop the sample of the cycle in flight.
+ */
+int tsl2591_autorange_update(tsl2591_driver_t* self,
+                             tsl2591_autorange_t* range,
+                             const tsl2591_sample_t* sample,
+                             bool* changed);
+
+#define TSL2591_EVENT_WINDOW_PCT (5)
+#define TSL2591_EVENT_WINDOW_MIN (16)
+
+typedef struct
+{
+    uint8_t window_pct;      //! half width of the window as a share of the last reading
+    uint16_t window_min;     //! minimal half width of the window in counts
+    uint16_t integr_time_ms;
+    uint32_t last_ms;
+    uint32_t cycles;         //! integration cycles elapsed, i.e. reads a polling loop would issue
+    uint32_t transactions;   //! transactions actually issued in event mode
+} tsl2591_event_t;
+
+/*
+ * Event mode keeps a threshold window around the last channel 0 reading and
+ * enables the persist interrupt, so the host only talks to the sensor when the
+ * level leaves the window. The config must match the one written to the device.
+ * The device does not have to be integrating yet: without a valid sample, start
+ * leaves sample->status.valid clear and arms a window the first sample leaves.
+ * A bus error is returned as is, with nothing armed.
+ */
+int tsl2591_event_start(tsl2591_driver_t* self,
+                        tsl2591_event_t* event,
+                        tsl2591_reg_config_t config,
+                        tsl2591_reg_int_pers_filter_t filter,
+                        uint32_t now_ms,
+                        tsl2591_sample_t* sample);
+//! Call from the INT handler context: reads the sample, re-centres the window and clears INT, also without a valid sample
+int tsl2591_event_irq(tsl2591_driver_t* self, tsl2591_event_t* event, uint32_t now_ms, tsl2591_sample_t* sample);
+int tsl2591_event_stop(tsl2591_driver_t* self, tsl2591_event_t* event);
+uint32_t tsl2591_event_saved(const tsl2591_event_t* event);
+
 #endif /* __TSL2591_H__ */
@@ -3,8 +3,16 @@
 
 #include "vcnl4000.h"
 
+#include <string.h>
+
+#include "instr.h"
+
 /* ===== DEFINITIONS ======================================================== */
 
+// transport calls are accounted to the calling function when built with DRIVERS_INSTR
+#define _read(self, reg, data, size)  INSTR_IO(_io_read(self, reg, data, size), size, 1, true)
+#define _write(self, reg, data, size) INSTR_IO(_io_write(self, reg, data, size), 0, 1 + (size), true)
+
 #define IS_BIG_ENDIAN   \
     (!(union {          \
           uint16_t u16; \
@@ -23,80 +31,557 @@
 
 /* ===== TYPES ============================================================== */
 /* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static int _io_read(vcnl4000_driver_t* self, uint8_t reg, void* data, uint8_t size);
+static int _io_write(vcnl4000_driver_t* self, uint8_t reg, const void* data, uint8_t size);
+
+static uint8_t _command_pack(vcnl4000_reg_command_t value);
+static vcnl4000_reg_command_t _command_unpack(uint8_t raw);
+static uint8_t _ir_current_pack(vcnl4000_reg_ir_current_t value);
+static vcnl4000_reg_ir_current_t _ir_current_unpack(uint8_t raw);
+static uint8_t _alight_param_pack(vcnl4000_reg_alight_param_t value);
+static vcnl4000_reg_alight_param_t _alight_param_unpack(uint8_t raw);
+static uint8_t _prox_modulator_pack(vcnl4000_reg_prox_modulator_t value);
+static vcnl4000_reg_prox_modulator_t _prox_modulator_unpack(uint8_t raw);
+
+static int _calib_eval(vcnl4000_driver_t* self,
+                       const vcnl4000_prox_calib_cfg_t* cfg,
+                       uint8_t current,
+                       vcnl4000_prox_calib_t* eval,
+                       bool* passed);
+static uint32_t _isqrt(uint64_t value);
 /* ===== GLOBALS AND EXTERNS ================================================ */
 /* ===== LOCAL VARIABLES ==================================================== */
 /* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
 
+int vcnl4000_read_regs(vcnl4000_driver_t* self, vcnl4000_reg_t reg, void* data, uint8_t size)
+{
+    return _read(self, reg, data, size);
+}
+
+int vcnl4000_write_regs(vcnl4000_driver_t* self, vcnl4000_reg_t reg, const void* data, uint8_t size)
+{
+    return _write(self, reg, data, size);
+}
+
+int vcnl4000_update_reg(vcnl4000_driver_t* self, vcnl4000_reg_t reg, uint8_t mask, uint8_t value)
+{
+    uint8_t raw;
+    int res;
+
+    res = _read(self, reg, &raw, 1);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    raw = REGMAP_UPDATE(raw, mask, value);
+
+    return _write(self, reg, &raw, 1);
+}
+
 int vcnl4000_read_command(vcnl4000_driver_t* self, vcnl4000_reg_command_t* value)
 {
-    return self->read(VCNL4000_REG_COMMAND, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, VCNL4000_REG_COMMAND, &raw, 1);
+    *value = _command_unpack(raw);
+
+    return res;
 }
 int vcnl4000_write_command(vcnl4000_driver_t* self, vcnl4000_reg_command_t value)
 {
-    return self->write(VCNL4000_REG_COMMAND, &value, 1);
+    uint8_t raw = _command_pack(value);
+
+    return _write(self, VCNL4000_REG_COMMAND, &raw, 1);
 }
 
 int vcnl4000_read_version(vcnl4000_driver_t* self, vcnl4000_reg_version_t* value)
 {
-    return self->read(VCNL4000_REG_VERSION, value, 1);
+    return _read(self, VCNL4000_REG_VERSION, &value->version, 1);
 }
 
 int vcnl4000_read_ir_current(vcnl4000_driver_t* self, vcnl4000_reg_ir_current_t* value)
 {
-    return self->read(VCNL4000_REG_IR_CURRENT, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, VCNL4000_REG_IR_CURRENT, &raw, 1);
+    *value = _ir_current_unpack(raw);
+
+    return res;
 }
 int vcnl4000_write_ir_current(vcnl4000_driver_t* self, vcnl4000_reg_ir_current_t value)
 {
-    return self->write(VCNL4000_REG_IR_CURRENT, &value, 1);
+    uint8_t raw = _ir_current_pack(value);
+
+    return _write(self, VCNL4000_REG_IR_CURRENT, &raw, 1);
 }
 
 int vcnl4000_read_alight_param(vcnl4000_driver_t* self, vcnl4000_reg_alight_param_t* value)
 {
-    return self->read(VCNL4000_REG_ALIGHT_PARAM, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, VCNL4000_REG_ALIGHT_PARAM, &raw, 1);
+    *value = _alight_param_unpack(raw);
+
+    return res;
 }
 int vcnl4000_write_alight_param(vcnl4000_driver_t* self, vcnl4000_reg_alight_param_t value)
 {
-    return self->write(VCNL4000_REG_ALIGHT_PARAM, &value, 1);
+    uint8_t raw = _alight_param_pack(value);
+
+    return _write(self, VCNL4000_REG_ALIGHT_PARAM, &raw, 1);
 }
 
 int vcnl4000_read_alight_value(vcnl4000_driver_t* self, uint16_t* value)
 {
     int res;
 
-    res = self->read(VCNL4000_REG_ALIGHT_RESULT_H, value, 2);
+    res = _read(self, VCNL4000_REG_ALIGHT_RESULT_H, value, 2);
 
     *value = FROM_BE16(*value);
 
-    return res
+    return res;
 }
 
 int vcnl4000_read_prox_value(vcnl4000_driver_t* self, uint16_t* value)
 {
     int res;
 
-    res = self->read(VCNL4000_REG_PROX_RESULT_H, value, 2);
+    res = _read(self, VCNL4000_REG_PROX_RESULT_H, value, 2);
 
     *value = FROM_BE16(*value);
 
-    return res
+    return res;
+}
+
+int vcnl4000_read_values(vcnl4000_driver_t* self, vcnl4000_values_t* value, bool with_command)
+{
+    uint8_t data[VCNL4000_REG_PROX_RESULT_L - VCNL4000_REG_COMMAND + 1];
+    uint8_t first = with_command ? VCNL4000_REG_COMMAND : VCNL4000_REG_ALIGHT_RESULT_H;
+    uint8_t* results;
+    int res;
+
+    res = _read(self, first, &data[first], sizeof(data) - first);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    results       = &data[VCNL4000_REG_ALIGHT_RESULT_H];
+    value->alight = ((uint16_t)results[0] << 8) | results[1];
+    value->prox   = ((uint16_t)results[2] << 8) | results[3];
+
+    if (with_command)
+    {
+        value->command = _command_unpack(data[VCNL4000_REG_COMMAND]);
+    }
+
+    return res;
 }
 
 int vcnl4000_read_prox_freq(vcnl4000_driver_t* self, vcnl4000_reg_prox_freq_t* value)
 {
-    return self->read(VCNL4000_REG_PROX_FREQ, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, VCNL4000_REG_PROX_FREQ, &raw, 1);
+    *value = (vcnl4000_reg_prox_freq_t)REGMAP_GET(raw, VCNL4000_PROX_FREQ_FREQ);
+
+    return res;
 }
 int vcnl4000_write_prox_freq(vcnl4000_driver_t* self, vcnl4000_reg_prox_freq_t value)
 {
-    return self->write(VCNL4000_REG_PROX_FREQ, &value, 1);
+    uint8_t raw = REGMAP_VAL(VCNL4000_PROX_FREQ_FREQ, value);
+
+    return _write(self, VCNL4000_REG_PROX_FREQ, &raw, 1);
 }
 
 int vcnl4000_read_prox_modulator(vcnl4000_driver_t* self, vcnl4000_reg_prox_modulator_t* value)
 {
-    return self->read(VCNL4000_REG_PROX_MOD, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, VCNL4000_REG_PROX_MODULATOR, &raw, 1);
+    *value = _prox_modulator_unpack(raw);
+
+    return res;
 }
 int vcnl4000_write_prox_modulator(vcnl4000_driver_t* self, vcnl4000_reg_prox_modulator_t value)
 {
-    return self->write(VCNL4000_REG_PROX_MOD, &value, 1);
+    uint8_t raw = _prox_modulator_pack(value);
+
+    return _write(self, VCNL4000_REG_PROX_MODULATOR, &raw, 1);
+}
+
+int vcnl4000_sched_init(vcnl4000_sched_t* sched,
+                        vcnl4000_driver_t* drivers,
+                        vcnl4000_values_t* values,
+                        uint8_t count,
+                        uint32_t bus_hz,
+                        vcnl4000_get_us_t get_us)
+{
+    if (count > VCNL4000_SCHED_MAX_SENSORS)
+    {
+        return 1;
+    }
+
+    memset(sched, 0, sizeof(*sched));
+
+    sched->drivers = drivers;
+    sched->values  = values;
+    sched->count   = count;
+    sched->command = (vcnl4000_reg_command_t){.prox_ondemand = 1, .alight_ondemand = 1};
+    sched->get_us  = get_us;
+
+    sched->max_polls = VCNL4000_SCHED_POLLS(VCNL4000_ALIGHT_CONVERSION_TIME, bus_hz) + count;
+
+    return 0;
+}
+
+int vcnl4000_sched_run_frame(vcnl4000_sched_t* sched)
+{
+    uint64_t pending = 0;
+    uint32_t polls   = 0;
+    uint32_t start   = sched->get_us();
+    int frame_res    = 0;
+    int res;
+
+    for (uint8_t i = 0; i < sched->count; i++)
+    {
+        res = vcnl4000_write_command(&sched->drivers[i], sched->command);
+        if (res == 0)
+        {
+            pending |= (uint64_t)1 << i;
+        }
+        else if (frame_res == 0)
+        {
+            frame_res = res;
+        }
+    }
+
+    while (pending != 0)
+    {
+        if (polls >= sched->max_polls)
+        {
+            sched->timeouts++;
+            frame_res = (frame_res != 0) ? frame_res : 1;
+            break;
+        }
+
+        for (uint8_t i = 0; i < sched->count; i++)
+        {
+            vcnl4000_reg_command_t cmd;
+
+            if ((pending & ((uint64_t)1 << i)) == 0)
+            {
+                continue;
+            }
+
+            polls++;
+            res = vcnl4000_read_command(&sched->drivers[i], &cmd);
+
+            if ((res == 0) && ((sched->command.prox_ondemand && !cmd.prox_ready)
+                               || (sched->command.alight_ondemand && !cmd.alight_ready)))
+            {
+                continue;
+            }
+
+            if (res == 0)
+            {
+                res = vcnl4000_read_values(&sched->drivers[i], &sched->values[i], false);
+                sched->values[i].command = cmd;
+            }
+
+            if ((res != 0) && (frame_res == 0))
+            {
+                frame_res = res;
+            }
+
+            pending &= ~((uint64_t)1 << i);
+        }
+    }
+
+    sched->frames++;
+    sched->polls += polls;
+    sched->elapsed_us += sched->get_us() - start;
+
+    return frame_res;
+}
+
+float vcnl4000_sched_fps(const vcnl4000_sched_t* sched)
+{
+    return (sched->elapsed_us != 0) ? (float)sched->frames * 1e6f / (float)sched->elapsed_us : 0.0f;
+}
+
+float vcnl4000_sched_polls_per_frame(const vcnl4000_sched_t* sched)
+{
+    return (sched->frames != 0) ? (float)sched->polls / (float)sched->frames : 0.0f;
+}
+
+int vcnl4000_measure_prox(vcnl4000_driver_t* self, uint16_t* value, uint16_t max_polls)
+{
+    vcnl4000_reg_command_t cmd;
+    int res;
+
+    res = vcnl4000_write_command(self, (vcnl4000_reg_command_t){.prox_ondemand = 1});
+    if (res != 0)
+    {
+        return res;
+    }
+
+    do
+    {
+        if (max_polls-- == 0)
+        {
+            return 1;
+        }
+
+        res = vcnl4000_read_command(self, &cmd);
+        if (res != 0)
+        {
+            return res;
+        }
+    } while (!cmd.prox_ready);
+
+    return vcnl4000_read_prox_value(self, value);
+}
+
+int vcnl4000_calibrate_prox(vcnl4000_driver_t* self, const vcnl4000_prox_calib_cfg_t* cfg, vcnl4000_prox_calib_t* result)
+{
+    if ((cfg->samples < 2) || (cfg->samples > VCNL4000_PROX_CALIB_MAX_SAMPLES) || (cfg->current_max == 0)
+        || (cfg->current_max > VCNL4000_PROX_CALIB_MAX_CURRENT))
+    {
+        return 1;
+    }
+
+    vcnl4000_reg_ir_current_t prev_current;
+    vcnl4000_reg_prox_freq_t prev_freq;
+    vcnl4000_prox_calib_t eval;
+    bool found = false;
+    int res;
+
+    res = vcnl4000_read_ir_current(self, &prev_current);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    res = vcnl4000_read_prox_freq(self, &prev_freq);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    result->samples_used = 0;
+
+    for (uint8_t freq = VCNL4000_REG_PROX_FREQ_MAX; (res == 0) && (freq <= VCNL4000_REG_PROX_FREQ_MIN); freq++)
+    {
+        uint8_t lo = 1;
+        uint8_t hi = found ? result->ir_current.value - 1 : cfg->current_max;
+
+        res = vcnl4000_write_prox_freq(self, freq);
+
+        // Lowest passing current of this frequency, SNR grows with the current
+        while ((res == 0) && (lo <= hi))
+        {
+            uint8_t mid = (uint8_t)((lo + hi) / 2);
+            bool passed;
+
+            res = _calib_eval(self, cfg, mid, &eval, &passed);
+            result->samples_used += cfg->samples;
+            if (res != 0)
+            {
+                break;
+            }
+
+            if (passed)
+            {
+                found                    = true;
+                result->ir_current.value = mid;
+                result->signal           = eval.signal;
+                result->noise            = eval.noise;
+                result->freq             = freq;
+                hi                       = mid - 1;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
+        }
+    }
+
+    // a failed or fruitless sweep must not leave the chip at a trial setting
+    if ((res != 0) || !found)
+    {
+        vcnl4000_write_prox_freq(self, prev_freq);
+        vcnl4000_write_ir_current(self, prev_current);
+        return (res != 0) ? res : 1;
+    }
+
+    res = vcnl4000_write_prox_freq(self, result->freq);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    return vcnl4000_write_ir_current(self, result->ir_current);
 }
 
 /* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static int _calib_eval(vcnl4000_driver_t* self,
+                       const vcnl4000_prox_calib_cfg_t* cfg,
+                       uint8_t current,
+                       vcnl4000_prox_calib_t* eval,
+                       bool* passed)
+{
+    uint32_t sum  = 0;
+    uint64_t sum2 = 0;
+    uint16_t value;
+    int res;
+
+    res = vcnl4000_write_ir_current(self, (vcnl4000_reg_ir_current_t){.value = current});
+    if (res != 0)
+    {
+        return res;
+    }
+
+    for (uint8_t i = 0; i < cfg->samples; i++)
+    {
+        res = vcnl4000_measure_prox(self, &value, VCNL4000_PROX_CALIB_MEASURE_POLLS);
+        if (res != 0)
+        {
+            return res;
+        }
+
+        sum += value;
+        sum2 += (uint32_t)value * value;
+    }
+
+    // signal^2 >= snr^2 * variance, scaled by samples^2 to stay in integers
+    uint64_t n       = cfg->samples;
+    int64_t signal_n = (int64_t)sum - (int64_t)(n * cfg->offset);
+    uint64_t var_n2  = n * sum2 - (uint64_t)sum * sum;
+
+    eval->signal = (signal_n > 0) ? (uint16_t)(signal_n / (int64_t)n) : 0;
+    eval->noise  = (uint16_t)(_isqrt(var_n2) / n);
+
+    *passed = (signal_n > 0) && ((uint64_t)(signal_n * signal_n) >= (uint64_t)cfg->snr_min * cfg->snr_min * var_n2);
+
+    return 0;
+}
+
+static uint32_t _isqrt(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit  = (uint64_t)1 << 62;
+
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+
+    while (bit != 0)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)root;
+}
+
+static int _io_read(vcnl4000_driver_t* self, uint8_t reg, void* data, uint8_t size)
+{
+    if (self->transport != NULL)
+    {
+        return transport_reg_read(self->transport, reg, data, size);
+    }
+
+    return self->read(reg, data, size);
+}
+
+static int _io_write(vcnl4000_driver_t* self, uint8_t reg, const void* data, uint8_t size)
+{
+    if (self->transport != NULL)
+    {
+        return transport_reg_write(self->transport, reg, data, size);
+    }
+
+    return self->write(reg, data, size);
+}
+
+static uint8_t _command_pack(vcnl4000_reg_command_t value)
+{
+    return REGMAP_VAL(VCNL4000_COMMAND_PROX_OD, value.prox_ondemand) |
+           REGMAP_VAL(VCNL4000_COMMAND_ALIGHT_OD, value.alight_ondemand) |
+           REGMAP_VAL(VCNL4000_COMMAND_PROX_READY, value.prox_ready) |
+           REGMAP_VAL(VCNL4000_COMMAND_ALIGHT_READY, value.alight_ready) |
+           REGMAP_VAL(VCNL4000_COMMAND_CONFIG_LOCK, value.config_lock);
+}
+
+static vcnl4000_reg_command_t _command_unpack(uint8_t raw)
+{
+    return (vcnl4000_reg_command_t){
+        .prox_ondemand   = REGMAP_GET(raw, VCNL4000_COMMAND_PROX_OD),
+        .alight_ondemand = REGMAP_GET(raw, VCNL4000_COMMAND_ALIGHT_OD),
+        .prox_ready      = REGMAP_GET(raw, VCNL4000_COMMAND_PROX_READY),
+        .alight_ready    = REGMAP_GET(raw, VCNL4000_COMMAND_ALIGHT_READY),
+        .config_lock     = REGMAP_GET(raw, VCNL4000_COMMAND_CONFIG_LOCK),
+    };
+}
+
+static uint8_t _ir_current_pack(vcnl4000_reg_ir_current_t value)
+{
+    return REGMAP_VAL(VCNL4000_IR_CURRENT_VALUE, value.value) |
+           REGMAP_VAL(VCNL4000_IR_CURRENT_FUSE, value.fuse);
+}
+
+static vcnl4000_reg_ir_current_t _ir_current_unpack(uint8_t raw)
+{
+    return (vcnl4000_reg_ir_current_t){
+        .value = REGMAP_GET(raw, VCNL4000_IR_CURRENT_VALUE),
+        .fuse  = REGMAP_GET(raw, VCNL4000_IR_CURRENT_FUSE),
+    };
+}
+
+static uint8_t _alight_param_pack(vcnl4000_reg_alight_param_t value)
+{
+    return REGMAP_VAL(VCNL4000_ALIGHT_PARAM_AVERAGE, value.average) |
+           REGMAP_VAL(VCNL4000_ALIGHT_PARAM_AUTO_OFFSET, value.auto_offset_comp) |
+           REGMAP_VAL(VCNL4000_ALIGHT_PARAM_CONTINUOUS, value.continuous);
+}
+
+static vcnl4000_reg_alight_param_t _alight_param_unpack(uint8_t raw)
+{
+    return (vcnl4000_reg_alight_param_t){
+        .average          = REGMAP_GET(raw, VCNL4000_ALIGHT_PARAM_AVERAGE),
+        .auto_offset_comp = REGMAP_GET(raw, VCNL4000_ALIGHT_PARAM_AUTO_OFFSET),
+        .continuous       = REGMAP_GET(raw, VCNL4000_ALIGHT_PARAM_CONTINUOUS),
+    };
+}
+
+static uint8_t _prox_modulator_pack(vcnl4000_reg_prox_modulator_t value)
+{
+    return REGMAP_VAL(VCNL4000_PROX_MODULATOR_DEAD_TIME, value.dead_time) |
+           REGMAP_VAL(VCNL4000_PROX_MODULATOR_DELAY_TIME, value.delay);
+}
+
+static vcnl4000_reg_prox_modulator_t _prox_modulator_unpack(uint8_t raw)
+{
+    return (vcnl4000_reg_prox_modulator_t){
+        .dead_time = REGMAP_GET(raw, VCNL4000_PROX_MODULATOR_DEAD_TIME),
+        .delay     = REGMAP_GET(raw, VCNL4000_PROX_MODULATOR_DELAY_TIME),
+    };
+}
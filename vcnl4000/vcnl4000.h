@@ -3,19 +3,41 @@
 
 /* ===== INCLUDES =========================================================== */
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include "regmap.h"
+#include "transport.h"
+
 /* ===== DEFINITIONS ======================================================== */
 
 #define VCNL4000_I2C_ADDRESS   (0x13)
 #define VCNL4000_I2C_MAX_SPEED (3400000)
 
-#define VCNL4000_PRODUCT_ID      (1)
-#define VCNL4000_CONVERSION_TIME (300.0e-6f)
+#define VCNL4000_PRODUCT_ID             (1)
+#define VCNL4000_CONVERSION_TIME        (300.0e-6f)
+#define VCNL4000_ALIGHT_CONVERSION_TIME (100.0e-3f) // on-demand ambient light measurement
 
 #define VCNL4000_ALIGHT_RESOLUTION_LX (0.25f)
 #define VCNL4000_ALIGHT_RAW2PHYS(raw) ((raw)*VCNL4000_ALIGHT_RESOLUTION_LX)
 
+// register fields as "shift, width", see regmap.h
+#define VCNL4000_COMMAND_PROX_OD           3, 1
+#define VCNL4000_COMMAND_ALIGHT_OD         4, 1
+#define VCNL4000_COMMAND_PROX_READY        5, 1
+#define VCNL4000_COMMAND_ALIGHT_READY      6, 1
+#define VCNL4000_COMMAND_CONFIG_LOCK       7, 1
+#define VCNL4000_VERSION_REVISION          0, 4
+#define VCNL4000_VERSION_PRODUCT           4, 4
+#define VCNL4000_IR_CURRENT_VALUE          0, 6
+#define VCNL4000_IR_CURRENT_FUSE           6, 2
+#define VCNL4000_ALIGHT_PARAM_AVERAGE      0, 3
+#define VCNL4000_ALIGHT_PARAM_AUTO_OFFSET  3, 1
+#define VCNL4000_ALIGHT_PARAM_CONTINUOUS   7, 1
+#define VCNL4000_PROX_FREQ_FREQ            0, 2
+#define VCNL4000_PROX_MODULATOR_DEAD_TIME  0, 3
+#define VCNL4000_PROX_MODULATOR_DELAY_TIME 5, 3
+
 /* ===== TYPES ============================================================== */
 
 typedef enum
@@ -39,11 +61,20 @@ typedef struct
 {
     vcnl4000_read_t read;
     vcnl4000_write_t write;
+
+    const transport_t* transport; //! used instead of read/write when set
 } vcnl4000_driver_t;
 
 /* ===== GLOBALS AND EXTERNS ================================================ */
 /* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
 
+//! Raw access to size consecutive registers in one transaction
+int vcnl4000_read_regs(vcnl4000_driver_t* self, vcnl4000_reg_t reg, void* data, uint8_t size);
+int vcnl4000_write_regs(vcnl4000_driver_t* self, vcnl4000_reg_t reg, const void* data, uint8_t size);
+
+//! Writes the bits selected by mask from value with a single read and write, e.g. several REGMAP_VAL() fields
+int vcnl4000_update_reg(vcnl4000_driver_t* self, vcnl4000_reg_t reg, uint8_t mask, uint8_t value);
+
 typedef struct
 {
     uint8_t                 : 3;
@@ -106,6 +137,16 @@ int vcnl4000_read_alight_value(vcnl4000_driver_t* self, uint16_t* value);
 
 int vcnl4000_read_prox_value(vcnl4000_driver_t* self, uint16_t* value);
 
+typedef struct
+{
+    uint16_t alight;
+    uint16_t prox;
+    vcnl4000_reg_command_t command; //! filled only when read together with the command register
+} vcnl4000_values_t;
+
+//! Reads both results (and optionally COMMAND with the ready flags) in a single transaction
+int vcnl4000_read_values(vcnl4000_driver_t* self, vcnl4000_values_t* value, bool with_command);
+
 typedef enum
 {
     VCNL4000_REG_PROX_FREQ_3p125MHz,
@@ -130,4 +171,81 @@ typedef struct
 int vcnl4000_read_prox_modulator(vcnl4000_driver_t* self, vcnl4000_reg_prox_modulator_t* value);
 int vcnl4000_write_prox_modulator(vcnl4000_driver_t* self, vcnl4000_reg_prox_modulator_t value);
 
+//! Triggers an on-demand proximity measurement and polls COMMAND until it is ready
+int vcnl4000_measure_prox(vcnl4000_driver_t* self, uint16_t* value, uint16_t max_polls);
+
+#define VCNL4000_PROX_CALIB_MAX_SAMPLES   (64)
+#define VCNL4000_PROX_CALIB_MAX_CURRENT   (20)
+#define VCNL4000_PROX_CALIB_MEASURE_POLLS (100)
+
+typedef struct
+{
+    uint16_t offset;     //! counts without a target, subtracted from the signal
+    uint8_t snr_min;     //! required ratio of mean signal to its standard deviation
+    uint8_t samples;     //! samples per tested setting, up to VCNL4000_PROX_CALIB_MAX_SAMPLES
+    uint8_t current_max; //! highest IR current tried, 10mA steps
+} vcnl4000_prox_calib_cfg_t;
+
+typedef struct
+{
+    vcnl4000_reg_ir_current_t ir_current;
+    vcnl4000_reg_prox_freq_t freq;
+    uint16_t signal;
+    uint16_t noise;
+    uint16_t samples_used;
+} vcnl4000_prox_calib_t;
+
+/*
+ * Finds the lowest IR current (over all modulation frequencies) whose proximity
+ * SNR at a reference target reaches cfg->snr_min. The current is binary searched
+ * and every next frequency only tries currents below the best one found so far.
+ * The chosen setting is written to the device and returned for the application
+ * to persist; when no setting qualifies the previous one is restored and 1 is
+ * returned.
+ */
+int vcnl4000_calibrate_prox(vcnl4000_driver_t* self, const vcnl4000_prox_calib_cfg_t* cfg, vcnl4000_prox_calib_t* result);
+
+#define VCNL4000_SCHED_MAX_SENSORS (64)
+#define VCNL4000_SCHED_POLL_BITS   (40) //! one ready poll: START, address, register, Sr, address, data, STOP
+
+//! Ready polls that span twice a conversion of conv_s seconds on a bus clocked at bus_hz
+#define VCNL4000_SCHED_POLLS(conv_s, bus_hz) ((uint32_t)(2.0f * (conv_s) * (float)(bus_hz) / VCNL4000_SCHED_POLL_BITS))
+
+typedef uint32_t (*vcnl4000_get_us_t)(void);
+
+/*
+ * Overlaps on-demand measurements of many sensors: a frame fires the command on
+ * every sensor first and then services them in whatever order they become ready.
+ */
+typedef struct
+{
+    vcnl4000_driver_t* drivers;
+    vcnl4000_values_t* values;
+    uint8_t count;
+    vcnl4000_reg_command_t command; //! measurements to trigger, both by default
+    uint32_t max_polls;             //! ready polls allowed per frame, see vcnl4000_sched_init()
+    vcnl4000_get_us_t get_us;
+
+    uint32_t frames;
+    uint32_t polls;
+    uint32_t timeouts;
+    uint64_t elapsed_us;
+} vcnl4000_sched_t;
+
+/*
+ * The polls of a frame run back to back on the bus, so the default max_polls is
+ * VCNL4000_SCHED_POLLS() of the ambient light conversion at bus_hz plus one round
+ * over the sensors. Recompute it the same way after narrowing the command to the
+ * proximity measurement.
+ */
+int vcnl4000_sched_init(vcnl4000_sched_t* sched,
+                        vcnl4000_driver_t* drivers,
+                        vcnl4000_values_t* values,
+                        uint8_t count,
+                        uint32_t bus_hz,
+                        vcnl4000_get_us_t get_us);
+int vcnl4000_sched_run_frame(vcnl4000_sched_t* sched);
+float vcnl4000_sched_fps(const vcnl4000_sched_t* sched);
+float vcnl4000_sched_polls_per_frame(const vcnl4000_sched_t* sched);
+
 #endif /* __VCNL4000_H__ */
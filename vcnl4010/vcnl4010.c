@@ -3,8 +3,14 @@
 
 #include "vcnl4010.h"
 
+#include "instr.h"
+
 /* ===== DEFINITIONS ======================================================== */
 
+// transport calls are accounted to the calling function when built with DRIVERS_INSTR
+#define _read(self, reg, data, size)  INSTR_IO(_io_read(self, reg, data, size), size, 1, true)
+#define _write(self, reg, data, size) INSTR_IO(_io_write(self, reg, data, size), 0, 1 + (size), true)
+
 #define IS_BIG_ENDIAN   \
     (!(union {          \
           uint16_t u16; \
@@ -23,91 +29,207 @@
 
 /* ===== TYPES ============================================================== */
 /* ===== LOCAL FUNCTIONS PROTOTYPES ========================================= */
+
+static int _io_read(vcnl4010_driver_t* self, uint8_t reg, void* data, uint8_t size);
+static int _io_write(vcnl4010_driver_t* self, uint8_t reg, const void* data, uint8_t size);
+
+static uint8_t _command_pack(vcnl4010_reg_command_t value);
+static vcnl4010_reg_command_t _command_unpack(uint8_t raw);
+static uint8_t _ir_current_pack(vcnl4010_reg_ir_current_t value);
+static vcnl4010_reg_ir_current_t _ir_current_unpack(uint8_t raw);
+static uint8_t _alight_param_pack(vcnl4010_reg_alight_param_t value);
+static vcnl4010_reg_alight_param_t _alight_param_unpack(uint8_t raw);
+static uint8_t _int_ctrl_pack(vcnl4010_reg_int_ctrl_t value);
+static vcnl4010_reg_int_ctrl_t _int_ctrl_unpack(uint8_t raw);
+static uint8_t _int_status_pack(vcnl4010_reg_int_status_t value);
+static vcnl4010_reg_int_status_t _int_status_unpack(uint8_t raw);
+static uint8_t _prox_modulator_pack(vcnl4010_reg_prox_modulator_t value);
+static vcnl4010_reg_prox_modulator_t _prox_modulator_unpack(uint8_t raw);
+
+static int _calib_eval(vcnl4010_driver_t* self,
+                       const vcnl4010_prox_calib_cfg_t* cfg,
+                       uint8_t current,
+                       vcnl4010_prox_calib_t* eval,
+                       bool* passed);
+static uint32_t _isqrt(uint64_t value);
+
+static int _prox_det_rearm(vcnl4010_driver_t* self, vcnl4010_prox_det_t* det);
 /* ===== GLOBALS AND EXTERNS ================================================ */
 /* ===== LOCAL VARIABLES ==================================================== */
 /* ===== GLOBAL FUNCTIONS IMPLEMENTATION ==================================== */
 
+int vcnl4010_read_regs(vcnl4010_driver_t* self, vcnl4010_reg_t reg, void* data, uint8_t size)
+{
+    return _read(self, reg, data, size);
+}
+
+int vcnl4010_write_regs(vcnl4010_driver_t* self, vcnl4010_reg_t reg, const void* data, uint8_t size)
+{
+    return _write(self, reg, data, size);
+}
+
+int vcnl4010_update_reg(vcnl4010_driver_t* self, vcnl4010_reg_t reg, uint8_t mask, uint8_t value)
+{
+    uint8_t raw;
+    int res;
+
+    res = _read(self, reg, &raw, 1);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    raw = REGMAP_UPDATE(raw, mask, value);
+
+    return _write(self, reg, &raw, 1);
+}
+
 int vcnl4010_read_command(vcnl4010_driver_t* self, vcnl4010_reg_command_t* value)
 {
-    return self->read(VCNL4010_REG_COMMAND, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, VCNL4010_REG_COMMAND, &raw, 1);
+    *value = _command_unpack(raw);
+
+    return res;
 }
 int vcnl4010_write_command(vcnl4010_driver_t* self, vcnl4010_reg_command_t value)
 {
-    return self->write(VCNL4010_REG_COMMAND, &value, 1);
+    uint8_t raw = _command_pack(value);
+
+    return _write(self, VCNL4010_REG_COMMAND, &raw, 1);
 }
 
 int vcnl4010_read_version(vcnl4010_driver_t* self, vcnl4010_reg_version_t* value)
 {
-    return self->read(VCNL4010_REG_VERSION, value, 1);
+    return _read(self, VCNL4010_REG_VERSION, &value->version, 1);
 }
 
 int vcnl4010_read_prox_rate(vcnl4010_driver_t* self, vcnl4010_reg_prox_rate_t* value)
 {
-    return self->read(VCNL4010_REG_PROX_RATE, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, VCNL4010_REG_PROX_RATE, &raw, 1);
+    *value = (vcnl4010_reg_prox_rate_t)REGMAP_GET(raw, VCNL4010_PROX_RATE_RATE);
+
+    return res;
 }
 int vcnl4010_write_prox_rate(vcnl4010_driver_t* self, vcnl4010_reg_prox_rate_t value)
 {
-    return self->write(VCNL4010_REG_PROX_RATE, &value, 1);
+    uint8_t raw = REGMAP_VAL(VCNL4010_PROX_RATE_RATE, value);
+
+    return _write(self, VCNL4010_REG_PROX_RATE, &raw, 1);
 }
 
 int vcnl4010_read_ir_current(vcnl4010_driver_t* self, vcnl4010_reg_ir_current_t* value)
 {
-    return self->read(VCNL4010_REG_IR_CURRENT, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, VCNL4010_REG_IR_CURRENT, &raw, 1);
+    *value = _ir_current_unpack(raw);
+
+    return res;
 }
 int vcnl4010_write_ir_current(vcnl4010_driver_t* self, vcnl4010_reg_ir_current_t value)
 {
-    return self->write(VCNL4010_REG_IR_CURRENT, &value, 1);
+    uint8_t raw = _ir_current_pack(value);
+
+    return _write(self, VCNL4010_REG_IR_CURRENT, &raw, 1);
 }
 
 int vcnl4010_read_alight_param(vcnl4010_driver_t* self, vcnl4010_reg_alight_param_t* value)
 {
-    return self->read(VCNL4010_REG_ALIGHT_PARAM, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, VCNL4010_REG_ALIGHT_PARAM, &raw, 1);
+    *value = _alight_param_unpack(raw);
+
+    return res;
 }
 int vcnl4010_write_alight_param(vcnl4010_driver_t* self, vcnl4010_reg_alight_param_t value)
 {
-    return self->write(VCNL4010_REG_ALIGHT_PARAM, &value, 1);
+    uint8_t raw = _alight_param_pack(value);
+
+    return _write(self, VCNL4010_REG_ALIGHT_PARAM, &raw, 1);
 }
 
 int vcnl4010_read_alight_value(vcnl4010_driver_t* self, uint16_t* value)
 {
     int res;
 
-    res = self->read(VCNL4010_REG_ALIGHT_RESULT_H, value, 2);
+    res = _read(self, VCNL4010_REG_ALIGHT_RESULT_H, value, 2);
 
     *value = FROM_BE16(*value);
 
-    return res
+    return res;
 }
 
 int vcnl4010_read_prox_value(vcnl4010_driver_t* self, uint16_t* value)
 {
     int res;
 
-    res = self->read(VCNL4010_REG_PROX_RESULT_H, value, 2);
+    res = _read(self, VCNL4010_REG_PROX_RESULT_H, value, 2);
 
     *value = FROM_BE16(*value);
 
-    return res
+    return res;
+}
+
+int vcnl4010_read_values(vcnl4010_driver_t* self, vcnl4010_values_t* value, bool with_command)
+{
+    uint8_t data[VCNL4010_REG_PROX_RESULT_L - VCNL4010_REG_COMMAND + 1];
+    uint8_t first = with_command ? VCNL4010_REG_COMMAND : VCNL4010_REG_ALIGHT_RESULT_H;
+    uint8_t* results;
+    int res;
+
+    res = _read(self, first, &data[first], sizeof(data) - first);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    results       = &data[VCNL4010_REG_ALIGHT_RESULT_H];
+    value->alight = ((uint16_t)results[0] << 8) | results[1];
+    value->prox   = ((uint16_t)results[2] << 8) | results[3];
+
+    if (with_command)
+    {
+        value->command = _command_unpack(data[VCNL4010_REG_COMMAND]);
+    }
+
+    return res;
 }
 
 int vcnl4010_read_int_ctrl(vcnl4010_driver_t* self, vcnl4010_reg_int_ctrl_t* value)
 {
-    return self->read(VCNL4010_REG_INT_CTRL, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, VCNL4010_REG_INT_CTRL, &raw, 1);
+    *value = _int_ctrl_unpack(raw);
+
+    return res;
 }
 int vcnl4010_write_int_ctrl(vcnl4010_driver_t* self, vcnl4010_reg_int_ctrl_t value)
 {
-    return self->write(VCNL4010_REG_INT_CTRL, &value, 1);
+    uint8_t raw = _int_ctrl_pack(value);
+
+    return _write(self, VCNL4010_REG_INT_CTRL, &raw, 1);
 }
 
 int vcnl4010_read_low_threashold(vcnl4010_driver_t* self, uint16_t* value)
 {
     int res;
 
-    res = self->read(VCNL4010_REG_LOW_THRSH_H, value, 2);
+    res = _read(self, VCNL4010_REG_LOW_THRSH_H, value, 2);
 
     *value = FROM_BE16(*value);
 
-    return res
+    return res;
 }
 int vcnl4010_write_low_threashold(vcnl4010_driver_t* self, uint16_t value)
 {
@@ -115,20 +237,20 @@ int vcnl4010_write_low_threashold(vcnl4010_driver_t* self, uint16_t value)
 
     value = FROM_BE16(value);
 
-    res = self->write(VCNL4010_REG_LOW_THRSH_H, &value, 2);
+    res = _write(self, VCNL4010_REG_LOW_THRSH_H, &value, 2);
 
-    return res
+    return res;
 }
 
 int vcnl4010_read_high_threashold(vcnl4010_driver_t* self, uint16_t* value)
 {
     int res;
 
-    res = self->read(VCNL4010_REG_HIGH_THRSH_H, value, 2);
+    res = _read(self, VCNL4010_REG_HIGH_THRSH_H, value, 2);
 
     *value = FROM_BE16(*value);
 
-    return res
+    return res;
 }
 int vcnl4010_write_high_threashold(vcnl4010_driver_t* self, uint16_t value)
 {
@@ -136,27 +258,641 @@ int vcnl4010_write_high_threashold(vcnl4010_driver_t* self, uint16_t value)
 
     value = FROM_BE16(value);
 
-    res = self->write(VCNL4010_REG_HIGH_THRSH_H, &value, 2);
+    res = _write(self, VCNL4010_REG_HIGH_THRSH_H, &value, 2);
 
-    return res
+    return res;
+}
+
+int vcnl4010_write_threasholds(vcnl4010_driver_t* self, uint16_t low, uint16_t high)
+{
+    uint8_t data[] = {
+        (uint8_t)(low >> 8),
+        (uint8_t)low,
+        (uint8_t)(high >> 8),
+        (uint8_t)high,
+    };
+
+    return _write(self, VCNL4010_REG_LOW_THRSH_H, data, sizeof(data));
 }
 
 int vcnl4010_read_int_status(vcnl4010_driver_t* self, vcnl4010_reg_int_status_t* value)
 {
-    return self->read(VCNL4010_REG_INT_STATUS, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, VCNL4010_REG_INT_STATUS, &raw, 1);
+    *value = _int_status_unpack(raw);
+
+    return res;
 }
 int vcnl4010_write_int_status(vcnl4010_driver_t* self, vcnl4010_reg_int_status_t value)
 {
-    return self->write(VCNL4010_REG_INT_STATUS, &value, 1);
+    uint8_t raw = _int_status_pack(value);
+
+    return _write(self, VCNL4010_REG_INT_STATUS, &raw, 1);
 }
 
 int vcnl4010_read_prox_modulator(vcnl4010_driver_t* self, vcnl4010_reg_prox_modulator_t* value)
 {
-    return self->read(VCNL4010_REG_PROX_MODULATOR, value, 1);
+    uint8_t raw;
+    int res;
+
+    res    = _read(self, VCNL4010_REG_PROX_MODULATOR, &raw, 1);
+    *value = _prox_modulator_unpack(raw);
+
+    return res;
 }
 int vcnl4010_write_prox_modulator(vcnl4010_driver_t* self, vcnl4010_reg_prox_modulator_t value)
 {
-    return self->write(VCNL4010_REG_PROX_MODULATOR, &value, 1);
+    uint8_t raw = _prox_modulator_pack(value);
+
+    return _write(self, VCNL4010_REG_PROX_MODULATOR, &raw, 1);
+}
+
+int vcnl4010_stream_start(vcnl4010_driver_t* self,
+                          vcnl4010_stream_t* stream,
+                          vcnl4010_stream_sample_t* buffer,
+                          uint16_t capacity,
+                          vcnl4010_reg_prox_rate_t rate)
+{
+    int res;
+
+    if ((capacity == 0) || (capacity > 32768) || ((capacity & (capacity - 1)) != 0))
+    {
+        return 1;
+    }
+
+    stream->buffer = buffer;
+    stream->mask   = capacity - 1;
+    atomic_init(&stream->head, 0);
+    atomic_init(&stream->tail, 0);
+    atomic_init(&stream->dropped, 0);
+
+    // Rate can only be changed while self-timed measurement is disabled
+    res = vcnl4010_write_command(self, (vcnl4010_reg_command_t){0});
+    if (res != 0)
+    {
+        return res;
+    }
+
+    res = vcnl4010_write_prox_rate(self, rate);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    res = vcnl4010_write_int_ctrl(self, (vcnl4010_reg_int_ctrl_t){.prox_ready_en = 1});
+    if (res != 0)
+    {
+        return res;
+    }
+
+    res = vcnl4010_write_int_status(self, (vcnl4010_reg_int_status_t){
+                                              .threshold_high = 1,
+                                              .threshold_low  = 1,
+                                              .alight_ready   = 1,
+                                              .prox_ready     = 1,
+                                          });
+    if (res != 0)
+    {
+        return res;
+    }
+
+    return vcnl4010_write_command(self, (vcnl4010_reg_command_t){.self_timed_en = 1, .prox_en = 1});
+}
+
+int vcnl4010_stream_stop(vcnl4010_driver_t* self, vcnl4010_stream_t* stream)
+{
+    int res;
+
+    (void)stream;
+
+    res = vcnl4010_write_command(self, (vcnl4010_reg_command_t){0});
+    if (res != 0)
+    {
+        return res;
+    }
+
+    return vcnl4010_write_int_ctrl(self, (vcnl4010_reg_int_ctrl_t){0});
+}
+
+int vcnl4010_stream_irq(vcnl4010_driver_t* self, vcnl4010_stream_t* stream, uint32_t timestamp)
+{
+    uint16_t prox;
+    int res;
+    int ack;
+
+    res = vcnl4010_read_prox_value(self, &prox);
+
+    // Acknowledge even on a failed read, otherwise INT stays asserted
+    ack = vcnl4010_write_int_status(self, (vcnl4010_reg_int_status_t){.prox_ready = 1});
+
+    if (res != 0)
+    {
+        return res;
+    }
+
+    uint16_t head = atomic_load_explicit(&stream->head, memory_order_relaxed);
+    uint16_t tail = atomic_load_explicit(&stream->tail, memory_order_acquire);
+
+    if ((uint16_t)(head - tail) > stream->mask)
+    {
+        atomic_fetch_add_explicit(&stream->dropped, 1, memory_order_relaxed);
+        return ack;
+    }
+
+    stream->buffer[head & stream->mask] = (vcnl4010_stream_sample_t){
+        .timestamp = timestamp,
+        .prox      = prox,
+    };
+    atomic_store_explicit(&stream->head, (uint16_t)(head + 1), memory_order_release);
+
+    return ack;
+}
+
+bool vcnl4010_stream_pop(vcnl4010_stream_t* stream, vcnl4010_stream_sample_t* sample)
+{
+    uint16_t tail = atomic_load_explicit(&stream->tail, memory_order_relaxed);
+    uint16_t head = atomic_load_explicit(&stream->head, memory_order_acquire);
+
+    if (head == tail)
+    {
+        return false;
+    }
+
+    *sample = stream->buffer[tail & stream->mask];
+    atomic_store_explicit(&stream->tail, (uint16_t)(tail + 1), memory_order_release);
+
+    return true;
+}
+
+uint16_t vcnl4010_stream_count(vcnl4010_stream_t* stream)
+{
+    uint16_t head = atomic_load_explicit(&stream->head, memory_order_acquire);
+    uint16_t tail = atomic_load_explicit(&stream->tail, memory_order_acquire);
+
+    return (uint16_t)(head - tail);
+}
+
+uint32_t vcnl4010_stream_dropped(vcnl4010_stream_t* stream)
+{
+    return atomic_load_explicit(&stream->dropped, memory_order_relaxed);
+}
+
+void vcnl4010_prox_det_init(vcnl4010_prox_det_t* det, uint16_t baseline, uint16_t enter_delta, uint16_t leave_delta)
+{
+    det->baseline_q8 = (uint32_t)baseline << 8;
+    det->enter_delta = enter_delta;
+    det->leave_delta = leave_delta;
+    det->drift_delta = enter_delta / 2;
+    det->adapt_shift = VCNL4010_PROX_DET_ADAPT_SHIFT;
+    det->present     = false;
+}
+
+int vcnl4010_prox_det_start(vcnl4010_driver_t* self,
+                            vcnl4010_prox_det_t* det,
+                            vcnl4010_reg_prox_rate_t rate,
+                            vcnl4010_reg_int_ctrl_count_exceed_t count_exceed)
+{
+    int res;
+
+    res = vcnl4010_write_command(self, (vcnl4010_reg_command_t){0});
+    if (res != 0)
+    {
+        return res;
+    }
+
+    res = vcnl4010_write_prox_rate(self, rate);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    res = INSTR_SCOPE(_prox_det_rearm(self, det));
+    if (res != 0)
+    {
+        return res;
+    }
+
+    res = vcnl4010_write_int_ctrl(self, (vcnl4010_reg_int_ctrl_t){
+                                            .threshold_sel = VCNL4010_REG_INT_CTRL_THRSH_SEL_PROX,
+                                            .threshold_en  = 1,
+                                            .count_exceed  = count_exceed,
+                                        });
+    if (res != 0)
+    {
+        return res;
+    }
+
+    res = vcnl4010_write_int_status(self, (vcnl4010_reg_int_status_t){.threshold_high = 1, .threshold_low = 1});
+    if (res != 0)
+    {
+        return res;
+    }
+
+    return vcnl4010_write_command(self, (vcnl4010_reg_command_t){.self_timed_en = 1, .prox_en = 1});
+}
+
+int vcnl4010_prox_det_stop(vcnl4010_driver_t* self, vcnl4010_prox_det_t* det)
+{
+    (void)det;
+
+    return vcnl4010_stream_stop(self, NULL);
+}
+
+int vcnl4010_prox_det_irq(vcnl4010_driver_t* self,
+                          vcnl4010_prox_det_t* det,
+                          uint32_t timestamp,
+                          vcnl4010_prox_event_t* event)
+{
+    vcnl4010_reg_int_status_t status;
+    uint16_t prox;
+    int res;
+
+    event->type      = VCNL4010_PROX_EVENT_NONE;
+    event->timestamp = timestamp;
+
+    res = vcnl4010_read_int_status(self, &status);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    res = vcnl4010_write_int_status(self, status);
+    if ((res != 0) || (!status.threshold_high && !status.threshold_low))
+    {
+        return res;
+    }
+
+    res = vcnl4010_read_prox_value(self, &prox);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    event->prox = prox;
+
+    if (!det->present && status.threshold_high && (prox >= vcnl4010_prox_det_baseline(det) + det->enter_delta))
+    {
+        det->present = true;
+        event->type  = VCNL4010_PROX_EVENT_ENTER;
+    }
+    else if (!det->present || status.threshold_low)
+    {
+        if (det->present)
+        {
+            det->present = false;
+            event->type  = VCNL4010_PROX_EVENT_LEAVE;
+        }
+
+        // a reading that left the drift window on either side re-centres it
+        int32_t diff = ((int32_t)prox << 8) - (int32_t)det->baseline_q8;
+        det->baseline_q8 += diff / (1 << det->adapt_shift);
+    }
+
+    return INSTR_SCOPE(_prox_det_rearm(self, det));
+}
+
+uint16_t vcnl4010_prox_det_baseline(const vcnl4010_prox_det_t* det)
+{
+    return (uint16_t)(det->baseline_q8 >> 8);
+}
+
+int vcnl4010_measure_prox(vcnl4010_driver_t* self, uint16_t* value, uint16_t max_polls)
+{
+    vcnl4010_reg_command_t cmd;
+    int res;
+
+    res = vcnl4010_write_command(self, (vcnl4010_reg_command_t){.prox_ondemand = 1});
+    if (res != 0)
+    {
+        return res;
+    }
+
+    do
+    {
+        if (max_polls-- == 0)
+        {
+            return 1;
+        }
+
+        res = vcnl4010_read_command(self, &cmd);
+        if (res != 0)
+        {
+            return res;
+        }
+    } while (!cmd.prox_ready);
+
+    return vcnl4010_read_prox_value(self, value);
+}
+
+int vcnl4010_calibrate_prox(vcnl4010_driver_t* self, const vcnl4010_prox_calib_cfg_t* cfg, vcnl4010_prox_calib_t* result)
+{
+    if ((cfg->samples < 2) || (cfg->samples > VCNL4010_PROX_CALIB_MAX_SAMPLES) || (cfg->current_max == 0)
+        || (cfg->current_max > VCNL4010_PROX_CALIB_MAX_CURRENT))
+    {
+        return 1;
+    }
+
+    vcnl4010_reg_ir_current_t prev_current;
+    vcnl4010_reg_prox_modulator_t prev_modulator;
+    vcnl4010_reg_prox_modulator_t modulator;
+    vcnl4010_prox_calib_t eval;
+    bool found = false;
+    int res;
+
+    res = vcnl4010_read_ir_current(self, &prev_current);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    res = vcnl4010_read_prox_modulator(self, &prev_modulator);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    result->samples_used = 0;
+    modulator            = prev_modulator;
+
+    for (uint8_t freq = VCNL4010_REG_PROX_MODULATOR_FREQ_MIN;
+         (res == 0) && (freq <= VCNL4010_REG_PROX_MODULATOR_FREQ_MAX);
+         freq++)
+    {
+        uint8_t lo = 1;
+        uint8_t hi = found ? result->ir_current.value - 1 : cfg->current_max;
+
+        modulator.freq = freq;
+        res            = vcnl4010_write_prox_modulator(self, modulator);
+
+        // Lowest passing current of this frequency, SNR grows with the current
+        while ((res == 0) && (lo <= hi))
+        {
+            uint8_t mid = (uint8_t)((lo + hi) / 2);
+            bool passed;
+
+            res = _calib_eval(self, cfg, mid, &eval, &passed);
+            result->samples_used += cfg->samples;
+            if (res != 0)
+            {
+                break;
+            }
+
+            if (passed)
+            {
+                found                    = true;
+                result->ir_current.value = mid;
+                result->signal           = eval.signal;
+                result->noise            = eval.noise;
+                result->modulator        = modulator;
+                hi                       = mid - 1;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
+        }
+    }
+
+    // a failed or fruitless sweep must not leave the chip at a trial setting
+    if ((res != 0) || !found)
+    {
+        vcnl4010_write_prox_modulator(self, prev_modulator);
+        vcnl4010_write_ir_current(self, prev_current);
+        return (res != 0) ? res : 1;
+    }
+
+    res = vcnl4010_write_prox_modulator(self, result->modulator);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    return vcnl4010_write_ir_current(self, result->ir_current);
 }
 
 /* ===== LOCAL FUNCTIONS IMPLEMENTATION ===================================== */
+
+static int _prox_det_rearm(vcnl4010_driver_t* self, vcnl4010_prox_det_t* det)
+{
+    uint32_t baseline = det->baseline_q8 >> 8;
+    uint32_t low;
+    uint32_t high;
+
+    if (det->present)
+    {
+        low  = baseline + det->leave_delta;
+        high = UINT16_MAX;
+    }
+    else
+    {
+        low  = (baseline > det->drift_delta) ? baseline - det->drift_delta : 0;
+        high = baseline + ((det->drift_delta < det->enter_delta) ? det->drift_delta : det->enter_delta);
+    }
+
+    return vcnl4010_write_threasholds(self,
+                                      (low > UINT16_MAX) ? UINT16_MAX : (uint16_t)low,
+                                      (high > UINT16_MAX) ? UINT16_MAX : (uint16_t)high);
+}
+
+static int _calib_eval(vcnl4010_driver_t* self,
+                       const vcnl4010_prox_calib_cfg_t* cfg,
+                       uint8_t current,
+                       vcnl4010_prox_calib_t* eval,
+                       bool* passed)
+{
+    uint32_t sum  = 0;
+    uint64_t sum2 = 0;
+    uint16_t value;
+    int res;
+
+    res = vcnl4010_write_ir_current(self, (vcnl4010_reg_ir_current_t){.value = current});
+    if (res != 0)
+    {
+        return res;
+    }
+
+    for (uint8_t i = 0; i < cfg->samples; i++)
+    {
+        res = vcnl4010_measure_prox(self, &value, VCNL4010_PROX_CALIB_MEASURE_POLLS);
+        if (res != 0)
+        {
+            return res;
+        }
+
+        sum += value;
+        sum2 += (uint32_t)value * value;
+    }
+
+    // signal^2 >= snr^2 * variance, scaled by samples^2 to stay in integers
+    uint64_t n       = cfg->samples;
+    int64_t signal_n = (int64_t)sum - (int64_t)(n * cfg->offset);
+    uint64_t var_n2  = n * sum2 - (uint64_t)sum * sum;
+
+    eval->signal = (signal_n > 0) ? (uint16_t)(signal_n / (int64_t)n) : 0;
+    eval->noise  = (uint16_t)(_isqrt(var_n2) / n);
+
+    *passed = (signal_n > 0) && ((uint64_t)(signal_n * signal_n) >= (uint64_t)cfg->snr_min * cfg->snr_min * var_n2);
+
+    return 0;
+}
+
+static uint32_t _isqrt(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit  = (uint64_t)1 << 62;
+
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+
+    while (bit != 0)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)root;
+}
+
+static int _io_read(vcnl4010_driver_t* self, uint8_t reg, void* data, uint8_t size)
+{
+    if (self->transport != NULL)
+    {
+        return transport_reg_read(self->transport, reg, data, size);
+    }
+
+    return self->read(reg, data, size);
+}
+
+static int _io_write(vcnl4010_driver_t* self, uint8_t reg, const void* data, uint8_t size)
+{
+    if (self->transport != NULL)
+    {
+        return transport_reg_write(self->transport, reg, data, size);
+    }
+
+    return self->write(reg, data, size);
+}
+
+static uint8_t _command_pack(vcnl4010_reg_command_t value)
+{
+    return REGMAP_VAL(VCNL4010_COMMAND_SELF_TIMED_EN, value.self_timed_en) |
+           REGMAP_VAL(VCNL4010_COMMAND_PROX_EN, value.prox_en) |
+           REGMAP_VAL(VCNL4010_COMMAND_ALIGHT_EN, value.alight_en) |
+           REGMAP_VAL(VCNL4010_COMMAND_PROX_OD, value.prox_ondemand) |
+           REGMAP_VAL(VCNL4010_COMMAND_ALIGHT_OD, value.alight_ondemand) |
+           REGMAP_VAL(VCNL4010_COMMAND_PROX_READY, value.prox_ready) |
+           REGMAP_VAL(VCNL4010_COMMAND_ALIGHT_READY, value.alight_ready) |
+           REGMAP_VAL(VCNL4010_COMMAND_CONFIG_LOCK, value.config_lock);
+}
+
+static vcnl4010_reg_command_t _command_unpack(uint8_t raw)
+{
+    return (vcnl4010_reg_command_t){
+        .self_timed_en   = REGMAP_GET(raw, VCNL4010_COMMAND_SELF_TIMED_EN),
+        .prox_en         = REGMAP_GET(raw, VCNL4010_COMMAND_PROX_EN),
+        .alight_en       = REGMAP_GET(raw, VCNL4010_COMMAND_ALIGHT_EN),
+        .prox_ondemand   = REGMAP_GET(raw, VCNL4010_COMMAND_PROX_OD),
+        .alight_ondemand = REGMAP_GET(raw, VCNL4010_COMMAND_ALIGHT_OD),
+        .prox_ready      = REGMAP_GET(raw, VCNL4010_COMMAND_PROX_READY),
+        .alight_ready    = REGMAP_GET(raw, VCNL4010_COMMAND_ALIGHT_READY),
+        .config_lock     = REGMAP_GET(raw, VCNL4010_COMMAND_CONFIG_LOCK),
+    };
+}
+
+static uint8_t _ir_current_pack(vcnl4010_reg_ir_current_t value)
+{
+    return REGMAP_VAL(VCNL4010_IR_CURRENT_VALUE, value.value) |
+           REGMAP_VAL(VCNL4010_IR_CURRENT_FUSE, value.fuse);
+}
+
+static vcnl4010_reg_ir_current_t _ir_current_unpack(uint8_t raw)
+{
+    return (vcnl4010_reg_ir_current_t){
+        .value = REGMAP_GET(raw, VCNL4010_IR_CURRENT_VALUE),
+        .fuse  = REGMAP_GET(raw, VCNL4010_IR_CURRENT_FUSE),
+    };
+}
+
+static uint8_t _alight_param_pack(vcnl4010_reg_alight_param_t value)
+{
+    return REGMAP_VAL(VCNL4010_ALIGHT_PARAM_AVERAGE, value.average) |
+           REGMAP_VAL(VCNL4010_ALIGHT_PARAM_AUTO_OFFSET, value.auto_offset_comp) |
+           REGMAP_VAL(VCNL4010_ALIGHT_PARAM_RATE, value.rate) |
+           REGMAP_VAL(VCNL4010_ALIGHT_PARAM_CONTINUOUS, value.continuous);
+}
+
+static vcnl4010_reg_alight_param_t _alight_param_unpack(uint8_t raw)
+{
+    return (vcnl4010_reg_alight_param_t){
+        .average          = REGMAP_GET(raw, VCNL4010_ALIGHT_PARAM_AVERAGE),
+        .auto_offset_comp = REGMAP_GET(raw, VCNL4010_ALIGHT_PARAM_AUTO_OFFSET),
+        .rate             = REGMAP_GET(raw, VCNL4010_ALIGHT_PARAM_RATE),
+        .continuous       = REGMAP_GET(raw, VCNL4010_ALIGHT_PARAM_CONTINUOUS),
+    };
+}
+
+static uint8_t _int_ctrl_pack(vcnl4010_reg_int_ctrl_t value)
+{
+    return REGMAP_VAL(VCNL4010_INT_CTRL_THRSH_SEL, value.threshold_sel) |
+           REGMAP_VAL(VCNL4010_INT_CTRL_THRSH_EN, value.threshold_en) |
+           REGMAP_VAL(VCNL4010_INT_CTRL_ALIGHT_READY_EN, value.alight_ready_en) |
+           REGMAP_VAL(VCNL4010_INT_CTRL_PROX_READY_EN, value.prox_ready_en) |
+           REGMAP_VAL(VCNL4010_INT_CTRL_COUNT_EXCEED, value.count_exceed);
+}
+
+static vcnl4010_reg_int_ctrl_t _int_ctrl_unpack(uint8_t raw)
+{
+    return (vcnl4010_reg_int_ctrl_t){
+        .threshold_sel   = REGMAP_GET(raw, VCNL4010_INT_CTRL_THRSH_SEL),
+        .threshold_en    = REGMAP_GET(raw, VCNL4010_INT_CTRL_THRSH_EN),
+        .alight_ready_en = REGMAP_GET(raw, VCNL4010_INT_CTRL_ALIGHT_READY_EN),
+        .prox_ready_en   = REGMAP_GET(raw, VCNL4010_INT_CTRL_PROX_READY_EN),
+        .count_exceed    = REGMAP_GET(raw, VCNL4010_INT_CTRL_COUNT_EXCEED),
+    };
+}
+
+static uint8_t _int_status_pack(vcnl4010_reg_int_status_t value)
+{
+    return REGMAP_VAL(VCNL4010_INT_STATUS_THRSH_HIGH, value.threshold_high) |
+           REGMAP_VAL(VCNL4010_INT_STATUS_THRSH_LOW, value.threshold_low) |
+           REGMAP_VAL(VCNL4010_INT_STATUS_ALIGHT_READY, value.alight_ready) |
+           REGMAP_VAL(VCNL4010_INT_STATUS_PROX_READY, value.prox_ready);
+}
+
+static vcnl4010_reg_int_status_t _int_status_unpack(uint8_t raw)
+{
+    return (vcnl4010_reg_int_status_t){
+        .threshold_high = REGMAP_GET(raw, VCNL4010_INT_STATUS_THRSH_HIGH),
+        .threshold_low  = REGMAP_GET(raw, VCNL4010_INT_STATUS_THRSH_LOW),
+        .alight_ready   = REGMAP_GET(raw, VCNL4010_INT_STATUS_ALIGHT_READY),
+        .prox_ready     = REGMAP_GET(raw, VCNL4010_INT_STATUS_PROX_READY),
+    };
+}
+
+static uint8_t _prox_modulator_pack(vcnl4010_reg_prox_modulator_t value)
+{
+    return REGMAP_VAL(VCNL4010_PROX_MODULATOR_DEAD_TIME, value.dead_time) |
+           REGMAP_VAL(VCNL4010_PROX_MODULATOR_FREQ, value.freq) |
+           REGMAP_VAL(VCNL4010_PROX_MODULATOR_DELAY_TIME, value.delay_time);
+}
+
+static vcnl4010_reg_prox_modulator_t _prox_modulator_unpack(uint8_t raw)
+{
+    return (vcnl4010_reg_prox_modulator_t){
+        .dead_time  = REGMAP_GET(raw, VCNL4010_PROX_MODULATOR_DEAD_TIME),
+        .freq       = REGMAP_GET(raw, VCNL4010_PROX_MODULATOR_FREQ),
+        .delay_time = REGMAP_GET(raw, VCNL4010_PROX_MODULATOR_DELAY_TIME),
+    };
+}
@@ -3,19 +3,56 @@
 
 /* ===== INCLUDES =========================================================== */
 
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdint.h>
 
+#include "regmap.h"
+#include "transport.h"
+
 /* ===== DEFINITIONS ======================================================== */
 
 #define VCNL4010_I2C_ADDRESS   (0x13)
 #define VCNL4010_I2C_MAX_SPEED (3400000)
 
-#define VCNL4010_PRODUCT_ID      (2)
-#define VCNL4010_CONVERSION_TIME (300.0e-6f)
+#define VCNL4010_PRODUCT_ID             (2)
+#define VCNL4010_CONVERSION_TIME        (300.0e-6f)
+#define VCNL4010_ALIGHT_CONVERSION_TIME (100.0e-3f) // on-demand ambient light measurement
 
 #define VCNL4010_ALIGHT_RESOLUTION_LX (0.25f)
 #define VCNL4010_ALIGHT_RAW2PHYS(raw) ((raw)*VCNL4010_ALIGHT_RESOLUTION_LX)
 
+// register fields as "shift, width", see regmap.h
+#define VCNL4010_COMMAND_SELF_TIMED_EN     0, 1
+#define VCNL4010_COMMAND_PROX_EN           1, 1
+#define VCNL4010_COMMAND_ALIGHT_EN         2, 1
+#define VCNL4010_COMMAND_PROX_OD           3, 1
+#define VCNL4010_COMMAND_ALIGHT_OD         4, 1
+#define VCNL4010_COMMAND_PROX_READY        5, 1
+#define VCNL4010_COMMAND_ALIGHT_READY      6, 1
+#define VCNL4010_COMMAND_CONFIG_LOCK       7, 1
+#define VCNL4010_VERSION_REVISION          0, 4
+#define VCNL4010_VERSION_PRODUCT           4, 4
+#define VCNL4010_PROX_RATE_RATE            0, 3
+#define VCNL4010_IR_CURRENT_VALUE          0, 6
+#define VCNL4010_IR_CURRENT_FUSE           6, 2
+#define VCNL4010_ALIGHT_PARAM_AVERAGE      0, 3
+#define VCNL4010_ALIGHT_PARAM_AUTO_OFFSET  3, 1
+#define VCNL4010_ALIGHT_PARAM_RATE         4, 3
+#define VCNL4010_ALIGHT_PARAM_CONTINUOUS   7, 1
+#define VCNL4010_INT_CTRL_THRSH_SEL        0, 1
+#define VCNL4010_INT_CTRL_THRSH_EN         1, 1
+#define VCNL4010_INT_CTRL_ALIGHT_READY_EN  2, 1
+#define VCNL4010_INT_CTRL_PROX_READY_EN    3, 1
+#define VCNL4010_INT_CTRL_COUNT_EXCEED     5, 3
+#define VCNL4010_INT_STATUS_THRSH_HIGH     0, 1
+#define VCNL4010_INT_STATUS_THRSH_LOW      1, 1
+#define VCNL4010_INT_STATUS_ALIGHT_READY   2, 1
+#define VCNL4010_INT_STATUS_PROX_READY     3, 1
+#define VCNL4010_PROX_MODULATOR_DEAD_TIME  0, 3
+#define VCNL4010_PROX_MODULATOR_FREQ       3, 2
+#define VCNL4010_PROX_MODULATOR_DELAY_TIME 5, 3
+
 /* ===== TYPES ============================================================== */
 
 typedef enum
@@ -45,11 +82,20 @@ typedef struct
 {
     vcnl4010_read_t read;
     vcnl4010_write_t write;
+
+    const transport_t* transport; //! used instead of read/write when set
 } vcnl4010_driver_t;
 
 /* ===== GLOBALS AND EXTERNS ================================================ */
 /* ===== GLOBAL FUNCTIONS PROTOTYPES ======================================== */
 
+//! Raw access to size consecutive registers in one transaction
+int vcnl4010_read_regs(vcnl4010_driver_t* self, vcnl4010_reg_t reg, void* data, uint8_t size);
+int vcnl4010_write_regs(vcnl4010_driver_t* self, vcnl4010_reg_t reg, const void* data, uint8_t size);
+
+//! Writes the bits selected by mask from value with a single read and write, e.g. several REGMAP_VAL() fields
+int vcnl4010_update_reg(vcnl4010_driver_t* self, vcnl4010_reg_t reg, uint8_t mask, uint8_t value);
+
 typedef struct
 {
     uint8_t self_timed_en   : 1;
@@ -141,6 +187,16 @@ int vcnl4010_read_alight_value(vcnl4010_driver_t* self, uint16_t* value);
 
 int vcnl4010_read_prox_value(vcnl4010_driver_t* self, uint16_t* value);
 
+typedef struct
+{
+    uint16_t alight;
+    uint16_t prox;
+    vcnl4010_reg_command_t command; //! filled only when read together with the command register
+} vcnl4010_values_t;
+
+//! Reads both results (and optionally COMMAND with the ready flags) in a single transaction
+int vcnl4010_read_values(vcnl4010_driver_t* self, vcnl4010_values_t* value, bool with_command);
+
 typedef enum
 {
     VCNL4010_REG_INT_CTRL_THRSH_SEL_PROX,
@@ -178,6 +234,9 @@ int vcnl4010_write_low_threashold(vcnl4010_driver_t* self, uint16_t value);
 int vcnl4010_read_high_threashold(vcnl4010_driver_t* self, uint16_t* value);
 int vcnl4010_write_high_threashold(vcnl4010_driver_t* self, uint16_t value);
 
+//! Writes both thresholds in a single transaction
+int vcnl4010_write_threasholds(vcnl4010_driver_t* self, uint16_t low, uint16_t high);
+
 typedef struct
 {
     uint8_t threshold_high : 1;
@@ -211,4 +270,117 @@ typedef struct
 int vcnl4010_read_prox_modulator(vcnl4010_driver_t* self, vcnl4010_reg_prox_modulator_t* value);
 int vcnl4010_write_prox_modulator(vcnl4010_driver_t* self, vcnl4010_reg_prox_modulator_t value);
 
+typedef struct
+{
+    uint32_t timestamp;
+    uint16_t prox;
+} vcnl4010_stream_sample_t;
+
+/*
+ * Single producer / single consumer ring: vcnl4010_stream_irq() is the producer
+ * and runs in the INT handler, vcnl4010_stream_pop() is the consumer.
+ */
+typedef struct
+{
+    vcnl4010_stream_sample_t* buffer;
+    uint16_t mask;
+    atomic_uint_least16_t head;
+    atomic_uint_least16_t tail;
+    atomic_uint_least32_t dropped;
+} vcnl4010_stream_t;
+
+//! Capacity must be a power of two not greater than 32768
+int vcnl4010_stream_start(vcnl4010_driver_t* self,
+                          vcnl4010_stream_t* stream,
+                          vcnl4010_stream_sample_t* buffer,
+                          uint16_t capacity,
+                          vcnl4010_reg_prox_rate_t rate);
+int vcnl4010_stream_stop(vcnl4010_driver_t* self, vcnl4010_stream_t* stream);
+int vcnl4010_stream_irq(vcnl4010_driver_t* self, vcnl4010_stream_t* stream, uint32_t timestamp);
+bool vcnl4010_stream_pop(vcnl4010_stream_t* stream, vcnl4010_stream_sample_t* sample);
+uint16_t vcnl4010_stream_count(vcnl4010_stream_t* stream);
+uint32_t vcnl4010_stream_dropped(vcnl4010_stream_t* stream);
+
+//! Triggers an on-demand proximity measurement and polls COMMAND until it is ready
+int vcnl4010_measure_prox(vcnl4010_driver_t* self, uint16_t* value, uint16_t max_polls);
+
+#define VCNL4010_PROX_CALIB_MAX_SAMPLES   (64)
+#define VCNL4010_PROX_CALIB_MAX_CURRENT   (20)
+#define VCNL4010_PROX_CALIB_MEASURE_POLLS (100)
+
+typedef struct
+{
+    uint16_t offset;     //! counts without a target, subtracted from the signal
+    uint8_t snr_min;     //! required ratio of mean signal to its standard deviation
+    uint8_t samples;     //! samples per tested setting, up to VCNL4010_PROX_CALIB_MAX_SAMPLES
+    uint8_t current_max; //! highest IR current tried, 10mA steps
+} vcnl4010_prox_calib_cfg_t;
+
+typedef struct
+{
+    vcnl4010_reg_ir_current_t ir_current;
+    vcnl4010_reg_prox_modulator_t modulator;
+    uint16_t signal;
+    uint16_t noise;
+    uint16_t samples_used;
+} vcnl4010_prox_calib_t;
+
+/*
+ * Finds the lowest IR current (over all modulation frequencies) whose proximity
+ * SNR at a reference target reaches cfg->snr_min. The current is binary searched
+ * and every next frequency only tries currents below the best one found so far.
+ * The chosen setting is written to the device and returned for the application
+ * to persist; when no setting qualifies the previous one is restored and 1 is
+ * returned.
+ */
+int vcnl4010_calibrate_prox(vcnl4010_driver_t* self, const vcnl4010_prox_calib_cfg_t* cfg, vcnl4010_prox_calib_t* result);
+
+#define VCNL4010_PROX_DET_ADAPT_SHIFT (3)
+
+typedef enum
+{
+    VCNL4010_PROX_EVENT_NONE,
+    VCNL4010_PROX_EVENT_ENTER,
+    VCNL4010_PROX_EVENT_LEAVE,
+} vcnl4010_prox_event_type_t;
+
+typedef struct
+{
+    vcnl4010_prox_event_type_t type;
+    uint32_t timestamp;
+    uint16_t prox;
+} vcnl4010_prox_event_t;
+
+/*
+ * Proximity presence detector running on the threshold interrupt. While nothing
+ * is in front of the sensor the window is [baseline - drift_delta, baseline +
+ * drift_delta]: a reading at or above baseline + enter_delta is an ENTER, any
+ * other reading outside the window pulls the baseline slowly towards it, so both
+ * falling and rising drift (ambient light, a dirty cover) are followed. While an
+ * object is present the window is [baseline + leave_delta, max]. Debouncing is
+ * done by the count_exceed filter of the chip.
+ */
+typedef struct
+{
+    uint32_t baseline_q8;
+    uint16_t enter_delta;
+    uint16_t leave_delta; //! lower than enter_delta, the difference is the hysteresis
+    uint16_t drift_delta; //! enter_delta / 2 by default, at most enter_delta
+    uint8_t adapt_shift;  //! baseline follows readings with weight 2^-adapt_shift
+    bool present;
+} vcnl4010_prox_det_t;
+
+void vcnl4010_prox_det_init(vcnl4010_prox_det_t* det, uint16_t baseline, uint16_t enter_delta, uint16_t leave_delta);
+int vcnl4010_prox_det_start(vcnl4010_driver_t* self,
+                            vcnl4010_prox_det_t* det,
+                            vcnl4010_reg_prox_rate_t rate,
+                            vcnl4010_reg_int_ctrl_count_exceed_t count_exceed);
+int vcnl4010_prox_det_stop(vcnl4010_driver_t* self, vcnl4010_prox_det_t* det);
+//! Call from the INT handler context, event->type is NONE when nothing changed
+int vcnl4010_prox_det_irq(vcnl4010_driver_t* self,
+                          vcnl4010_prox_det_t* det,
+                          uint32_t timestamp,
+                          vcnl4010_prox_event_t* event);
+uint16_t vcnl4010_prox_det_baseline(const vcnl4010_prox_det_t* det);
+
 #endif /* __VCNL4010_H__ */